@@ -3,6 +3,18 @@
 #include "../util/util.h"
 #include "asset_storage.h"
 #include "model_importer.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "vertex_packing.h"
+#include "texture_decoder.h"
+#include "texture_cache.h"
+#include "texture_cooker.h"
+#include "texture_compressor.h"
+#include "prepared_asset.h"
+#include "asset_streamer.h"
+
+#include <span>
+#include <limits>
 
 struct MeshStorageBackData
 {
@@ -23,22 +35,44 @@ class AssetManager
 {
 private:
 	AssetStorage _storage;
-	ModelImporter _importer;
+	MeshCache _meshCache;
+	MeshOptimizer _meshOptimizer;
+	VertexPackingSettings _vertexPackingSettings;
 
 	inline static AssetManager* s_Instance;
 
 	using AssetID = u32;
 	using MaterialID = u32;
+	using TextureID = u32; // bindless index of the texture
 	AssetID _currentAvailableIndex{ 1 }; // 0 is reserved
 	MaterialID _availableMaterialIndex{ 1 };
 
 	std::unordered_map<MaterialID, MaterialDescription> _materialDescription;
 
-	std::vector<std::pair<u32, std::unique_ptr<Image>>> _textures;
+	std::vector<std::pair<u32, std::unique_ptr<Image>>> _textures; // released slots keep nullptr until they're reused
+	std::vector<TextureID> _freeTextureSlots;
+	TextureCache _textureCache;
+	TextureCooker _textureCooker;
 
-	fs::path ConvertToPath(const fs::path& folder);
-	fs::path FindGLTFByPath(const fs::path& path);
-	void ConvertMaterialsPathToAbsolute(const fs::path& modelFolderName, LoadedGLTF& loadedGLTF);
+	GeometryResidency _defaultResidency{ GeometryResidency::RESIDENCY_KEEP };
+	std::unordered_map<AssetID, fs::path> _meshSources; // to reload the dropped geometry from the cooked mesh
+	std::unordered_map<AssetID, std::vector<TextureID>> _meshTextures; // references held by the mesh materials, released with the mesh
+
+	AssetStreamer _streamer{ *this }; // the last one, its worker uses everything above
+
+	TextureID StoreTexture(std::unique_ptr<Image> image);
+
+	static fs::path FindProjectRoot();
+	fs::path ConvertToPath(const fs::path& folder) const;
+	fs::path FindGLTFByPath(const fs::path& path) const;
+	void ConvertMaterialsPathToAbsolute(const fs::path& modelFolderName, std::vector<MeshMaterial>& materials) const;
+
+	// Purpose: texturepreparation::Prepare over all the material textures. Thread safe if knownTextures isn't changed meanwhile
+	PreparedTextures PrepareTextures(const std::vector<MeshMaterial>& materials, const TextureCache* knownTextures) const;
+	// Purpose: images for the prepared textures which aren't in the cache yet. Every material texture adds a reference,
+	// it's appended to textureReferences
+	std::vector<MaterialTexturesDesc> CreateMaterials(const ImageManager& imageManager, const std::vector<MeshMaterial>& materials,
+		PreparedTextures& preparedTextures, std::vector<TextureID>& textureReferences);
 public:
 
 	static void Initialize();
@@ -53,17 +87,45 @@ public:
 	static AssetManager* Get() { return s_Instance; }
 
 	const auto& GetAllTextures() const { return _textures; }
+	AssetStreamer& GetStreamer() { return _streamer; }
 
 	size_t GetAllSceneSize();
 
 	const std::vector<SubmeshDescription>* GetAssetSubmeshes(AssetID id) const;
-
-	const std::vector<MaterialTexturesDesc>& GetAllSceneMaterialsDesc() const;
+	const ModelHierarchy* GetAssetHierarchy(AssetID id) const { return _storage.GetAssetHierarchy(id); }
+	const MeshBounds* GetAssetBounds(AssetID id) const { return _storage.GetAssetBounds(id); }
+
+	// Purpose: drop the CPU copy of the mesh and its materials, the freed storage is reused by the next loads.
+	// Material textures lose the mesh references, the ones nothing else uses are destroyed
+	void RemoveMesh(AssetID id);
+
+	void SetDefaultResidency(GeometryResidency policy) { _defaultResidency = policy; }
+	GeometryResidency GetDefaultResidency() const { return _defaultResidency; }
+	const AssetResidency* GetAssetResidency(AssetID id) const { return _storage.GetAssetResidency(id); }
+	// Purpose: the mesh is on the GPU, its CPU geometry is kept or dropped by the policy(the global one if it isn't set)
+	void OnMeshUploaded(AssetID id, u64 gpuBytes, std::optional<GeometryResidency> policy);
+	// Purpose: submeshes with the CPU geometry, it's mapped from the cooked mesh again if the policy allows. nullptr if it's gone
+	const std::vector<SubmeshDescription>* AcquireGeometry(AssetID id);
+	// Purpose: done with the geometry of AcquireGeometry, it's dropped again unless the asset keeps it
+	void ReleaseGeometry(AssetID id);
 
 	/**
 	* @brief Write models FOLDER to load the file from it. There's should be files only for one model
 	*/
 	std::optional<MeshStorageBackData> TryToLoadAndStoreMesh(const fs::path& folder, ImageManager* imageManager = nullptr);
-	MaterialTexturesDesc TryToLoadMaterial(const ImageManager& imageManager, const MeshMaterial& material);
+	/**
+	* @brief CPU side of TryToLoadAndStoreMesh: import or cooked mesh, textures ready for the upload. Doesn't change the manager,
+	* so it runs on the streaming worker. Pass the texture cache only from the thread which owns it
+	*/
+	std::optional<PreparedMesh> PrepareMesh(const fs::path& folder, bool withTextures, const TextureCache* knownTextures = nullptr) const;
+	// Purpose: render thread side, the mesh is stored and its images are created
+	MeshStorageBackData StorePreparedMesh(PreparedMesh& preparedMesh, ImageManager* imageManager);
+	// Purpose: PrepareTextures and CreateMaterials at once, the caller releases textureReferences with ReleaseTexture
+	std::vector<MaterialTexturesDesc> TryToLoadMaterials(const ImageManager& imageManager, const std::vector<MeshMaterial>& materials,
+		std::vector<TextureID>& textureReferences);
+	// Purpose: textureIDs are in the order of the material textures, 0 if the texture isn't loaded
+	MaterialTexturesDesc TryToLoadMaterial(const MeshMaterial& material, std::span<const u32> textureIDs);
+	// Purpose: drop one reference, the image is destroyed with the last one
+	void ReleaseTexture(TextureID textureID);
 	MaterialID StoreLoadedMaterials(const std::vector<MaterialTexturesDesc>& materialsDesc);
 };
\ No newline at end of file
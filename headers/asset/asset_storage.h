@@ -2,6 +2,8 @@
 #include "../util/util.h"
 #include "../scene/component.h"
 #include "asset_types.h"
+#include "mesh_cache.h"
+#include "../util/chunked_arena.h"
 
 #include <glm/glm.hpp>
 
@@ -26,28 +28,75 @@ struct UnloadedMaterialsDataProps
 	bool shouldUpdatePtrs{ false };
 };
 
+// Purpose: where the asset geometry lives and how much of it, to see what the residency policy saves
+struct AssetResidency
+{
+	GeometryResidency policy{ GeometryResidency::RESIDENCY_KEEP };
+	u64 cpuBytes{ 0 };
+	u64 gpuBytes{ 0 };
+	bool isCpuResident{ true };
+};
+
 class AssetStorage
 {
 private:
-	std::vector<Vertex> _allVertexStorage;
-	std::vector<u32> _allIndicesStorage;
+	// Purpose: where the submesh data lives in the arenas, to give it back when the asset is removed
+	struct SubmeshRanges
+	{
+		ArenaRange vertices;
+		ArenaRange indices;
+		ArenaRange meshlets;
+		ArenaRange meshletVertices;
+		ArenaRange meshletTriangles;
+		ArenaRange lods;
+	};
+
+	// Arenas never move the stored data, so submesh pointers are set once when the asset is stored
+	ChunkedArena<Vertex> _vertexArena;
+	ChunkedArena<u32> _indicesArena;
+
+	ChunkedArena<Meshlet> _meshletsArena;
+	ChunkedArena<u32> _meshletVerticesArena;
+	ChunkedArena<u8> _meshletTrianglesArena;
+
+	ChunkedArena<MeshLod> _lodsArena;
 
 	std::vector<MeshMaterial> _allUnloadedMaterialsStorage; // storage to handle materials paths/data to load
-	std::vector<MaterialTexturesDesc> _allCreatedMaterialsStorage; // storage to handle textures inside of materials
+	ChunkedArena<MaterialTexturesDesc> _materialsArena; // storage to handle textures inside of materials
 	
 	using AssetID = u32;
 	using MaterialsAssetID = u32;
 	using ElementsBefore = u32;
 	std::map<AssetID, std::vector<SubmeshDescription>> _submeshesDesc;
-	void UpdateGeometryPropsStorage();
-	void UpdateMaterialPropsStorage();
+	std::map<AssetID, std::vector<SubmeshRanges>> _geometryRanges; // assets copied into the arenas
+	std::map<MaterialsAssetID, std::vector<ArenaRange>> _materialRanges;
+	std::map<AssetID, std::unique_ptr<MappedFile>> _mappedGeometry; // cooked assets, their submeshes point into the mapping
+	std::map<AssetID, AssetResidency> _residency;
+	std::map<AssetID, ModelHierarchy> _hierarchies;
+	std::map<AssetID, MeshBounds> _bounds; // model space, all the submeshes placed by the hierarchy
+	void FreeGeometryRanges(AssetID assetID);
 public:	
-	const std::vector<MaterialTexturesDesc>& GetAllSceneMaterials() const { return _allCreatedMaterialsStorage; }
-	size_t GetRawDataSize() const { return _allVertexStorage.size(); }
+	size_t GetRawDataSize() const { return _vertexArena.GetSize(); }
 	void StoreVertex(const LoadedGLTF& loadedGltf, AssetID assetID);
+	// Purpose: store the cooked mesh without copying, the storage keeps the mapping alive
+	void StoreCookedVertex(CookedMesh& cookedMesh, AssetID assetID);
+	// Purpose: point the dropped asset geometry into the cooked mesh again, materials stay as they are.
+	// Returns false if the cooked mesh doesn't match the stored one anymore
+	bool RestoreCookedVertex(CookedMesh& cookedMesh, AssetID assetID);
+	// Purpose: free the CPU copy of the geometry. Submeshes keep counts, bounds and LODs, their geometry pointers are nullptr
+	void DropGeometry(AssetID assetID);
 	void StoreMeshMaterials(const std::vector<MaterialTexturesDesc>& materialsDesc, MaterialsAssetID assetID);
+	// Purpose: drop the asset with the materials stored under the same ID, its arena ranges are reused by the next stores.
+	// Pointers to the other assets stay valid
+	void RemoveAsset(AssetID assetID);
 
 	const std::vector<SubmeshDescription>* GetAssetSubmeshes(AssetID id) const;
+	const ModelHierarchy* GetAssetHierarchy(AssetID id) const;
+	const MeshBounds* GetAssetBounds(AssetID id) const;
+
+	void SetAssetResidencyPolicy(AssetID id, GeometryResidency policy) { _residency[id].policy = policy; }
+	void SetAssetGpuBytes(AssetID id, u64 gpuBytes) { _residency[id].gpuBytes = gpuBytes; }
+	const AssetResidency* GetAssetResidency(AssetID id) const;
 
 	const std::vector<MeshMaterial>& GetAllSceneMaterialsData() const { return _allUnloadedMaterialsStorage; }
 };
\ No newline at end of file
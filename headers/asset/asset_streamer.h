@@ -0,0 +1,63 @@
+#pragma once
+#include "../util/util.h"
+#include "prepared_asset.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <glm/glm.hpp>
+
+// Purpose: model prepared in the background, waits until the render thread takes it
+struct StreamedMesh
+{
+	u64 requestID{ 0 };
+	glm::vec3 position{ glm::vec3(0.0f) };
+	std::optional<PreparedMesh> preparedMesh; // nullopt if the model couldn't be loaded
+
+	u64 GetUploadBytes() const { return preparedMesh ? preparedMesh->uploadBytes : 0; }
+};
+
+class AssetManager;
+// Purpose: loads models on the background thread, the request closest to the viewer is prepared first.
+// Only the CPU work is done here, the render thread takes the prepared models as its upload budget allows
+class AssetStreamer
+{
+public:
+	using RequestID = u64;
+private:
+	struct StreamRequest
+	{
+		RequestID id{ 0 };
+		fs::path folder;
+		glm::vec3 position{ glm::vec3(0.0f) };
+	};
+
+	const AssetManager& _assetManager;
+
+	std::mutex _mutex;
+	std::condition_variable_any _requestAdded;
+	std::vector<StreamRequest> _requests;
+	std::vector<StreamedMesh> _preparedMeshes;
+	glm::vec3 _viewerPosition{ glm::vec3(0.0f) };
+	RequestID _nextRequestID{ 1 };
+
+	std::jthread _worker; // the last one, so it's joined before the rest is destroyed
+
+	void Work(std::stop_token stopToken);
+public:
+	explicit AssetStreamer(const AssetManager& assetManager);
+	AssetStreamer(const AssetStreamer&) = delete;
+	AssetStreamer(AssetStreamer&&) = delete;
+	AssetStreamer& operator= (const AssetStreamer&) = delete;
+	AssetStreamer& operator= (AssetStreamer&&) = delete;
+
+	// Purpose: position is the one of the model in the world, it's compared with the viewer one to order the requests
+	RequestID Enqueue(const fs::path& folder, glm::vec3 position);
+	void SetViewerPosition(glm::vec3 position);
+
+	/**
+	* @brief Take the prepared mesh closest to the viewer
+	* @return nullopt if nothing is prepared or the closest one is bigger than the limit, smaller ones don't overtake it
+	*/
+	std::optional<StreamedMesh> TryTakeNearest(u64 uploadBytesLimit);
+};
@@ -1,17 +1,92 @@
 #pragma once
 #include "../util/util.h"
 #include "../scene/component.h"
+#include "../base/core/buffer_types.h"
 
 #include <glm/glm.hpp>
+#include <limits>
 
+// Purpose: vertex used on the CPU side, GPU gets it packed according to the VertexEncoding
 struct Vertex
 {
 	glm::vec3 position{ glm::vec3(0.0f) };
 	glm::vec3 normal{ glm::vec3(0.0f) };
-	glm::vec3 tangent{ glm::vec3(0.0f) };
+	glm::vec4 tangent{ glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) }; // w is the bitangent sign
 	glm::vec2 UV{ glm::vec2(0.0f) };
 };
 
+// Purpose: how the submesh vertices are packed for the GPU, see vertex_packing.h
+struct VertexEncoding
+{
+	glm::vec3 positionScale{ glm::vec3(1.0f) }; // position = positionOffset + quantized * positionScale
+	glm::vec3 positionOffset{ glm::vec3(0.0f) };
+	bool quantizedPosition{ false }; // unorm16 position instead of float
+	bool unormUV{ false }; // unorm16 UV instead of half, only when all UVs are in [0, 1]
+};
+
+// Purpose: cluster of the submesh triangles. Layout matches the shader one(scalar), bounds are in the mesh space
+struct Meshlet
+{
+	glm::vec3 center{ glm::vec3(0.0f) };
+	float radius{ 0.0f };
+
+	// Normal cone for backface culling: the whole meshlet is backfacing if dot(normalize(center - camera), coneAxis) >= coneCutoff
+	glm::vec3 coneAxis{ glm::vec3(0.0f) };
+	float coneCutoff{ 0.0f };
+	glm::vec3 coneApex{ glm::vec3(0.0f) };
+
+	u32 vertexOffset{ 0 }; // in meshlet vertices
+	u32 triangleOffset{ 0 }; // in bytes of meshlet triangles, 4 bytes aligned
+	u32 vertexCount{ 0 };
+	u32 triangleCount{ 0 };
+	u32 pad{ 0 };
+};
+
+struct MeshletDescription
+{
+	const Meshlet* meshletsPtr{ nullptr };
+	u32 meshletsCount{ 0 };
+	const u32* verticesPtr{ nullptr }; // indices of the submesh vertices
+	u32 verticesCount{ 0 };
+	const u8* trianglesPtr{ nullptr }; // 3 local indices per triangle
+	u32 trianglesBytesCount{ 0 };
+};
+
+// Purpose: level of detail, all the levels are in the submesh indices one after another starting from LOD 0
+struct MeshLod
+{
+	u32 firstIndex{ 0 }; // in the submesh indices
+	u32 indexCount{ 0 };
+	float error{ 0.0f }; // mesh space deviation from LOD 0, projected to pixels to choose the level
+};
+
+struct LodDescription
+{
+	static constexpr u32 MaxLodsCount{ 5 };
+
+	const MeshLod* lodsPtr{ nullptr };
+	u32 lodsCount{ 0 };
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center{ glm::vec3(0.0f) };
+	float radius{ 0.0f };
+};
+
+struct BoundingBox
+{
+	glm::vec3 minPosition{ glm::vec3(0.0f) };
+	glm::vec3 maxPosition{ glm::vec3(0.0f) };
+};
+
+// Purpose: bounds of the whole asset, all the submeshes placed by the model nodes
+struct MeshBounds
+{
+	BoundingBox boundingBox{};
+	BoundingSphere boundingSphere{};
+};
+
 struct VertexDescription
 {
 	const Vertex* vertexPtr{ nullptr };
@@ -57,6 +132,12 @@ struct MaterialDescription
 struct SubmeshDescription
 {
 	VertexDescription vertexDesc{};
+	VertexEncoding vertexEncoding{};
+	IndexType indexType{ IndexType::INDEX_TYPE_U32 }; // GPU index type, CPU indices are always u32
+	LodDescription lodDesc{}; // vertexDesc indices hold all the levels
+	BoundingBox boundingBox{}; // mesh space
+	BoundingSphere boundingSphere{};
+	MeshletDescription meshletDesc{};
 	MaterialDescription materialDesc{};
 	AlphaMode alphaMode{};
 };
@@ -72,9 +153,19 @@ struct Mesh
 struct LoadedMesh
 {
 	std::vector<Vertex> vertex;
-	std::vector<u32> indices;
+	std::vector<u32> indices; // all the LODs one after another
+
+	std::vector<MeshLod> lods; // empty if there's only LOD 0
+	BoundingBox boundingBox{}; // computed by the importer from all the source vertices
+	BoundingSphere boundingSphere{};
+
+	std::vector<Meshlet> meshlets; // LOD 0 only
+	std::vector<u32> meshletVertices;
+	std::vector<u8> meshletTriangles;
 
+	VertexEncoding vertexEncoding{}; // importer sets the position grid for already quantized sources
 	AlphaMode alphaMode{};
+	u32 materialIndex{ 0 }; // index in LoadedGLTF::materials
 };
 
 enum class TextureType : u8
@@ -97,8 +188,10 @@ struct TexturesData
 	TextureType textureType = TextureType::TEXTURE_NONE;
 
 	float factor{ 0.0f };
-	fs::path path = ""; // if URI
-	std::vector<u8> bytes; // if embedded type
+	fs::path path = ""; // if URI, or the file which contains the embedded image
+	u64 byteOffset{ 0 }; // embedded image range in the path file, it's decoded right from the mapping
+	u64 byteLength{ 0 };
+	std::vector<u8> bytes; // embedded image which isn't stored in the file as is(base64 data URI for example)
 };
 
 
@@ -113,10 +206,37 @@ struct MeshMaterial
 };
 
 
+// Purpose: node of the glTF scene graph. Nodes go parents first, so world transforms are found in one pass
+struct ModelNode
+{
+	static constexpr u32 NoParent{ std::numeric_limits<u32>::max() };
+	static constexpr u32 NoMesh{ std::numeric_limits<u32>::max() };
+
+	std::string name;
+	glm::mat4 localTransform{ glm::mat4(1.0f) };
+	u32 parent{ NoParent };
+	u32 mesh{ NoMesh }; // index in ModelHierarchy::meshes
+};
+
+// Purpose: submeshes(glTF primitives) of one glTF mesh, every node which references the mesh instances all of them
+struct MeshSubmeshRange
+{
+	u32 firstSubmesh{ 0 };
+	u32 submeshCount{ 0 };
+};
+
+// Purpose: scene graph of the model. Without nodes every submesh is drawn once with the entity transform
+struct ModelHierarchy
+{
+	std::vector<ModelNode> nodes;
+	std::vector<MeshSubmeshRange> meshes;
+};
+
 struct LoadedGLTF
 {
 	bool isLoaded{ false };
 	std::vector<LoadedMesh> meshes;
 
 	std::vector<MeshMaterial> materials;
+	ModelHierarchy hierarchy;
 };
@@ -0,0 +1,26 @@
+#pragma once
+#include "../util/util.h"
+#include "asset_types.h"
+
+#include <span>
+
+// Purpose: bounding volumes for the culling. Positions are reduced 4 lanes at a time where SSE is available
+namespace meshbounds
+{
+	BoundingBox ComputeBox(std::span<const Vertex> vertices);
+
+	// Sphere around the box center, its radius is the farthest vertex, so it's tighter than the box one
+	BoundingSphere ComputeSphere(std::span<const Vertex> vertices, const BoundingBox& box);
+
+	// Both volumes of the imported submesh
+	void ComputeBounds(LoadedMesh& mesh);
+
+	void Merge(BoundingBox& box, const BoundingBox& other);
+
+	// World space volumes, the box is still axis aligned and holds the transformed one
+	BoundingBox TransformBox(const BoundingBox& box, const glm::mat4& transform);
+	BoundingSphere TransformSphere(const BoundingSphere& sphere, const glm::mat4& transform);
+
+	// Aggregate of the submeshes. Every node of the hierarchy places its mesh, without nodes the submeshes are taken as is
+	MeshBounds ComputeAssetBounds(const std::vector<SubmeshDescription>& submeshes, const ModelHierarchy& hierarchy);
+}
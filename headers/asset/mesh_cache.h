@@ -0,0 +1,47 @@
+#pragma once
+#include "../util/util.h"
+#include "../util/mapped_file.h"
+#include "asset_types.h"
+
+// Purpose: mesh restored from the cooked file. Vertex/index pointers of submeshes point straight into the mapping,
+// so the file must live as long as the submeshes are used
+struct CookedMesh
+{
+	std::unique_ptr<MappedFile> file;
+	std::vector<SubmeshDescription> submeshes;
+	std::vector<u32> submeshMaterials; // index in materials per submesh
+	std::vector<MeshMaterial> materials; // texture paths are relative to the model folder as in glTF
+	ModelHierarchy hierarchy;
+};
+
+// Purpose: binary cache of the imported glTF(.luxmesh next to the .gltf file). It holds the final vertex and index streams,
+// so loading it is mapping the file and pointing at the data without parsing and decoding accessors.
+// The cache is stamped with the latest write time and the hash of the .gltf and .bin files of the model folder.
+// Write time is checked first, the hash is computed only if it's changed(after checkout for example)
+class MeshCache
+{
+private:
+	struct SourceStamp
+	{
+		u64 hash{ 0 };
+		i64 mtime{ 0 };
+	};
+
+	std::vector<fs::path> GetSourceFiles(const fs::path& sourcePath) const;
+	i64 GetSourceMtime(const std::vector<fs::path>& sourceFiles) const;
+	u64 GetSourceHash(const std::vector<fs::path>& sourceFiles) const;
+public:
+	static constexpr u32 Magic{ 0x4D58554C }; // 'LUXM'
+	static constexpr u32 Version{ 10 }; // 10: position grid shared by the primitives of one glTF mesh only
+
+	static fs::path GetCookedPath(const fs::path& sourcePath);
+
+	/**
+	* @brief Write the cooked file for the source. Must be called before the material paths are made absolute
+	* @return true if the file was written
+	*/
+	bool Write(const fs::path& sourcePath, const LoadedGLTF& loadedGLTF) const;
+
+	// Returns nullopt if there's no cooked file or it's stale, the caller should import the source then
+	std::optional<CookedMesh> TryLoad(const fs::path& sourcePath) const;
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include "../util/util.h"
+#include "asset_types.h"
+
+// Purpose: every pass can be turned off separately
+struct MeshOptimizationSettings
+{
+	bool weldVertices{ true }; // merge binary equal vertices through the remap table
+	bool optimizeVertexCache{ true };
+	bool optimizeOverdraw{ true }; // opaque submeshes only, others keep their triangles order
+	bool optimizeVertexFetch{ true };
+	bool buildMeshlets{ true };
+	bool generateLods{ true };
+	bool validateMeshlets{ true }; // check that meshlets cover the index buffer exactly
+	bool reportStatistics{ false }; // analysis after every pass, including the overdraw one, is slow
+
+	float overdrawThreshold{ 1.05f }; // how much ACMR might get worse to get less overdraw
+	u32 statisticsCacheSize{ 16 };
+
+	u32 maxMeshletVertices{ 64 };
+	u32 maxMeshletTriangles{ 124 }; // must be divisible by 4
+	float meshletConeWeight{ 0.25f }; // higher value gives tighter cones but worse spatial locality
+
+	// Per LOD after LOD 0: part of LOD 0 indices to keep and max error relative to the mesh extent.
+	// Level is dropped if it doesn't remove at least 10% of the previous one
+	u32 lodsCount{ 4 };
+	std::array<float, 4> lodIndexRatios{ 0.5f, 0.25f, 0.125f, 0.0625f };
+	std::array<float, 4> lodTargetErrors{ 0.002f, 0.01f, 0.03f, 0.08f };
+};
+
+// Purpose: post import stage. Runs meshoptimizer passes over the imported geometry before it's stored
+class MeshOptimizer
+{
+private:
+	MeshOptimizationSettings _settings;
+
+	// Statistics of the geometry after the pass
+	struct PassStatistics
+	{
+		u64 verticesCount{ 0 };
+		u64 trianglesCount{ 0 };
+		u64 verticesTransformed{ 0 };
+		u64 pixelsCovered{ 0 };
+		u64 pixelsShaded{ 0 };
+		u64 meshletsCount{ 0 };
+		std::array<u64, LodDescription::MaxLodsCount> lodTrianglesCount{};
+
+		PassStatistics& operator+=(const PassStatistics& other);
+	};
+
+	enum class OptimizationPass : u8
+	{
+		PASS_SOURCE,
+		PASS_WELD,
+		PASS_VERTEX_CACHE,
+		PASS_OVERDRAW,
+		PASS_VERTEX_FETCH,
+
+		PASS_COUNT
+	};
+
+	using MeshStatistics = std::array<PassStatistics, static_cast<u32>(OptimizationPass::PASS_COUNT)>;
+
+	void OptimizeMesh(LoadedMesh& mesh, MeshStatistics& statistics) const;
+	void BuildMeshlets(LoadedMesh& mesh) const;
+	void GenerateLods(LoadedMesh& mesh) const;
+	bool ValidateMeshlets(const LoadedMesh& mesh) const;
+	PassStatistics AnalyzeMesh(const LoadedMesh& mesh) const;
+	void ReportStatistics(const MeshStatistics& statistics) const;
+public:
+	MeshOptimizer() = default;
+	explicit MeshOptimizer(const MeshOptimizationSettings& settings) : _settings(settings) {}
+
+	const MeshOptimizationSettings& GetSettings() const { return _settings; }
+	void SetSettings(const MeshOptimizationSettings& settings) { _settings = settings; }
+
+	// Optimizes all the meshes in place, meshes are processed in parallel
+	void Optimize(LoadedGLTF& loadedGLTF) const;
+};
@@ -8,15 +8,32 @@ namespace fastgltf
 	class Asset;
 	class Mesh;
 	class Image;
+	class Primitive;
+	class Material;
+	struct Accessor;
 }
 
+// Purpose: where the embedded images are in the source file, so they're referenced instead of copied
+struct ImageSourceFile
+{
+	fs::path fileName; // relative to the glTF folder as URIs are
+	std::optional<u64> glbBinaryOffset; // file offset of the GLB binary chunk which holds buffer 0
+};
+
 class ModelImporter
 {
 private:
 	using EntityIndex = u32;
 
-	bool LoadMeshes(const fastgltf::Asset& asset, LoadedGLTF& gltfData);
-	void StoreTextureData(const fastgltf::Image& image, TexturesData& InTexture);
+	static std::optional<u64> FindGlbBinaryChunk(const fs::path& path);
+
+	bool LoadMeshes(const fastgltf::Asset& asset, const ImageSourceFile& sourceFile, LoadedGLTF& gltfData);
+	void LoadHierarchy(const fastgltf::Asset& asset, ModelHierarchy& hierarchy) const;
+	// Thread safe, reads only the asset and writes only the passed mesh
+	bool DecodePrimitive(const fastgltf::Asset& asset, const fastgltf::Primitive& primitive, LoadedMesh& mesh) const;
+	void SetSourcePositionGrid(const fastgltf::Accessor& accessor, VertexEncoding& encoding) const;
+	MeshMaterial LoadMaterial(const fastgltf::Asset& asset, const ImageSourceFile& sourceFile, const fastgltf::Material& material, u32 materialIndex);
+	void StoreTextureData(const fastgltf::Asset& asset, const ImageSourceFile& sourceFile, const fastgltf::Image& image, TexturesData& InTexture);
 public:
 	LoadedGLTF LoadGltf(const fs::path& path);
 
@@ -0,0 +1,20 @@
+#pragma once
+#include "../util/util.h"
+#include "asset_types.h"
+#include "mesh_cache.h"
+#include "texture_preparation.h"
+
+// Purpose: CPU side of the model load, everything what doesn't need the render thread is done.
+// Storing it and creating its images is left to AssetManager::StorePreparedMesh
+struct PreparedMesh
+{
+	fs::path sourcePath; // glTF of the model, its cooked mesh is found by it
+	std::optional<CookedMesh> cookedMesh;
+	LoadedGLTF loadedGLTF; // imported source if there's no cooked mesh
+
+	std::vector<MeshMaterial> materials;
+	std::vector<u32> submeshMaterials; // index in materials per submesh
+	PreparedTextures textures;
+
+	u64 uploadBytes{ 0 }; // geometry and textures which go to the GPU once the mesh is stored
+};
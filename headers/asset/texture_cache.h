@@ -0,0 +1,42 @@
+#pragma once
+#include "../util/util.h"
+#include "asset_types.h"
+
+#include <map>
+
+// Purpose: one image per unique texture source, materials share it through its bindless index.
+// Sources are matched by the canonical path first, then by the content hash to catch copies under other names.
+// Format depends on the texture type(sRGB albedo, linear normal), so the same image used as another type is another texture
+class TextureCache
+{
+private:
+	struct CachedTexture
+	{
+		u64 contentHash{ 0 };
+		TextureType type{ TextureType::TEXTURE_NONE };
+		u32 refCount{ 0 };
+		std::vector<std::string> keys; // all the paths which resolved to this texture
+	};
+
+	std::unordered_map<u32, CachedTexture> _textures; // by bindless index
+	std::unordered_map<std::string, u32> _indexByKey;
+	std::map<std::pair<u64, TextureType>, u32> _indexByHash;
+public:
+	static std::string GetCanonicalKey(const fs::path& path);
+	// Purpose: key of the source(canonical path, its embedded range or memory#hash) used as the type
+	static std::string GetTypedKey(const std::string& sourceKey, TextureType type);
+
+	// Purpose: bindless index of the cached texture or 0. Doesn't add a reference
+	u32 FindByKey(const std::string& key) const;
+	// Purpose: same as FindByKey, the key is remembered as an alias if the content is found
+	u32 FindByHash(u64 contentHash, TextureType type, const std::string& key);
+
+	// Purpose: newly created texture without references
+	void Insert(const std::string& key, u64 contentHash, TextureType type, u32 bindlessIndex);
+
+	void AddReference(u32 bindlessIndex);
+	// Purpose: true if it was the last reference, the texture is forgotten and its image might be destroyed
+	bool Release(u32 bindlessIndex);
+
+	u32 GetReferenceCount(u32 bindlessIndex) const;
+};
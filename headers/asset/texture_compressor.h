@@ -0,0 +1,25 @@
+#pragma once
+#include "../util/util.h"
+#include "../base/core/image_types.h"
+#include "asset_types.h"
+#include "texture_cooker.h"
+
+// Purpose: CPU block compression of the cooked textures. Format is chosen by the texture type:
+// opaque albedo is BC1, albedo with alpha is BC7, normals are BC5 with tangent space XY,
+// metallic-roughness is BC5 with roughness in R and metallic in G
+namespace blockcompression
+{
+	ImageFormat SelectFormat(const TextureMipChain& mipChain, TextureType textureType);
+
+	// Bytes per 4x4 block
+	u32 GetBlockSize(ImageFormat format);
+
+	// Purpose: compress all the levels of the RGBA8 chain, blocks of every level are encoded on all the cores
+	TextureMipChain Compress(const TextureMipChain& mipChain, TextureType textureType);
+
+	// 4x4 RGBA8 block in, encoded block out
+	void EncodeBC1(const u8* pixels, u8* result);
+	void EncodeBC4(const u8* pixels, u32 channel, u8* result);
+	void EncodeBC5(const u8* pixels, u32 firstChannel, u32 secondChannel, u8* result);
+	void EncodeBC7(const u8* pixels, u8* result);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "../util/util.h"
+#include "../util/mapped_file.h"
+#include "../base/core/image_types.h"
+#include "asset_types.h"
+#include "texture_decoder.h"
+
+#include <span>
+
+// Purpose: all the mip levels of the texture one after another, level i is max(1, size >> i)
+struct TextureMipChain
+{
+	std::vector<u8> data;
+	std::vector<u64> mipOffsets; // in data, 16 bytes aligned
+	u32 width{ 0 };
+	u32 height{ 0 };
+	ImageFormat format{ ImageFormat::IMAGE_FORMAT_R8G8B8A8_SRGB };
+};
+
+// Purpose: cooked mip chain used right from the mapping, the data lives while the file is mapped
+struct CookedTexture
+{
+	std::unique_ptr<MappedFile> file;
+	std::span<const u8> data;
+	std::vector<u64> mipOffsets;
+	u32 width{ 0 };
+	u32 height{ 0 };
+	ImageFormat format{ ImageFormat::IMAGE_FORMAT_R8G8B8A8_SRGB };
+};
+
+namespace mipgeneration
+{
+	// Purpose: 2x2 box filtered levels down to 1x1. Albedo is filtered in linear space, normals are renormalized,
+	// other textures are treated as linear data
+	TextureMipChain Generate(const DecodedTexture& texture, TextureType textureType);
+}
+
+// Purpose: textures with their mips built offline. The cooked file is found by the content hash of the source
+// image, so the changed source gets its own file. Layout is KTX2 like: header, level index, levels data
+class TextureCooker
+{
+private:
+	fs::path _cookedDirectory;
+public:
+	static constexpr u32 Magic{ 0x5458554C }; // 'LUXT'
+	static constexpr u32 Version{ 2 }; // 2: block compressed levels
+
+	void SetCookedDirectory(const fs::path& directory) { _cookedDirectory = directory; }
+	fs::path GetCookedPath(u64 contentHash, TextureType textureType) const;
+
+	// Thread safe, every texture has its own file
+	bool Write(u64 contentHash, TextureType textureType, const TextureMipChain& mipChain) const;
+	std::optional<CookedTexture> TryLoad(u64 contentHash, TextureType textureType) const;
+};
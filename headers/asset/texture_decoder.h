@@ -0,0 +1,24 @@
+#pragma once
+#include "../util/util.h"
+
+#include <span>
+
+// Purpose: CPU side of the texture, ready to be copied into the image
+struct DecodedTexture
+{
+	std::vector<u8> pixels; // RGBA8, rows are flipped vertically
+	u32 width{ 0 };
+	u32 height{ 0 };
+
+	bool IsValid() const { return !pixels.empty(); }
+};
+
+// Decoding is separated from the image creation, so it can run on the worker threads
+namespace texturedecoding
+{
+	// Purpose: decode the encoded image file(png, jpg...). Invalid texture is returned if it can't be decoded
+	DecodedTexture Decode(std::span<const u8> encoded);
+
+	// Purpose: decode all the images in parallel, result is in the same order
+	std::vector<DecodedTexture> DecodeAll(const std::vector<std::span<const u8>>& encoded);
+}
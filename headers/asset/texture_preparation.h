@@ -0,0 +1,74 @@
+#pragma once
+#include "../util/util.h"
+#include "asset_types.h"
+#include "texture_cache.h"
+#include "texture_cooker.h"
+
+#include <span>
+#include <limits>
+
+// Purpose: unique texture source of the model with its mips ready for the image creation
+struct PreparedTexture
+{
+	static constexpr u32 NoSource{ std::numeric_limits<u32>::max() };
+
+	std::string key; // canonical path(#offset) or memory#hash, with the type
+	fs::path path; // for the messages and the image specification
+	TextureType type{ TextureType::TEXTURE_NONE }; // chooses the format, so it's a part of the source identity
+	u64 contentHash{ 0 };
+	bool isKnown{ false }; // the key was in the texture cache already, nothing is loaded
+	u32 sameContentSource{ NoSource }; // earlier source with the same bytes under another name, nothing is loaded
+	bool isWritten{ false }; // mips were cooked now and their file is written
+
+	std::optional<CookedTexture> cooked; // mips right from the cooked file
+	TextureMipChain mipChain; // freshly cooked mips if there was no file
+
+	bool HasMips() const { return cooked.has_value() || !mipChain.data.empty(); }
+	u64 GetDataSize() const { return cooked ? cooked->data.size() : mipChain.data.size(); }
+};
+
+struct PreparedTextures
+{
+	std::vector<PreparedTexture> sources;
+	std::vector<u32> referenceSources; // per texture reference, index in sources
+};
+
+// Purpose: time and sizes of one stage of the preparation, summed over the calls
+struct TextureStageReport
+{
+	double milliseconds{ 0.0 };
+	u64 inputBytes{ 0 };
+	u64 outputBytes{ 0 };
+	u32 itemsCount{ 0 };
+};
+
+enum class TextureStage : u8
+{
+	STAGE_HASH,
+	STAGE_DECODE,
+	STAGE_MIPS,
+	STAGE_COMPRESS,
+	STAGE_WRITE,
+
+	STAGE_COUNT
+};
+
+using TexturePreparationReport = std::array<TextureStageReport, static_cast<size_t>(TextureStage::STAGE_COUNT)>;
+
+// Purpose: CPU side of the texture load shared by the engine and the offline cooker, no GPU objects are touched.
+// Sources are mapped, hashed, deduplicated by the key and by the content, taken from the cooked files or decoded,
+// filtered, block compressed and cooked. Every stage splits its work between all the cores
+namespace texturepreparation
+{
+	// Key of the source with its type, empty for the in memory images(they're known by the content only)
+	std::string GetSourceKey(const TexturesData& texture);
+
+	/**
+	* @brief Thread safe if knownTextures isn't changed meanwhile
+	* @param knownTextures sources with their keys in it aren't loaded at all, might be nullptr
+	* @param forceCook cooked files are ignored and written again
+	* @param report stage statistics are added to it, might be nullptr
+	*/
+	PreparedTextures Prepare(std::span<const TexturesData* const> textures, const TextureCooker& cooker,
+		const TextureCache* knownTextures, bool forceCook = false, TexturePreparationReport* report = nullptr);
+}
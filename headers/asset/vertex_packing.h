@@ -0,0 +1,43 @@
+#pragma once
+#include "../util/util.h"
+#include "asset_types.h"
+
+struct VertexPackingSettings
+{
+	bool quantizePositions{ true }; // 20 bytes per vertex instead of 24
+};
+
+// Purpose: GPU vertex format. Layout in 32 bit words, must match LoadVertex in g-pass.slang:
+// quantized position: [x | y << 16] [z] [normal] [tangent] [UV]      - 20 bytes
+// float position:     [x] [y] [z]   [normal] [tangent] [UV]           - 24 bytes
+// normal:  octahedral, unorm16 x | unorm16 y << 16
+// tangent: octahedral, unorm16 x | unorm15 y << 16 | bitangent sign << 31
+// UV:      half2 or unorm16x2
+namespace vertexpacking
+{
+	constexpr u32 QuantizedPositionStride{ 20 };
+	constexpr u32 FloatPositionStride{ 24 };
+	constexpr u32 MaxStride{ FloatPositionStride };
+
+	// Flags for the shader
+	constexpr u32 FormatQuantizedPosition{ 1u << 0 };
+	constexpr u32 FormatUnormUV{ 1u << 1 };
+
+	// Chooses the encoding for the final vertices of the model meshes, position grid set by the importer is kept.
+	// Primitives of one glTF mesh share the grid over their box, so the vertices on their borders stay at the same points.
+	// Every mesh has its own grid otherwise, a small one keeps its precision in a large model
+	void SelectEncodings(LoadedGLTF& model, const VertexPackingSettings& settings);
+
+	u32 GetStride(const VertexEncoding& encoding);
+	u32 GetFormatFlags(const VertexEncoding& encoding);
+
+	// Writes vertexCount * GetStride(encoding) bytes
+	void PackVertices(const Vertex* vertices, u32 vertexCount, const VertexEncoding& encoding, byte* outData);
+
+	// u16 indices if all the submesh vertices are addressable by them. Indices are local to the submesh
+	IndexType SelectIndexType(u32 vertexCount);
+	u32 GetIndexSize(IndexType type);
+
+	// Writes indexCount * GetIndexSize(type) bytes
+	void PackIndices(const u32* indices, u32 indexCount, IndexType type, byte* outData);
+}
@@ -12,6 +12,8 @@ struct BufferSpecification
 	AllocationCreate allocCreate{ AllocationCreate::NONE };
 
 	bool allocCmdBuff{ false };
+	bool asyncUpload{ false }; // GPU only buffers: upload through the transfer queue, check BufferManager::IsUploadResident
+
 
 	size_t size{ 0 }; // bytes
 };
@@ -27,6 +29,8 @@ public:
 	virtual const BufferSpecification& GetSpecification() const = 0;
 
 	virtual u64 GetBufferAddress() const = 0;
+	// Ticket of the last async upload, 0 if the buffer was never uploaded asynchronously
+	virtual u64 GetLastUploadTicket() const = 0;
 };
 
 class VulkanBase;
@@ -40,4 +44,5 @@ public:
 	BufferManager(VulkanBase& vulkanBase);
 
 	std::unique_ptr<Buffer>	 CreateBuffer(const BufferSpecification& spec)	 const;
+	bool IsUploadResident(u64 ticket) const;
 };
\ No newline at end of file
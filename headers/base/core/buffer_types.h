@@ -28,6 +28,12 @@ inline BufferUsage operator|(BufferUsage fst, BufferUsage scd)
 }
 
 
+enum class IndexType : u8
+{
+	INDEX_TYPE_U16,
+	INDEX_TYPE_U32,
+};
+
 enum class SharingMode : u8
 {
 	SHARING_EXCLUSIVE = 0,
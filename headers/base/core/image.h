@@ -2,10 +2,14 @@
 #include "image_types.h"
 #include "pipeline_types.h"
 
+#include <span>
+
 
 struct ImageSpecification
 {
 	std::filesystem::path path{};
+	std::span<const u8> pixels{}; // already decoded RGBA8 texture of the extent size, the path is decoded if it's empty
+	std::span<const u64> mipOffsets{}; // pixels contain all the mip levels at these offsets, otherwise mips are generated on the GPU
 
 	ImageType type{ ImageType::IMAGE_TYPE_NONE };
 	ImageFormat format{ ImageFormat::IMAGE_FORMAT_R8G8B8A8_SRGB };
@@ -18,6 +18,11 @@ enum class ImageFormat : u8
 	IMAGE_FORMAT_R16G16B16A16_SFLOAT,
 	IMAGE_FORMAT_D32_SFLOAT,
 	IMAGE_FORMAT_R32G32_UINT,
+
+	// Block compressed textures, see texture_compressor.h
+	IMAGE_FORMAT_BC1_RGB_SRGB,
+	IMAGE_FORMAT_BC5_UNORM,
+	IMAGE_FORMAT_BC7_SRGB,
 };
 
 enum class ImageUsage : u32
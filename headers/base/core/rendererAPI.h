@@ -1,5 +1,6 @@
 #pragma once
 #include "../../util/util.h"
+#include "buffer_types.h"
 
 
 // Due to Push Constants system it's a must to use something like this structure to map
@@ -19,6 +20,7 @@ struct RenderIndirectCountCommand
 	u32 maxDrawCount{ 1 };
 
 	Buffer* indexBuffer{ nullptr };
+	IndexType indexType{ IndexType::INDEX_TYPE_U32 };
 
 	u32 countBufferOffsetBytes{ 0 };
 };
@@ -28,8 +30,6 @@ struct IndirectPushConst
 	u64 vertexAddress{ 0 };
 	u64 commonMeshDataAddress{ 0 };
 	u64 viewDataAddress{ 0 };
-
-	u32 baseDrawOffset{ 0 };
 };
 
 struct DrawCommand
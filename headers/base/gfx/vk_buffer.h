@@ -9,6 +9,7 @@ namespace vkconversions
 	VmaMemoryUsage ToVmaMemoryUsage(MemoryUsage usage);
 	VkMemoryPropertyFlags ToVkMemoryPropertyFlags(MemoryProperty flags);
 	VmaAllocationCreateFlags ToVmaAllocationCreateFlags(AllocationCreate flags);
+	VkIndexType ToVkIndexType(IndexType type);
 	VkSharingMode ToVkSharingMode(SharingMode mode);
 }
 
@@ -29,6 +30,7 @@ private:
 	VmaAllocation _allocation{ nullptr };
 
 	void* _mappedData{ nullptr };
+	u64 _lastUploadTicket{ 0 };
 public:
 	u64 GetBufferAddress() const override;
 
@@ -49,4 +51,5 @@ public:
 	const BufferSpecification& GetSpecification() const override { return _specification; }
 
 	void  UploadData(u64 offset, const void* data, u64 size) override;
+	u64 GetLastUploadTicket() const override { return _lastUploadTicket; }
 };
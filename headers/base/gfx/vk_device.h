@@ -7,9 +7,10 @@ enum class QueueType : u8
 	VULKAN_GENERAL_QUEUE = 0,
 	VULKAN_GRAPHICS_QUEUE = 1,
 	VULKAN_PRESENTATION_QUEUE = 2,
+	VULKAN_TRANSFER_QUEUE = 3, // Dedicated transfer family if exists, general otherwise
 	// To do other types
 	
-	VULKAN_QUEUE_COUNT = 3,
+	VULKAN_QUEUE_COUNT = 4,
 };
 
 class VulkanDevice
@@ -31,6 +32,7 @@ private:
 	VkBool32 FamilySupportsPresentation(VkPhysicalDevice physDevice, u32 familyIndex) const;
 	VkBool32 QueryExtensionsSupport(VkPhysicalDevice physDevice) const;
 	std::optional<u32> GetQueueFamilyIndex(VkPhysicalDevice physDevice, VkQueueFlags flags) const;
+	std::optional<u32> GetDedicatedQueueFamilyIndex(VkPhysicalDevice physDevice, VkQueueFlags flags, VkQueueFlags excludedFlags) const;
 	const std::vector<const char*> _requiredDeviceExtensions
 	{
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
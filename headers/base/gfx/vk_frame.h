@@ -1,5 +1,7 @@
 #pragma once
 #include "vk_pipeline.h"
+#include "vk_upload_ring.h"
+#include "vk_transfer_queue.h"
 
 struct Attachments
 {
@@ -8,11 +10,13 @@ struct Attachments
 };
 
 class VulkanImage;
+class VulkanAllocator;
 class VulkanFrame
 {
 private:
 	VulkanDevice& _deviceObject;
 	VulkanPresentation& _presentationObject;
+	VulkanAllocator& _allocatorObject;
 
 	//std::vector<VkFramebuffer> _framebuffers;
 
@@ -22,7 +26,9 @@ private:
 	std::vector<VkSemaphore> _imageAvailableSemaphores;
 	std::vector<VkSemaphore> _renderFinishedSemaphores;
 	std::vector<VkFence> _syncCPUFences;
-	
+
+	std::unique_ptr<VulkanUploadRing> _uploadRing;
+	std::unique_ptr<VulkanTransferQueue> _transferQueue;
 
 	u32 _currentFrame{ 0 };
 	u32 _currentImage{ 0 };
@@ -33,7 +39,7 @@ private:
 public:
 	VulkanFrame() = delete;
 	~VulkanFrame() = default;
-	VulkanFrame(VulkanDevice& deviceObj, VulkanPresentation& presentationObj);
+	VulkanFrame(VulkanDevice& deviceObj, VulkanPresentation& presentationObj, VulkanAllocator& allocatorObj);
 
 
 	VulkanFrame(const VulkanFrame&) = delete;
@@ -61,6 +67,11 @@ public:
 	VkFence GetFence()                                     const;
 	VkCommandBuffer GetCommandBuffer()                     const;
 	VkCommandPool GetCommandPool()                         const { return _commandPool; }
+	VulkanUploadRing& GetUploadRing()                            { return *_uploadRing; }
+	VulkanTransferQueue& GetTransferQueue()                      { return *_transferQueue; }
+
+	// Record all queued buffer uploads and acquire completed async ones in the frame command buffer
+	void FlushUploads();
 
 	void Cleanup();
 };
@@ -47,6 +47,8 @@ private:
 	* @brief Change images layout when cmd buffer would start recording. ITS impossible to do it when image is created
 	*/
 	void CreateTexture();
+	// Purpose: texture with the mips built in advance, all the levels are copied with one command
+	void CreateTextureFromMips();
 	void CreateRenderTarget();
 public:
 	VulkanImage(const ImageSpecification& spec, VulkanDevice& deviceObject, VulkanFrame& frameObj, VulkanAllocator& allocatorObj);
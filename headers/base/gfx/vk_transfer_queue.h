@@ -0,0 +1,91 @@
+#pragma once
+#include "../../util/gfx/vk_types.h"
+
+class VulkanDevice;
+class VulkanAllocator;
+// Purpose: asynchronous uploads through the transfer queue family. Copies are batched into the command buffers
+// from the own pools, every submitted batch signals the timeline semaphore with its ticket.
+// Graphics queue acquires the batch only when it's complete, so it never waits for the DMA in the middle of the frame.
+// Queue family ownership is transferred per uploaded range: release here, acquire in the graphics command buffer.
+class VulkanTransferQueue
+{
+private:
+	VulkanDevice& _deviceObj;
+	VulkanAllocator& _allocatorObj;
+
+	struct StagingChunk
+	{
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VmaAllocation allocation{ nullptr };
+		byte* mappedData{ nullptr };
+
+		u64 capacity{ 0 };
+		u64 head{ 0 };
+	};
+
+	struct TransferBatch
+	{
+		VkCommandPool cmdPool{ VK_NULL_HANDLE };
+		VkCommandBuffer cmdBuffer{ VK_NULL_HANDLE };
+
+		std::vector<StagingChunk> stagingChunks;
+		std::vector<VkBufferMemoryBarrier2> ownershipBarriers; // release on the transfer queue, acquire on graphics
+
+		u64 ticket{ 0 };
+	};
+
+	VkSemaphore _timelineSemaphore{ VK_NULL_HANDLE };
+	u64 _lastSubmittedTicket{ 0 };
+	u64 _lastAcquiredTicket{ 0 };
+	u64 _graphicsWaitTicket{ 0 };
+
+	u32 _transferFamily{ 0 };
+	u32 _graphicsFamily{ 0 };
+
+	std::unique_ptr<TransferBatch> _openBatch;
+	std::deque<std::unique_ptr<TransferBatch>> _submittedBatches;
+	std::vector<std::unique_ptr<TransferBatch>> _freeBatches;
+
+	void CreateTimelineSemaphore();
+	std::unique_ptr<TransferBatch> CreateBatch();
+	void BeginBatch();
+	void RecycleBatch(std::unique_ptr<TransferBatch> batch);
+	void DestroyBatch(TransferBatch& batch);
+
+	StagingChunk& AllocateStaging(TransferBatch& batch, u64 size, u64& outOffset);
+public:
+	static constexpr u64 StagingChunkSize{ 16 * 1024 * 1024 }; // 16 MB
+
+	VulkanTransferQueue() = delete;
+	~VulkanTransferQueue() = default;
+	VulkanTransferQueue(VulkanDevice& deviceObj, VulkanAllocator& allocatorObj);
+
+	VulkanTransferQueue(const VulkanTransferQueue&) = delete;
+	VulkanTransferQueue(VulkanTransferQueue&&) = delete;
+	VulkanTransferQueue& operator= (const VulkanTransferQueue&) = delete;
+	VulkanTransferQueue& operator= (VulkanTransferQueue&&) = delete;
+
+	/**
+	* @brief Copy the data into the staging memory and record the copy. Nothing is executed until Submit()
+	* @return ticket, the upload is visible on the graphics queue when IsResident(ticket) returns true
+	*/
+	u64 UploadToBuffer(VkBuffer dstBuffer, u64 dstOffset, const void* data, u64 size);
+
+	// Submit the recorded batch to the transfer queue, doesn't wait
+	void Submit();
+
+	/**
+	* @brief Record acquire barriers for all the completed batches into the graphics command buffer.
+	* Must be called outside of the rendering
+	*/
+	void AcquireCompleted(VkCommandBuffer graphicsCmdBuffer);
+
+	// Returns the ticket graphics submission must wait for(0 if nothing was acquired) and resets it
+	u64 ConsumeGraphicsWaitTicket();
+
+	bool IsResident(u64 ticket) const { return ticket <= _lastAcquiredTicket; }
+	u64  GetNextTicket()        const { return _lastSubmittedTicket + 1; }
+	VkSemaphore GetTimelineSemaphore() const { return _timelineSemaphore; }
+
+	void Cleanup();
+};
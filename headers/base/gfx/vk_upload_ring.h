@@ -0,0 +1,82 @@
+#pragma once
+#include "../../util/gfx/vk_types.h"
+
+// Piece of the upload ring which could be written by the CPU and used as a source of the copy
+struct UploadRingAllocation
+{
+	VkBuffer buffer{ VK_NULL_HANDLE };
+	u64 offset{ 0 };
+	void* mappedPtr{ nullptr };
+};
+
+class VulkanDevice;
+class VulkanAllocator;
+// Purpose: persistently mapped linear allocator for staging data. One region per frame in flight,
+// every region is reset when its frame begins(fence is already waited at that moment).
+// Copies into GPU only buffers are not recorded immediately, they're batched per destination and
+// recorded with one vkCmdCopyBuffer per destination in Flush().
+class VulkanUploadRing
+{
+private:
+	VulkanDevice& _deviceObj;
+	VulkanAllocator& _allocatorObj;
+
+	struct RingRegion
+	{
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VmaAllocation allocation{ nullptr };
+		byte* mappedData{ nullptr };
+
+		u64 capacity{ 0 };
+		u64 head{ 0 };
+
+		bool skipNextReset{ false };
+	};
+
+	struct PendingCopyBatch
+	{
+		VkBuffer srcBuffer{ VK_NULL_HANDLE };
+		VkBuffer dstBuffer{ VK_NULL_HANDLE };
+		u64 dstEnd{ 0 };
+		std::vector<VkBufferCopy> regions;
+	};
+
+	std::vector<RingRegion> _regions;
+	u32 _currentRegion{ 0 };
+
+	std::vector<PendingCopyBatch> _pendingBatches;
+	bool _hasWarnedGrowth{ false }; // growth is reported once, it repeats while the uploads stay that big
+
+	void CreateRegion(RingRegion& region, u64 capacity);
+	void DestroyRegion(RingRegion& region);
+	void GrowRegion(RingRegion& region, u64 requiredSize);
+public:
+	static constexpr u64 DefaultRegionSize{ 8 * 1024 * 1024 }; // 8 MB per frame in flight
+
+	VulkanUploadRing() = delete;
+	~VulkanUploadRing() = default;
+	VulkanUploadRing(VulkanDevice& deviceObj, VulkanAllocator& allocatorObj, u32 regionsCount);
+
+	VulkanUploadRing(const VulkanUploadRing&) = delete;
+	VulkanUploadRing(VulkanUploadRing&&) = delete;
+	VulkanUploadRing& operator= (const VulkanUploadRing&) = delete;
+	VulkanUploadRing& operator= (VulkanUploadRing&&) = delete;
+
+	/**
+	* @brief Sub-allocate staging memory from the current frame region. Region grows if there's not enough space.
+	*/
+	UploadRingAllocation Allocate(u64 size, u64 alignment = 16);
+
+	/**
+	* @brief Queue a copy from the ring into the destination buffer. Would be recorded in the next Flush()
+	*/
+	void EnqueueCopy(const UploadRingAllocation& src, VkBuffer dstBuffer, u64 dstOffset, u64 size);
+
+	// Record all the queued copies into the command buffer. Must be called outside of the rendering
+	void Flush(VkCommandBuffer cmdBuffer);
+	void BeginFrame(u32 frameIndex);
+
+	bool HasPendingCopies() const { return !_pendingBatches.empty(); }
+
+	void Cleanup();
+};
@@ -7,8 +7,18 @@ struct DeviceIndexedBuffer
 {
 	std::unique_ptr<Buffer> vertexBuffer{ nullptr };
 	std::unique_ptr<Buffer> indexBuffer{ nullptr };
+	std::unique_ptr<Buffer> index16Buffer{ nullptr }; // submeshes with less than 65537 vertices
 
+	// Meshlets of all the submeshes, vertices are submesh local indices as the index buffer ones, triangles are packed bytes
+	std::unique_ptr<Buffer> meshletBuffer{ nullptr };
+	std::unique_ptr<Buffer> meshletVertexBuffer{ nullptr };
+	std::unique_ptr<Buffer> meshletTriangleBuffer{ nullptr };
 
-	size_t currentVertexOffset{ 0 };
+	size_t currentVertexOffset{ 0 }; // in bytes, submeshes might have different vertex encodings
 	size_t currentIndexOffset { 0 };
+	size_t currentIndex16Offset{ 0 };
+
+	size_t currentMeshletOffset{ 0 };
+	size_t currentMeshletVertexOffset{ 0 };
+	size_t currentMeshletTriangleOffset{ 0 }; // in bytes
 };
\ No newline at end of file
@@ -2,20 +2,31 @@
 #include "../util/util.h"
 
 class Buffer;
-struct DeviceIndirectBuffer
+// Purpose: draws of one pipeline and one index type. Count is stored at the end of the commands buffer
+struct IndirectDrawBatch
 {
-	std::unique_ptr<Buffer> opaqueBuffer{ nullptr };
-	std::unique_ptr<Buffer> maskBuffer{ nullptr };
+	static constexpr size_t MaxInstancesCount{ 16 * 1024 };
+	static constexpr size_t MaxDrawsCount{ 1024 - 1 }; // the last command slot holds the count
+
+	std::unique_ptr<Buffer> commandsBuffer{ nullptr };
 
-	// they're separated because it would be a WAY more convenient to manage, otherwise you would need a separate buffer to manage indices so this is the same basically
-	std::unique_ptr<Buffer> commonOpaqueData{ nullptr };
-	std::unique_ptr<Buffer> commonMaskedData{ nullptr };
+	// it's separated because it would be a WAY more convenient to manage, otherwise you would need a separate buffer to manage indices so this is the same basically.
+	// One record per instance, first instance of the draw command is the index of its first record.
+	// Copy per frame in flight, the frame updates only its own one while the GPU may still read the other
+	std::vector<std::unique_ptr<Buffer>> commonData;
+	std::vector<std::unique_ptr<Buffer>> boundsData; // world space bounds, indexed as commonData
 
+	size_t drawsCount{ 0 };
+	size_t instancesCount{ 0 };
+};
 
-	size_t currentOpaqueSize{ 0 };
-	size_t currentMaskedSize{ 0 };
-	size_t currentCommonOpaqueDataOffset{ 0 };
-	size_t currentCommonMaskedDataOffset{ 0 };
+// Purpose: batches are split by alpha type(pipeline) and index type, index buffer is bound once per indirect call
+struct DeviceIndirectBuffer
+{
+	IndirectDrawBatch opaqueBatch;
+	IndirectDrawBatch opaque16Batch;
+	IndirectDrawBatch maskedBatch;
+	IndirectDrawBatch masked16Batch;
 
 	size_t countBufferOffset{ 0 };
-};
\ No newline at end of file
+};
@@ -4,6 +4,7 @@
 #include "camera.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 struct TagComponent
 {
@@ -17,20 +18,46 @@ struct TagComponent
 };
 
 
+// Purpose: local TRS relative to the parent entity and the cached world matrix. Local values are changed
+// through the setters, they mark the transform dirty and TransformHierarchy recomputes its world matrix and its subtree
 struct TransformComponent
 {
-	//glm::mat4 rotation{ glm::mat4(1.0f) }; // To do: quats
-	//glm::vec3 translation{ glm::vec3(0.0f) };
-	//glm::vec3 scale{ glm::vec3(0.0f) };
+	static constexpr u32 NoParent{ 0 }; // entity IDs start from 1
 
-	glm::mat4 model{ glm::mat4(1.0f) };
+	glm::mat4 model{ glm::mat4(1.0f) }; // world matrix, written by TransformHierarchy::Update
 
 	TransformComponent() = default;
-	TransformComponent(const glm::mat4& newModel) : model{newModel}{}
-	/*TranslationComponent(const glm::mat4& newRot, glm::vec3 newTranslation, glm::vec3 newScale) :
-		rotation{newRot}, translation{newTranslation}, scale{newScale}
-	{
-	}*/
+	TransformComponent(const glm::mat4& localTransform) : model{ localTransform } { SetLocalMatrix(localTransform); }
+	TransformComponent(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+		: _translation{ translation }, _rotation{ rotation }, _scale{ scale } { model = GetLocalMatrix(); }
+
+	void SetTranslation(const glm::vec3& translation) { _translation = translation; _isDirty = true; }
+	void SetRotation(const glm::quat& rotation) { _rotation = rotation; _isDirty = true; }
+	void SetScale(const glm::vec3& scale) { _scale = scale; _isDirty = true; }
+	// Decomposed into TRS, shear of the matrix is lost
+	void SetLocalMatrix(const glm::mat4& localTransform);
+
+	const glm::vec3& GetTranslation() const { return _translation; }
+	const glm::quat& GetRotation() const { return _rotation; }
+	const glm::vec3& GetScale() const { return _scale; }
+	glm::mat4 GetLocalMatrix() const;
+
+	u32 GetParent() const { return _parent; }
+	bool IsDirty() const { return _isDirty; }
+	// World matrix was recomputed by this update of the hierarchy
+	bool IsChangedIn(u64 hierarchyUpdate) const { return _changedUpdate == hierarchyUpdate; }
+private:
+	friend class TransformHierarchy;
+
+	glm::vec3 _translation{ glm::vec3(0.0f) };
+	glm::quat _rotation{ glm::quat_cast(glm::mat3(1.0f)) };
+	glm::vec3 _scale{ glm::vec3(1.0f) };
+
+	u32 _parent{ NoParent };
+	u32 _parentGeneration{ 0 }; // the parent slot might be reused by another entity
+	u32 _depth{ 0 }; // level in the hierarchy, roots are 0
+	u64 _changedUpdate{ 0 };
+	bool _isDirty{ true };
 };
 
 struct CameraComponent
@@ -44,6 +71,14 @@ struct CameraComponent
 	}
 };
 
+// Purpose: what happens with the CPU copy of the mesh geometry once it's uploaded to the GPU
+enum class GeometryResidency : u8
+{
+	RESIDENCY_KEEP,
+	RESIDENCY_DROP_AFTER_UPLOAD,
+	RESIDENCY_RELOAD_FROM_CACHE, // dropped as well, but it's mapped from the cooked mesh again when it's needed
+};
+
 struct MeshComponent
 {
 	std::string folderName = "";
@@ -51,75 +86,6 @@ struct MeshComponent
 	u32 meshIndex{ 0 };
 	u32 materialIndex{ 0 };
 
-};
+	std::optional<GeometryResidency> residency; // global policy of the asset manager if it isn't set
 
-class ComponentList
-{
-private:
-	std::optional<TagComponent> _tagComponent;
-	std::optional<TransformComponent> _translationComponent;
-	std::optional<CameraComponent> _cameraComponent;
-	std::optional<MeshComponent> _meshComponent;
-public:
-	template<typename Component, typename... Args>
-	Component& Emplace(Args&&... args)
-	{
-		if constexpr (std::is_same<Component, TagComponent>::value)
-		{
-			return _tagComponent.emplace(args...);
-		}
-		else if constexpr (std::is_same<Component, TransformComponent>::value)
-		{
-			return _translationComponent.emplace(args...);
-		}
-		else if constexpr (std::is_same<Component, CameraComponent>::value)
-		{
-			return _cameraComponent.emplace(args...);
-		}
-		else if constexpr (std::is_same<Component, MeshComponent>::value)
-		{
-			return _meshComponent.emplace(args...);
-		}
-		else static_assert(false, "Unexcepted type passed to the function Emplace() of ComponentList class");
-	}
-
-	template<typename Component>
-	Component* Get()
-	{
-		if constexpr (std::is_same<Component, TagComponent>::value)
-		{
-			if (_tagComponent.has_value())
-				return &(*_tagComponent);
-
-
-			Logger::Log("Trying to get some component which is not initialized! Nullptr returned\n");
-			return nullptr;
-		}
-		else if constexpr (std::is_same<Component, TransformComponent>::value)
-		{
-			if (_translationComponent.has_value())
-				return &(*_translationComponent);
-
-			Logger::Log("Trying to get some component which is not initialized! Nullptr returned\n");
-			return nullptr;
-		}
-		else if constexpr (std::is_same<Component, CameraComponent>::value)
-		{
-			if (_cameraComponent.has_value())
-				return &(*_cameraComponent);
-
-			Logger::Log("Trying to get some component which is not initialized! Nullptr returned\n");
-			return nullptr;
-		}
-		else if constexpr (std::is_same<Component, MeshComponent>::value)
-		{
-			if (_meshComponent.has_value())
-				return &(*_meshComponent);
-
-			Logger::Log("Trying to get some component which is not initialized! Nullptr returned\n");
-			return nullptr;
-		}
-		else static_assert(false, "Unexcepted type passed to the function Get() of ComponentList class");
-	}
-
-};
\ No newline at end of file
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include "../util/util.h"
+
+#include <span>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+// Purpose: component pool without its type, for the code which works with all the pools of the entity(removal)
+class IComponentPool
+{
+public:
+	virtual ~IComponentPool() = default;
+
+	virtual void Remove(u32 entityID) = 0;
+	virtual bool Has(u32 entityID) const = 0;
+	virtual usize GetSize() const = 0;
+};
+
+// Purpose: any movable value type might be a component, it gets its pool on the first use
+template<typename T>
+concept SceneComponent = std::is_object_v<T> && !std::is_const_v<T> && !std::is_pointer_v<T> && std::is_move_constructible_v<T> && std::is_move_assignable_v<T>;
+
+namespace componentregistry
+{
+	inline u32 NextComponentTypeID()
+	{
+		static std::atomic<u32> counter{ 0 };
+		return counter.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Dense ID of the component type, the storage finds the pool by it without hashing
+	template<SceneComponent Component>
+	u32 GetComponentTypeID()
+	{
+		static const u32 id = NextComponentTypeID();
+		return id;
+	}
+}
+
+// Purpose: sparse set of one component type. Components are packed densely in the order they were added,
+// so iterating the pool is a linear walk. The sparse part maps the entity ID to the dense index in pages,
+// add, remove and lookup are O(1) without hashing.
+// Pointers to the components are valid until the next add or remove in the same pool
+template<SceneComponent Component>
+class ComponentPool final : public IComponentPool
+{
+public:
+	static constexpr u32 NoIndex{ std::numeric_limits<u32>::max() };
+private:
+	static constexpr u32 PageSize{ 4096 };
+
+	std::vector<std::unique_ptr<u32[]>> _sparsePages; // entity ID -> dense index, pages are allocated on the first use
+	std::vector<Component> _components;
+	std::vector<u32> _entities; // dense index -> entity ID
+	u64 _version{ 0 }; // changes when the dense order changes, cached views rebuild then
+
+	u32& GetSparseSlot(u32 entityID)
+	{
+		const u32 page = entityID / PageSize;
+		if (page >= _sparsePages.size())
+			_sparsePages.resize(page + 1);
+
+		if (!_sparsePages[page])
+		{
+			_sparsePages[page] = std::make_unique<u32[]>(PageSize);
+			std::fill_n(_sparsePages[page].get(), PageSize, NoIndex);
+		}
+
+		return _sparsePages[page][entityID % PageSize];
+	}
+public:
+	u32 GetDenseIndex(u32 entityID) const
+	{
+		const u32 page = entityID / PageSize;
+		if (page >= _sparsePages.size() || !_sparsePages[page])
+			return NoIndex;
+
+		return _sparsePages[page][entityID % PageSize];
+	}
+
+	// Replaces the component if the entity has it already
+	template<typename... Args>
+	Component& Emplace(u32 entityID, Args&&... args)
+	{
+		u32& denseIndex = GetSparseSlot(entityID);
+		if (denseIndex != NoIndex)
+		{
+			_components[denseIndex] = Component(std::forward<Args>(args)...);
+			return _components[denseIndex];
+		}
+
+		denseIndex = static_cast<u32>(_components.size());
+		_entities.push_back(entityID);
+		++_version;
+		return _components.emplace_back(std::forward<Args>(args)...);
+	}
+
+	// Last component is moved into the hole, so the pool stays packed
+	void Remove(u32 entityID) override
+	{
+		const u32 denseIndex = GetDenseIndex(entityID);
+		if (denseIndex == NoIndex)
+			return;
+
+		const u32 lastIndex = static_cast<u32>(_components.size() - 1);
+		if (denseIndex != lastIndex)
+		{
+			_components[denseIndex] = std::move(_components[lastIndex]);
+			_entities[denseIndex] = _entities[lastIndex];
+			GetSparseSlot(_entities[denseIndex]) = denseIndex;
+		}
+
+		_components.pop_back();
+		_entities.pop_back();
+		GetSparseSlot(entityID) = NoIndex;
+		++_version;
+	}
+
+	bool Has(u32 entityID) const override { return GetDenseIndex(entityID) != NoIndex; }
+
+	Component* Get(u32 entityID)
+	{
+		const u32 denseIndex = GetDenseIndex(entityID);
+		return denseIndex == NoIndex ? nullptr : &_components[denseIndex];
+	}
+
+	const Component* Get(u32 entityID) const
+	{
+		const u32 denseIndex = GetDenseIndex(entityID);
+		return denseIndex == NoIndex ? nullptr : &_components[denseIndex];
+	}
+
+	// Component i belongs to the entity i
+	std::span<Component> GetComponents() { return _components; }
+	std::span<const Component> GetComponents() const { return _components; }
+	std::span<const u32> GetEntities() const { return _entities; }
+
+	usize GetSize() const override { return _components.size(); }
+	u64 GetVersion() const { return _version; }
+};
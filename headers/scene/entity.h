@@ -1,67 +1,84 @@
 #pragma once
 #include "../util/util.h"
 #include "scene_base.h"
+#include "scene_storage.h"
 
 
-// Operate on copies and store them to the storage!
+// Purpose: handle of the entity, it's a value and might be copied freely. ID is the slot index in the storage,
+// components are found by it. The slot is reused after the entity is destroyed, the generation tells the handle
+// of the destroyed entity from the new one, so the stale handle gets no components
 class Entity
 {
 private:
 	SceneBase* _scene{ nullptr };
-	u32 _id{0};
+	u32 _id{ 0 };
+	u32 _generation{ 0 };
 
 	// Mesh* _mesh;
 public:
 	Entity() = delete;
-	Entity(u32 id, SceneBase* scene) : _id{ id }, _scene{ scene }
+	Entity(u32 id, u32 generation, SceneBase* scene) : _scene{ scene }, _id{ id }, _generation{ generation }
 	{
 
 	}
 
 	bool operator==(const Entity& other) const
 	{
-		return _id == other._id;
+		return _id == other._id && _generation == other._generation;
 	}
 
 
 	u32 GetID() const { return _id; }
+	u32 GetGeneration() const { return _generation; }
 	const SceneBase* GetScenePtr() const { return _scene; }
+	SceneBase* GetScene() const { return _scene; }
 
+	// O(1), compares the generation with the one of the slot
+	bool IsAlive() const { return _scene && _scene->GetStorage().IsAlive(_id, _generation); }
 
+
+	// Component lookup is an index into the pool of the type, nullptr if the entity doesn't have it or is destroyed
 	template<typename Component>
 	Component* GetComponent() const 
 	{
-		assert(_scene&& _id != -1 && "Cannot get component for the object, scenePtr or id is null");
-		auto entityComponentList = _scene->GetComponentListByEntity(*this);
-		if (entityComponentList == nullptr)
-			assert(entityComponentList && "Component list is empty in GetComponent(). Cannot add component. Check call stack");
+		assert(_scene && _id != 0 && "Cannot get component for the object, scenePtr or id is null");
+		if (!IsAlive())
+			return nullptr;
+
+		return _scene->GetStorage().GetPool<Component>().Get(_id);
+	}
 
-		return entityComponentList->Get<Component>();
+	template<typename Component>
+	bool HasComponent() const
+	{
+		assert(_scene && _id != 0 && "Cannot check component of the object, scenePtr or id is null");
+		return IsAlive() && _scene->GetStorage().GetPool<Component>().Has(_id);
 	}
 
 	template<typename Component, typename... Args>
 	Component& AddComponent(Args&&... args) const
 	{
-		assert(_scene && _id != -1 && "Cannot add component to the object, scenePtr or id is null");
-		auto entityComponentList = _scene->GetComponentListByEntity(*this);
-		if (entityComponentList == nullptr)
-			assert(entityComponentList && "Component list is empty in GetComponent(). Cannot add component. Check call stack");
-
-		return entityComponentList->Emplace<Component>(std::forward<Args>(args)...);
+		assert(_scene && _id != 0 && "Cannot add component to the object, scenePtr or id is null");
+		assert(IsAlive() && "Cannot add component to the destroyed entity");
+		return _scene->GetStorage().GetPool<Component>().Emplace(_id, std::forward<Args>(args)...);
 	}
 
-
+	template<typename Component>
+	void RemoveComponent() const
+	{
+		assert(_scene && _id != 0 && "Cannot remove component of the object, scenePtr or id is null");
+		if (IsAlive())
+			_scene->GetStorage().GetPool<Component>().Remove(_id);
+	}
 };
 
 
-// Maybe in the future engine would need multiple scenes.
+// ID and generation are unique for the scene, no pointer is mixed in
 template <>
 struct std::hash<Entity>
 {
 	std::size_t operator()(const Entity& e) const noexcept
 	{
-		std::size_t h1 = std::hash<i32>{}(e.GetID());
-		std::size_t h2 = std::hash<const SceneBase*>{}(e.GetScenePtr());
-		return h1 ^ (h2 << 1);
+		return std::hash<u64>{}((static_cast<u64>(e.GetGeneration()) << 32) | e.GetID());
 	}
-};
\ No newline at end of file
+};
@@ -2,6 +2,7 @@
 #include "../base/gfx/vk_base.h"
 #include "../asset/asset_manager.h"
 #include "camera.h"
+#include "transform_hierarchy.h"
 
 
 class Entity;
@@ -18,13 +19,18 @@ private:
 	void Initialize();
 
 	std::shared_ptr<Camera> _camera; // basic camera object from which every component would copy;
+	TransformHierarchy _transformHierarchy;
 public:
 	/**
 	* @brief return a copy. Perform operations on the copies and then upload them to the registry 
 	*/
 	//Entity CreateEntityInRegistry();
 	//const auto& GetRegistry() const { return _entityRegistry; }
-	ComponentList* GetComponentListByEntity(const Entity& entity);
+	SceneStorage& GetStorage() const { return _storageInstance; }
+	TransformHierarchy& GetTransformHierarchy() { return _transformHierarchy; }
+	Entity CreateEntity();
+	void DestroyEntity(const Entity& entity);
+	Entity GetEntity(u32 entityID);
 
 	const Camera& GetCamera() const { assert(_camera && "Camera is nullptr somehow"); return *_camera; }
 	void Update();
@@ -8,6 +8,10 @@
 #include "iscene_renderer.h"
 #include "../constructed_types/device_indexed_buffer.h"
 #include "../constructed_types/device_indirect_buffer.h"
+#include "../asset/asset_streamer.h"
+#include "entity.h"
+
+#include <limits>
 
 struct RenderData
 {
@@ -104,14 +108,128 @@ struct DrawIndexedIndirectCommand
 	u32    firstInstance{ 0 };
 };
 
+// Purpose: Transform of the shader
+struct InstanceTransform
+{
+	glm::mat4 model{ glm::mat4(1.0f) };
+};
+
 struct CommonIndirectData
 {
 	MaterialTexturesDesc materialsDesc{};
-	TransformComponent transformDesc{};
+	InstanceTransform transformDesc{};
 
 	float alphaCutoff{ 0.0f };
+
+	// Range in the global meshlet buffer for the cluster culling
+	u32 firstMeshlet{ 0 };
+	u32 meshletCount{ 0 };
+
+	// Packed vertices decoding, see vertex_packing.h
+	glm::vec3 positionScale{ glm::vec3(1.0f) };
+	glm::vec3 positionOffset{ glm::vec3(0.0f) };
+	u32 vertexByteOffset{ 0 };
+	u32 vertexFormat{ 0 };
+};
+
+// Purpose: world space volumes of the instance for the culling, record i belongs to the CommonIndirectData record i.
+// Layout matches InstanceBounds in g-pass.slang(scalar)
+struct InstanceBounds
+{
+	glm::vec3 sphereCenter{ glm::vec3(0.0f) };
+	float sphereRadius{ 0.0f };
+	glm::vec3 boxMin{ glm::vec3(0.0f) };
+	u32 pad0{ 0 };
+	glm::vec3 boxMax{ glm::vec3(0.0f) };
+	u32 pad1{ 0 };
+};
+
+// Purpose: contiguous records of the batch, [first, first + count)
+struct RecordRange
+{
+	u32 first{ 0 };
+	u32 count{ 0 };
+};
+
+// Purpose: records of the stored draw and how many of them still have their owner
+struct DrawRecords
+{
+	RecordRange records{};
+	u32 ownersCount{ 0 };
+	u32 meshIndex{ 0 }; // asset of the geometry
+};
+
+// Purpose: CPU copy of the batch records. Changed records are written here and their ranges wait per frame in flight,
+// every frame uploads the ranges of its own GPU copy only, so the cost follows the changes and not the scene size.
+// Draw whose owners are all destroyed is emptied, its command slot and records are reused by the next draws
+struct IndirectBatchRecords
+{
+	static constexpr u32 NoDraw{ std::numeric_limits<u32>::max() };
+
+	std::vector<CommonIndirectData> commonData;
+	std::vector<InstanceBounds> bounds;
+	std::vector<u32> recordDraws; // draw slot per record, NoDraw once the owner is destroyed
+	std::vector<std::vector<RecordRange>> dirtyRanges; // per frame in flight
+
+	std::vector<DrawRecords> draws; // per command slot
+	std::vector<u32> freeDraws;
+	std::vector<RecordRange> freeRecords; // sorted by the first record, adjacent ones are merged
 };
 
+// Purpose: record of the instance owned by the entity, it follows the entity world matrix and material
+struct InstanceRecord
+{
+	IndirectDrawBatch* batch{ nullptr };
+	u32 recordIndex{ 0 };
+	u32 submeshIndex{ 0 };
+	MeshBounds localBounds{}; // of the submesh, world ones are recomputed when the entity moves
+};
+
+// Purpose: instances drawn for the entity, added by the renderer when its draws are stored
+struct RenderInstancesComponent
+{
+	std::vector<InstanceRecord> records;
+};
+
+// Purpose: instance of the submesh placed by the model node, the owner entity moves it later
+struct SubmeshInstance
+{
+	glm::mat4 model{ glm::mat4(1.0f) };
+	Entity owner;
+};
+
+// Draw waits here until its geometry uploaded through the transfer queue is resident
+struct PendingIndirectDraw
+{
+	DrawIndexedIndirectCommand drawCommand{};
+	std::vector<CommonIndirectData> instancesData; // per instance, they differ by the transform only
+	std::vector<InstanceBounds> instancesBounds; // per instance as well
+	std::vector<Entity> instancesOwners; // per instance as well
+	u32 meshIndex{ 0 }; // asset of the geometry
+	u32 submeshIndex{ 0 };
+	MeshBounds localBounds{};
+	AlphaMode::AlphaType alphaType{ AlphaMode::AlphaType::ALPHA_OPAQUE };
+	IndexType indexType{ IndexType::INDEX_TYPE_U32 };
+
+	// Levels of the submesh, their first indices are relative to the drawCommand one
+	std::array<MeshLod, LodDescription::MaxLodsCount> lods{};
+	u32 lodsCount{ 0 };
+
+	u64 uploadTicket{ 0 };
+};
+
+// Purpose: published draw which has several LODs, its command is rewritten only when the chosen level changes
+struct DrawLodState
+{
+	IndirectDrawBatch* batch{ nullptr };
+	u32 drawIndex{ 0 }; // in the batch
+	DrawIndexedIndirectCommand drawCommand{}; // LOD 0 one
+
+	std::array<MeshLod, LodDescription::MaxLodsCount> lods{};
+	u32 lodsCount{ 0 };
+	u32 currentLod{ 0 };
+	// Instances are the records of the command, they share the level and the nearest one chooses it
+};
 
 struct GBufferPipelines
 {
@@ -119,7 +237,6 @@ struct GBufferPipelines
 	std::unique_ptr<Pipeline> maskPipeline{ nullptr };
 };
 
-class Entity;
 class SceneRenderer : public ISceneRenderer
 {
 private:
@@ -155,15 +272,53 @@ private:
 	DeviceIndirectBuffer _indirectBuffer;
 	DeviceIndexedBuffer  _meshDeviceBuffer;
 
-	std::queue<const Entity*> _entityCreateQueue;
+	std::queue<Entity> _entityCreateQueue;
+	std::unordered_map<AssetStreamer::RequestID, Entity> _streamingEntities; // entities waiting for their models, might be destroyed meanwhile
+	u64 _streamingUploadBudgetBytes{ 8 * 1024 * 1024 }; // per frame, the size of the upload ring region
+	std::deque<PendingIndirectDraw> _pendingDraws;
+	std::unordered_map<u32, u32> _meshDrawsCount; // pending and stored draws per mesh asset, the asset is removed with its last one
+
+	std::array<IndirectBatchRecords, 4> _batchRecords; // in the order of GetIndirectBatches
+	SceneBase* _scene{ nullptr }; // of the submitted entities, its hierarchy reports the moved ones
+
+	std::vector<DrawLodState> _lodDraws;
+	float _lodErrorThresholdPixels{ 1.0f }; // the coarsest LOD which deviates from LOD 0 less than this on the screen is drawn
 
 	void ExecuteEntityCreateQueue();
+	void FinalizeStreamedMeshes(const Camera& camera);
+	u64 UploadEntityMeshes(const Entity& entity, u32 meshIndex);
+	bool FitsMeshBuffers(const std::vector<SubmeshDescription>& submeshes) const;
+	std::vector<std::vector<SubmeshInstance>> InstantiateModelNodes(const Entity& entity, u32 meshIndex, size_t submeshesCount);
+	bool StoreIndirectDraw(const PendingIndirectDraw& pendingDraw);
+	IndirectDrawBatch& GetIndirectBatch(AlphaMode::AlphaType alphaType, IndexType indexType);
+	std::array<IndirectDrawBatch*, 4> GetIndirectBatches();
+	IndirectBatchRecords& GetBatchRecords(const IndirectDrawBatch& batch);
+	void MarkRecordsDirty(IndirectBatchRecords& records, RecordRange range);
+	void WriteRecordTransform(const InstanceRecord& record, const glm::mat4& model);
+	std::optional<u32> AllocateRecords(IndirectDrawBatch& batch, IndirectBatchRecords& records, u32 count);
+	void FreeRecords(IndirectBatchRecords& records, RecordRange range);
+	void ClearRecord(IndirectBatchRecords& records, u32 recordIndex);
+	void ReleaseMeshDraw(u32 meshIndex);
+	void UpdateMovedInstances();
+	void UploadDirtyRecords();
+	void RenderIndirectBatch(const IndirectDrawBatch& batch, Pipeline* pipeline, IndexType indexType);
+	void PublishResidentDraws();
+	void SelectDrawLods(const Camera& camera);
 public:
 	/**
 	* @brief Pass the objects which would LIVE after the submission
 	* @param entity reference
 	*/
 	void SubmitEntityToDraw(const Entity& entity);
+	/**
+	* @brief Material of the entity instances of the submesh, uploaded with the next frames
+	* @param entity which owns the instances: the model node entity or the model one if the model has no nodes
+	*/
+	void SetInstancesMaterial(const Entity& entity, u32 submeshIndex, const MaterialTexturesDesc& material);
+	/**
+	* @brief Instances of the entity stop being drawn, call it before the entity is destroyed
+	*/
+	void ReleaseEntityInstances(const Entity& entity);
 	void Update(const Camera& camera) override;
 	void Draw() override;
 
@@ -1,14 +1,62 @@
 #pragma once
 #include "component.h"
-#include "entity.h"
+#include "component_pool.h"
+#include "scene_view.h"
 
+class Entity;
+class SceneBase;
+
+// Purpose: entities of the scene and their components. Every component type lives in its own dense pool,
+// so the entity pays only for the components it has and systems walk the pools linearly.
+// Pool of the type is created on its first use, nothing has to be registered in the storage.
+// Entity is a slot with the generation, destroyed slots go to the free list and are reused with the next generation
 class SceneStorage
 {	
 private:
-	u32 _currentAvailableID{ 1 };
-	std::unordered_map<Entity, ComponentList> _entityRegistry;
+	std::vector<u32> _generations{ 0 }; // per slot, slot 0 is never used, so ID 0 stays invalid
+	std::vector<u32> _freeSlots;
+	u32 _aliveCount{ 0 };
+
+	std::vector<std::unique_ptr<IComponentPool>> _pools; // by component type ID
 public:
-	const Entity& CreateEntityInRegistry(SceneBase* scene);
-	const auto& GetRegistry() const { return _entityRegistry; }
-	ComponentList* GetComponentListByEntity(const Entity& entity);
-};
\ No newline at end of file
+	SceneStorage();
+	~SceneStorage();
+
+	Entity CreateEntityInRegistry(SceneBase* scene);
+	// Removes all the components of the entity, its handles become stale. Does nothing for the stale handle
+	void DestroyEntity(const Entity& entity);
+
+	bool IsAlive(u32 entityID, u32 generation) const { return entityID != 0 && entityID < _generations.size() && _generations[entityID] == generation; }
+	// Handle of the entity which lives in the slot now
+	Entity GetEntity(u32 entityID, SceneBase* scene) const;
+	u32 GetGeneration(u32 entityID) const { return entityID < _generations.size() ? _generations[entityID] : 0; }
+	u32 GetAliveCount() const { return _aliveCount; }
+
+	template<SceneComponent Component>
+	ComponentPool<Component>& GetPool()
+	{
+		const u32 typeID = componentregistry::GetComponentTypeID<Component>();
+		if (typeID >= _pools.size())
+			_pools.resize(typeID + 1);
+
+		if (!_pools[typeID])
+			_pools[typeID] = std::make_unique<ComponentPool<Component>>();
+
+		return static_cast<ComponentPool<Component>&>(*_pools[typeID]);
+	}
+
+	// nullptr if no entity had the component yet
+	template<SceneComponent Component>
+	const ComponentPool<Component>* FindPool() const
+	{
+		const u32 typeID = componentregistry::GetComponentTypeID<Component>();
+		return typeID < _pools.size() ? static_cast<const ComponentPool<Component>*>(_pools[typeID].get()) : nullptr;
+	}
+
+	template<SceneComponent... Components>
+	View<Components...> GetView() { return View<Components...>(GetPool<Components>()...); }
+
+	// The cached view keeps pointers to the pools, it's valid as long as the storage
+	template<SceneComponent... Components>
+	CachedView<Components...> CreateCachedView() { return CachedView<Components...>(GetPool<Components>()...); }
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include "../util/util.h"
+#include "component_pool.h"
+
+// Purpose: entities which have all the components. The smallest pool is walked and the entity is checked in the others,
+// so the query costs the size of its rarest component. The function gets the entity ID and the components:
+// func(u32 entityID, Components&... components). Components mustn't be added or removed in the queried pools during the walk
+template<SceneComponent... Components>
+class View
+{
+	static_assert(sizeof...(Components) > 0, "View needs at least one component");
+private:
+	std::tuple<ComponentPool<Components>*...> _pools;
+
+	std::span<const u32> GetSmallestEntities() const
+	{
+		std::span<const u32> result = std::get<0>(_pools)->GetEntities();
+		((result = std::get<ComponentPool<Components>*>(_pools)->GetSize() < result.size()
+			? std::get<ComponentPool<Components>*>(_pools)->GetEntities() : result), ...);
+		return result;
+	}
+public:
+	explicit View(ComponentPool<Components>&... pools) : _pools{ &pools... } {}
+
+	template<typename Func>
+	void Each(Func&& func) const
+	{
+		for (const u32 entityID : GetSmallestEntities())
+		{
+			const std::tuple<Components*...> components{ std::get<ComponentPool<Components>*>(_pools)->Get(entityID)... };
+			if ((std::get<Components*>(components) && ...))
+				func(entityID, *std::get<Components*>(components)...);
+		}
+	}
+
+	template<SceneComponent Component>
+	ComponentPool<Component>& GetPool() const { return *std::get<ComponentPool<Component>*>(_pools); }
+
+	// Upper bound of the matched entities
+	usize GetSizeHint() const { return GetSmallestEntities().size(); }
+};
+
+// Purpose: view for the hot queries. Matched entities are kept with their dense indices in every pool,
+// so the walk is direct indexing without the sparse lookups. The match is rebuilt only when one of the pools
+// was added to or removed from since the last walk, replacing the component values doesn't invalidate it
+template<SceneComponent... Components>
+class CachedView
+{
+private:
+	using DenseIndices = std::array<u32, sizeof...(Components)>;
+
+	View<Components...> _view;
+	std::array<u64, sizeof...(Components)> _poolVersions{};
+	bool _isBuilt{ false };
+
+	std::vector<u32> _entities;
+	std::vector<DenseIndices> _denseIndices; // per matched entity, in the order of Components
+
+	std::array<u64, sizeof...(Components)> GetPoolVersions() const
+	{
+		return { _view.template GetPool<Components>().GetVersion()... };
+	}
+
+	void Rebuild()
+	{
+		_entities.clear();
+		_denseIndices.clear();
+
+		_view.Each([this](u32 entityID, Components&...)
+			{
+				_entities.push_back(entityID);
+				_denseIndices.push_back(DenseIndices{ _view.template GetPool<Components>().GetDenseIndex(entityID)... });
+			});
+
+		_poolVersions = GetPoolVersions();
+		_isBuilt = true;
+	}
+
+	template<typename Func, usize... Indices>
+	void EachCached(Func& func, std::index_sequence<Indices...>)
+	{
+		const std::tuple<std::span<Components>...> components{ _view.template GetPool<Components>().GetComponents()... };
+		for (usize i = 0; i < _entities.size(); ++i)
+			func(_entities[i], std::get<Indices>(components)[_denseIndices[i][Indices]]...);
+	}
+public:
+	explicit CachedView(ComponentPool<Components>&... pools) : _view{ pools... } {}
+
+	template<typename Func>
+	void Each(Func&& func)
+	{
+		if (!_isBuilt || _poolVersions != GetPoolVersions())
+			Rebuild();
+
+		EachCached(func, std::index_sequence_for<Components...>{});
+	}
+
+	usize GetSize()
+	{
+		if (!_isBuilt || _poolVersions != GetPoolVersions())
+			Rebuild();
+
+		return _entities.size();
+	}
+};
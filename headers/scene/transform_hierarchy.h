@@ -0,0 +1,46 @@
+#pragma once
+#include "../util/util.h"
+#include "component.h"
+#include "component_pool.h"
+
+#include <limits>
+#include <algorithm>
+
+class SceneStorage;
+
+// Purpose: world matrices of the transforms. Transforms are kept in depth order(breadth first), so parents are ready
+// before their children and every level is computed across the workers. Only the dirty transforms and their subtrees
+// get new matrices, the update starts from the shallowest dirty level and a frame without changes costs one pool walk
+class TransformHierarchy
+{
+private:
+	static constexpr u32 ParallelLevelSize{ 4096 }; // smaller levels aren't worth the threads
+	static constexpr u32 ChunkSize{ 512 };
+
+	std::vector<u32> _order; // dense indices of the transform pool by depth
+	std::vector<u32> _parentIndices; // dense index of the parent per dense index, NoIndex for the roots
+	std::vector<u32> _levelOffsets; // level i is [_levelOffsets[i], _levelOffsets[i + 1]) of the order
+	bool _isStructureChanged{ true };
+	u64 _transformsVersion{ 0 }; // version of the pool the order was built for
+	u64 _updateIndex{ 0 };
+
+	std::vector<u32> _changedEntities; // world matrices recomputed by the last update
+	std::vector<std::vector<u32>> _chunkChangedEntities; // per chunk of the parallel level, merged after it
+
+	void RebuildOrder(const SceneStorage& storage, ComponentPool<TransformComponent>& transforms);
+	void UpdateLevel(ComponentPool<TransformComponent>& transforms, u32 level);
+public:
+	/**
+	* @brief Child local TRS becomes relative to the parent, its subtree follows the parent from the next update
+	* @param parentID entity with the transform or TransformComponent::NoParent to make the child a root
+	*/
+	void SetParent(SceneStorage& storage, u32 childID, u32 parentID);
+
+	void Update(SceneStorage& storage);
+
+	// Transforms changed by the last update have IsChangedIn(GetUpdateIndex())
+	u64 GetUpdateIndex() const { return _updateIndex; }
+	// Entities whose world matrix was recomputed by the last update, parents before children.
+	// Consumers mirroring the matrices pay for what moved, not for the whole pool
+	std::span<const u32> GetChangedEntities() const { return _changedEntities; }
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include "util.h"
+
+#include <algorithm>
+
+// Purpose: elements of the arena in a row, the handle stays valid until the range is freed
+struct ArenaRange
+{
+	u32 chunk{ 0 };
+	u32 offset{ 0 };
+	u32 count{ 0 };
+
+	bool IsEmpty() const { return count == 0; }
+};
+
+// Purpose: storage which never moves its elements. Ranges are placed into fixed size chunks and a new chunk is added
+// when the range doesn't fit, so storing is O(new data) and pointers to the elements stay valid.
+// Freed ranges go to the free list and are reused by the next allocations(first fit)
+template<typename T>
+class ChunkedArena
+{
+private:
+	struct Chunk
+	{
+		std::unique_ptr<T[]> data;
+		u32 capacity{ 0 };
+		u32 used{ 0 };
+	};
+
+	std::vector<Chunk> _chunks;
+	std::vector<ArenaRange> _freeRanges;
+	u32 _chunkCapacity{ 0 };
+	usize _usedCount{ 0 };
+public:
+	static constexpr usize DefaultChunkBytes{ 4 * 1024 * 1024 };
+
+	explicit ChunkedArena(usize chunkBytes = DefaultChunkBytes)
+		: _chunkCapacity{ static_cast<u32>(std::max<usize>(1, chunkBytes / sizeof(T))) } {}
+
+	ArenaRange Allocate(u32 count)
+	{
+		if (count == 0)
+			return {};
+
+		_usedCount += count;
+
+		for (usize i = 0; i < _freeRanges.size(); ++i)
+		{
+			ArenaRange& freeRange = _freeRanges[i];
+			if (freeRange.count < count)
+				continue;
+
+			// The rest of the freed range stays in the list
+			const ArenaRange result{ freeRange.chunk, freeRange.offset, count };
+			freeRange.offset += count;
+			freeRange.count -= count;
+			if (freeRange.count == 0)
+			{
+				freeRange = _freeRanges.back();
+				_freeRanges.pop_back();
+			}
+
+			return result;
+		}
+
+		if (_chunks.empty() || _chunks.back().capacity - _chunks.back().used < count)
+		{
+			// Tail of the full chunk is left for the smaller ranges
+			if (!_chunks.empty() && _chunks.back().used < _chunks.back().capacity)
+			{
+				Chunk& lastChunk = _chunks.back();
+				_freeRanges.push_back(ArenaRange{ static_cast<u32>(_chunks.size() - 1), lastChunk.used, lastChunk.capacity - lastChunk.used });
+				lastChunk.used = lastChunk.capacity;
+			}
+
+			// Range bigger than the chunk gets its own one
+			const u32 capacity = std::max(_chunkCapacity, count);
+			_chunks.push_back(Chunk{ std::make_unique<T[]>(capacity), capacity, 0 });
+		}
+
+		Chunk& chunk = _chunks.back();
+		const ArenaRange result{ static_cast<u32>(_chunks.size() - 1), chunk.used, count };
+		chunk.used += count;
+		return result;
+	}
+
+	ArenaRange Store(const T* data, u32 count)
+	{
+		const ArenaRange range = Allocate(count);
+		if (!range.IsEmpty())
+			std::copy_n(data, count, Get(range));
+
+		return range;
+	}
+
+	// Purpose: O(1), the elements aren't destroyed until they're overwritten by the next store
+	void Free(const ArenaRange& range)
+	{
+		if (range.IsEmpty())
+			return;
+
+		assert(range.chunk < _chunks.size() && "Trying to free the range of another arena");
+		_usedCount -= range.count;
+
+		// Range at the end of the last chunk is given back to it
+		Chunk& chunk = _chunks[range.chunk];
+		if (range.chunk == _chunks.size() - 1 && range.offset + range.count == chunk.used)
+			chunk.used -= range.count;
+		else
+			_freeRanges.push_back(range);
+	}
+
+	T* Get(const ArenaRange& range) { return range.IsEmpty() ? nullptr : &_chunks[range.chunk].data[range.offset]; }
+	const T* Get(const ArenaRange& range) const { return range.IsEmpty() ? nullptr : &_chunks[range.chunk].data[range.offset]; }
+
+	usize GetSize() const { return _usedCount; }
+};
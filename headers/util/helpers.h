@@ -1,5 +1,6 @@
 #pragma once
 #include "util.h"
+#include "worker_pool.h"
 
 namespace helpers
 {
@@ -9,4 +10,31 @@ namespace helpers
 		return fs::exists(path / "headers") && fs::exists(path / "src");
 	}
 
+	inline u32 GetWorkerThreadsCount()
+	{
+		return WorkerPool::Get().GetThreadsCount();
+	}
+
+	// Purpose: run func(index) for every index in [0, count) on all the cores of the worker pool. Indices are taken one by one,
+	// so tasks with different cost are balanced. Blocks until everything is done, func must be thread safe
+	template<typename Func>
+	void ParallelFor(u32 count, Func&& func)
+	{
+		WorkerPool::Get().ParallelFor(count, std::forward<Func>(func));
+	}
+
+	// Purpose: FNV-1a 64 bit hash, pass the previous result as seed to hash several ranges as one
+	inline u64 HashBytes(const void* data, usize size, u64 seed = 0xcbf29ce484222325ull)
+	{
+		const byte* bytes = static_cast<const byte*>(data);
+		u64 hash = seed;
+		for (usize i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
 }
\ No newline at end of file
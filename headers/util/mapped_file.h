@@ -0,0 +1,32 @@
+#pragma once
+#include "util.h"
+
+// Purpose: read only memory mapping of the whole file. Data lives while the object lives
+class MappedFile
+{
+private:
+	const byte* _data{ nullptr };
+	usize _size{ 0 };
+
+#ifdef _WIN32
+	void* _fileHandle{ nullptr };
+	void* _mappingHandle{ nullptr };
+#else
+	i32 _fileDescriptor{ -1 };
+#endif
+
+	void Unmap();
+public:
+	MappedFile() = delete;
+	explicit MappedFile(const fs::path& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator= (const MappedFile&) = delete;
+	MappedFile& operator= (MappedFile&&) = delete;
+
+	bool IsMapped()       const { return _data != nullptr; }
+	const byte* GetData() const { return _data; }
+	usize GetSize()       const { return _size; }
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include "util.h"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// Purpose: threads which live for the whole run, parallel loops are submitted to them instead of starting their own.
+// The caller works on its own loop too and waits only for the indices already taken by the workers,
+// so the loops might be nested(loop of a worker submits another one) without deadlocks
+class WorkerPool
+{
+private:
+	struct Job
+	{
+		void (*invoke)(void* func, u32 index){ nullptr };
+		void* func{ nullptr };
+		u32 count{ 0 };
+		std::atomic<u32> nextIndex{ 0 };
+		u32 activeWorkers{ 0 }; // guarded by the pool mutex, the job lives until it's zero
+	};
+
+	std::mutex _mutex;
+	std::condition_variable _jobAdded;
+	std::condition_variable _jobLeft;
+	std::deque<Job*> _jobs; // with the indices left to take
+	bool _isStopping{ false };
+
+	std::vector<std::jthread> _workers; // the last one, so they're joined before the rest is destroyed
+
+	WorkerPool();
+
+	static void Execute(Job& job);
+	void Run(Job& job);
+	void WorkerLoop();
+public:
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool(WorkerPool&&) = delete;
+	WorkerPool& operator= (const WorkerPool&) = delete;
+	WorkerPool& operator= (WorkerPool&&) = delete;
+
+	static WorkerPool& Get();
+
+	// Workers and the calling thread
+	u32 GetThreadsCount() const { return static_cast<u32>(_workers.size()) + 1; }
+
+	// Purpose: run func(index) for every index in [0, count). Indices are taken one by one,
+	// so tasks with different cost are balanced. Blocks until everything is done, func must be thread safe
+	template<typename Func>
+	void ParallelFor(u32 count, Func&& func)
+	{
+		if (count <= 1 || _workers.empty())
+		{
+			for (u32 i = 0; i < count; ++i)
+				func(i);
+			return;
+		}
+
+		Job job{};
+		job.invoke = [](void* func, u32 index) { (*static_cast<std::remove_reference_t<Func>*>(func))(index); };
+		job.func = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+		job.count = count;
+		Run(job);
+	}
+};
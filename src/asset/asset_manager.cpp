@@ -10,6 +10,7 @@
 void AssetManager::Initialize()
 {
 	s_Instance = new AssetManager;
+	s_Instance->_textureCooker.SetCookedDirectory(FindProjectRoot() / "resources" / "cooked" / "textures");
 }
 
 
@@ -28,24 +29,97 @@ size_t AssetManager::GetAllSceneSize()
 // WORKS ONLY WITH GLTF
 // TO REWORK THIS CLASS A LITTLE BIT
 std::optional<MeshStorageBackData> AssetManager::TryToLoadAndStoreMesh(const fs::path& folder, ImageManager* imageManager)
+{
+	std::optional<PreparedMesh> preparedMesh = PrepareMesh(folder, imageManager != nullptr, &_textureCache);
+	if (!preparedMesh)
+		return std::nullopt;
+
+	return StorePreparedMesh(*preparedMesh, imageManager);
+}
+
+std::optional<PreparedMesh> AssetManager::PrepareMesh(const fs::path& folder, bool withTextures, const TextureCache* knownTextures) const
 {
 	fs::path pathToLoad = ConvertToPath(folder);
 	fs::path finalPath = FindGLTFByPath(pathToLoad);
 
-	LoadedGLTF loadedGLTF = _importer.LoadGltf(finalPath);
-	if (!loadedGLTF.isLoaded)
+	PreparedMesh result{};
+	result.sourcePath = finalPath;
+
+	// Cooked file is used as is if the source is unchanged, otherwise the source is imported and cooked again
+	result.cookedMesh = finalPath.empty() ? std::nullopt : _meshCache.TryLoad(finalPath);
+	if (result.cookedMesh)
 	{
-		std::cout << "Unable to load model by provided folder: " << folder << '\n';
-		return std::nullopt;
+		result.materials = std::move(result.cookedMesh->materials);
+		result.submeshMaterials = std::move(result.cookedMesh->submeshMaterials);
+	}
+	else
+	{
+		// Importer keeps no state, a local one lets the workers import at the same time
+		ModelImporter importer;
+		result.loadedGLTF = importer.LoadGltf(finalPath);
+		if (!result.loadedGLTF.isLoaded)
+		{
+			std::cout << "Unable to load model by provided folder: " << folder << '\n';
+			return std::nullopt;
+		}
+
+		_meshOptimizer.Optimize(result.loadedGLTF);
+		vertexpacking::SelectEncodings(result.loadedGLTF, _vertexPackingSettings);
+
+		_meshCache.Write(finalPath, result.loadedGLTF);
+
+		for (const auto& mesh : result.loadedGLTF.meshes)
+			result.submeshMaterials.push_back(mesh.materialIndex);
+		result.materials = std::move(result.loadedGLTF.materials);
 	}
 
+	ConvertMaterialsPathToAbsolute(folder, result.materials);
+
+	if (withTextures)
+		result.textures = PrepareTextures(result.materials, knownTextures);
+
+	// Geometry is counted as it's packed for the GPU
+	const auto addGeometryBytes = [&result](u64 vertexCount, u64 indexCount, const VertexEncoding& encoding, IndexType indexType,
+		u64 meshletsCount, u64 meshletVerticesCount, u64 meshletTrianglesBytes)
+		{
+			result.uploadBytes += vertexCount * vertexpacking::GetStride(encoding) + indexCount * vertexpacking::GetIndexSize(indexType) +
+				meshletsCount * sizeof(Meshlet) + meshletVerticesCount * sizeof(u32) + meshletTrianglesBytes;
+		};
+
+	if (result.cookedMesh)
+	{
+		for (const SubmeshDescription& submesh : result.cookedMesh->submeshes)
+		{
+			addGeometryBytes(submesh.vertexDesc.vertexCount, submesh.vertexDesc.indexCount, submesh.vertexEncoding, submesh.indexType,
+				submesh.meshletDesc.meshletsCount, submesh.meshletDesc.verticesCount, submesh.meshletDesc.trianglesBytesCount);
+		}
+	}
+	else
+	{
+		for (const LoadedMesh& mesh : result.loadedGLTF.meshes)
+		{
+			addGeometryBytes(mesh.vertex.size(), mesh.indices.size(), mesh.vertexEncoding, vertexpacking::SelectIndexType(static_cast<u32>(mesh.vertex.size())),
+				mesh.meshlets.size(), mesh.meshletVertices.size(), mesh.meshletTriangles.size());
+		}
+	}
+
+	for (const PreparedTexture& texture : result.textures.sources)
+		result.uploadBytes += texture.GetDataSize();
+
+	return result;
+}
+
+MeshStorageBackData AssetManager::StorePreparedMesh(PreparedMesh& preparedMesh, ImageManager* imageManager)
+{
 	AssetID index = _currentAvailableIndex;
-	_storage.StoreVertex(loadedGLTF, index);
-	
 
-	ConvertMaterialsPathToAbsolute(folder, loadedGLTF);
+	if (preparedMesh.cookedMesh)
+		_storage.StoreCookedVertex(*preparedMesh.cookedMesh, index);
+	else
+		_storage.StoreVertex(preparedMesh.loadedGLTF, index);
 
 	++_currentAvailableIndex;
+	_meshSources.insert({ index, preparedMesh.sourcePath });
 
 	MeshStorageBackData backData{};
 	backData.meshIndex = index;
@@ -54,10 +128,13 @@ std::optional<MeshStorageBackData> AssetManager::TryToLoadAndStoreMesh(const fs:
 	// If image manager is passed load materials as well
 	if (imageManager)
 	{
-		std::vector<MaterialTexturesDesc> allMeshMaterials;
-		for (const auto& unloadedMaterial : loadedGLTF.materials)
+		// Every unique material is loaded once, then submeshes take their own one
+		const std::vector<MaterialTexturesDesc> uniqueMaterials = CreateMaterials(*imageManager, preparedMesh.materials, preparedMesh.textures, _meshTextures[index]);
+
+		std::vector<MaterialTexturesDesc> allMeshMaterials; // 1 material per submesh
+		for (const u32 materialIndex : preparedMesh.submeshMaterials)
 		{
-			allMeshMaterials.push_back(TryToLoadMaterial(*imageManager, unloadedMaterial));
+			allMeshMaterials.push_back(uniqueMaterials[materialIndex]);
 		}
 
 		// store material index which is the same as mesh index for now but might be changed later(very likely)
@@ -76,70 +153,152 @@ AssetManager::MaterialID AssetManager::StoreLoadedMaterials(const std::vector<Ma
 	return availableIndex;
 }
 
-MaterialTexturesDesc AssetManager::TryToLoadMaterial(const ImageManager& imageManager, const MeshMaterial& material)
+std::vector<MaterialTexturesDesc> AssetManager::TryToLoadMaterials(const ImageManager& imageManager, const std::vector<MeshMaterial>& materials,
+	std::vector<TextureID>& textureReferences)
 {
-	MaterialTexturesDesc description;
-	for (auto& texture : material.materialTextures)
+	PreparedTextures preparedTextures = PrepareTextures(materials, &_textureCache);
+	return CreateMaterials(imageManager, materials, preparedTextures, textureReferences);
+}
+
+PreparedTextures AssetManager::PrepareTextures(const std::vector<MeshMaterial>& materials, const TextureCache* knownTextures) const
+{
+	std::vector<const TexturesData*> textures;
+	for (const auto& material : materials)
+	{
+		for (const auto& texture : material.materialTextures)
+			textures.push_back(&texture);
+	}
+
+	return texturepreparation::Prepare(textures, _textureCooker, knownTextures);
+}
+
+std::vector<MaterialTexturesDesc> AssetManager::CreateMaterials(const ImageManager& imageManager, const std::vector<MeshMaterial>& materials,
+	PreparedTextures& preparedTextures, std::vector<TextureID>& textureReferences)
+{
+	std::vector<PreparedTexture>& sources = preparedTextures.sources;
+	std::vector<u32> sourceIDs(sources.size(), 0); // 0 if the texture isn't loaded
+
+	for (u32 i = 0; i < sources.size(); ++i)
 	{
+		PreparedTexture& source = sources[i];
+		if (source.key.empty())
+			continue;
+
+		if (const u32 cachedID = _textureCache.FindByKey(source.key))
+		{
+			sourceIDs[i] = cachedID;
+			continue;
+		}
+
+		// Sources are in the order they were found, so the one with the same content is resolved already
+		if (source.sameContentSource != PreparedTexture::NoSource)
+		{
+			sourceIDs[i] = sourceIDs[source.sameContentSource];
+			if (sourceIDs[i] != 0)
+				_textureCache.FindByHash(source.contentHash, source.type, source.key); // remembers the name
+			continue;
+		}
+
+		if (!source.HasMips())
+			continue; // reported when it was prepared
+
+		// Texture might be loaded by another model after this one was prepared
+		if (const u32 cachedID = _textureCache.FindByHash(source.contentHash, source.type, source.key))
+		{
+			sourceIDs[i] = cachedID;
+			continue;
+		}
+
+		// Image creation records GPU commands, so it stays on this thread
 		ImageSpecification spec;
 		spec.type = ImageType::IMAGE_TYPE_TEXTURE;
 		spec.aspect = ImageAspect::IMAGE_ASPECT_COLOR;
-		spec.format = ImageFormat::IMAGE_FORMAT_R8G8B8A8_SRGB;
-		spec.path = texture.path;
+		spec.path = source.path;
 
-		const u32 availableIndex = static_cast<u32>(_textures.size() + 1); // starts from 1
-
-		switch (texture.dataType)
+		if (source.cooked)
 		{
-		case TexturesData::Type::URI:
+			spec.format = source.cooked->format;
+			spec.pixels = source.cooked->data;
+			spec.mipOffsets = source.cooked->mipOffsets;
+			spec.extent = ImageExtent3D{ source.cooked->width, source.cooked->height, 1 };
+		}
+		else
 		{
-			if (texture.textureType == TextureType::TEXTURE_ALBEDO)
-			{
-				auto res = imageManager.CreateImage(spec);
-				if (res)
-				{
-					description.albedoID = availableIndex;
-					description.baseColorFactor = material.baseColorFactor;
-					_textures.emplace_back(availableIndex, std::move(res));
-				}
-				else
-					description.albedoID = 0;
-			}
-			else if (texture.textureType == TextureType::TEXTURE_NORMAL)
-			{
-				auto res = imageManager.CreateImage(spec);
-				if (res)
-				{
-					description.normalID = availableIndex;
-					_textures.emplace_back(availableIndex, std::move(res));
-				}
-				else
-					description.normalID = 0;
-			}
-			else if (texture.textureType == TextureType::TEXTURE_METALLICROUGHNESS)
-			{
-				auto res = imageManager.CreateImage(spec);
-				if (res)
-				{
-					description.metalRoughnessID = availableIndex;
-					description.metallicFactor = material.metallicFactor;
-					description.roughnessFactor = material.roughnessFactor;
-					_textures.emplace_back(availableIndex, std::move(res));
-				}
-				else
-					description.metalRoughnessID = 0;
-			}
-
-			break;
+			spec.format = source.mipChain.format;
+			spec.pixels = source.mipChain.data;
+			spec.mipOffsets = source.mipChain.mipOffsets;
+			spec.extent = ImageExtent3D{ source.mipChain.width, source.mipChain.height, 1 };
 		}
 
-		case TexturesData::Type::EMBEDDED:
+		auto image = imageManager.CreateImage(spec);
+
+		// Pixels are in the upload memory now
+		source.cooked.reset();
+		source.mipChain = {};
+
+		if (!image)
+			continue;
+
+		sourceIDs[i] = StoreTexture(std::move(image));
+		_textureCache.Insert(source.key, source.contentHash, source.type, sourceIDs[i]);
+	}
+
+	// Every material texture holds its own reference
+	std::vector<u32> textureIDs(preparedTextures.referenceSources.size(), 0);
+	for (u32 i = 0; i < textureIDs.size(); ++i)
+	{
+		textureIDs[i] = sourceIDs[preparedTextures.referenceSources[i]];
+		if (textureIDs[i] == 0)
+			continue;
+
+		_textureCache.AddReference(textureIDs[i]);
+		textureReferences.push_back(textureIDs[i]);
+	}
+
+	std::vector<MaterialTexturesDesc> result;
+	result.reserve(materials.size());
+
+	usize firstTexture = 0;
+	for (const auto& material : materials)
+	{
+		const std::span<const u32> materialTextureIDs(textureIDs.data() + firstTexture, material.materialTextures.size());
+		result.push_back(TryToLoadMaterial(material, materialTextureIDs));
+		firstTexture += material.materialTextures.size();
+	}
+
+	return result;
+}
+
+MaterialTexturesDesc AssetManager::TryToLoadMaterial(const MeshMaterial& material, std::span<const u32> textureIDs)
+{
+	assert(textureIDs.size() == material.materialTextures.size() && "Texture IDs don't match the material textures");
+
+	MaterialTexturesDesc description;
+	for (u32 textureIndex = 0; textureIndex < material.materialTextures.size(); ++textureIndex)
+	{
+		// Not loaded texture is reported already, the material uses the default one
+		const u32 textureID = textureIDs[textureIndex];
+		if (textureID == 0)
+			continue;
+
+		switch (material.materialTextures[textureIndex].textureType)
 		{
-			// to do;
+		case TextureType::TEXTURE_ALBEDO:
+			description.albedoID = textureID;
+			description.baseColorFactor = material.baseColorFactor;
+			break;
+
+		case TextureType::TEXTURE_NORMAL:
+			description.normalID = textureID;
+			break;
+
+		case TextureType::TEXTURE_METALLICROUGHNESS:
+			description.metalRoughnessID = textureID;
+			description.metallicFactor = material.metallicFactor;
+			description.roughnessFactor = material.roughnessFactor;
 			break;
-		}
 
-		default: std::cout << "Unknown data type of texture\n";
+		default: std::cout << "Unknown type of texture\n";
 			break;
 		}
 	}
@@ -147,27 +306,112 @@ MaterialTexturesDesc AssetManager::TryToLoadMaterial(const ImageManager& imageMa
 	return description;
 }
 
+// Purpose: released slots are reused, so bindless indices stay dense
+AssetManager::TextureID AssetManager::StoreTexture(std::unique_ptr<Image> image)
+{
+	if (!_freeTextureSlots.empty())
+	{
+		const TextureID textureID = _freeTextureSlots.back();
+		_freeTextureSlots.pop_back();
+		_textures[textureID - 1].second = std::move(image);
+		return textureID;
+	}
+
+	const TextureID textureID = static_cast<TextureID>(_textures.size() + 1); // starts from 1
+	_textures.emplace_back(textureID, std::move(image));
+	return textureID;
+}
+
+void AssetManager::ReleaseTexture(TextureID textureID)
+{
+	if (textureID == 0 || !_textureCache.Release(textureID))
+		return;
+
+	_textures[textureID - 1].second.reset();
+	_freeTextureSlots.push_back(textureID);
+}
+
 
 // Just a helper function to make it more approachable in the code
 // When storing mesh textures need to convert all texture paths
 // to the absolute to load later.
-void AssetManager::ConvertMaterialsPathToAbsolute(const fs::path& modelFolderName, LoadedGLTF& loadedGLTF)
+void AssetManager::ConvertMaterialsPathToAbsolute(const fs::path& modelFolderName, std::vector<MeshMaterial>& materials) const
 {
-	for (auto& material : loadedGLTF.materials)
+	for (auto& material : materials)
 	{
 		for (auto& texture : material.materialTextures)
 		{
+			// In memory image doesn't have a file
+			if (texture.path.empty())
+				continue;
+
 			texture.path = ConvertToPath(modelFolderName / texture.path);
 		}
 	}
 }
 
-const std::vector<MaterialTexturesDesc>& AssetManager::GetAllSceneMaterialsDesc() const
+void AssetManager::RemoveMesh(AssetID id)
+{
+	// Images are destroyed a few frames later, the frames in flight may still sample them
+	if (auto texturesIt = _meshTextures.find(id); texturesIt != _meshTextures.end())
+	{
+		for (const TextureID textureID : texturesIt->second)
+			ReleaseTexture(textureID);
+
+		_meshTextures.erase(texturesIt);
+	}
+
+	_storage.RemoveAsset(id);
+	_meshSources.erase(id);
+}
+
+void AssetManager::OnMeshUploaded(AssetID id, u64 gpuBytes, std::optional<GeometryResidency> policy)
+{
+	_storage.SetAssetResidencyPolicy(id, policy.value_or(_defaultResidency));
+	_storage.SetAssetGpuBytes(id, gpuBytes);
+
+	ReleaseGeometry(id);
+}
+
+const std::vector<SubmeshDescription>* AssetManager::AcquireGeometry(AssetID id)
+{
+	const AssetResidency* residency = _storage.GetAssetResidency(id);
+	if (residency == nullptr)
+		return nullptr;
+
+	if (residency->isCpuResident)
+		return _storage.GetAssetSubmeshes(id);
+
+	if (residency->policy != GeometryResidency::RESIDENCY_RELOAD_FROM_CACHE)
+		return nullptr;
+
+	auto sourceIt = _meshSources.find(id);
+	if (sourceIt == _meshSources.end())
+		return nullptr;
+
+	std::optional<CookedMesh> cookedMesh = _meshCache.TryLoad(sourceIt->second);
+	if (!cookedMesh || !_storage.RestoreCookedVertex(*cookedMesh, id))
+	{
+		std::cout << "Unable to reload mesh geometry from the cooked cache: " << sourceIt->second << '\n';
+		return nullptr;
+	}
+
+	return _storage.GetAssetSubmeshes(id);
+}
+
+void AssetManager::ReleaseGeometry(AssetID id)
 {
-	return _storage.GetAllSceneMaterials();
+	const AssetResidency* residency = _storage.GetAssetResidency(id);
+	if (residency != nullptr && residency->policy != GeometryResidency::RESIDENCY_KEEP)
+		_storage.DropGeometry(id);
 }
 
-fs::path AssetManager::ConvertToPath(const fs::path& folder)
+fs::path AssetManager::ConvertToPath(const fs::path& folder) const
+{
+	return FindProjectRoot() / "resources" / "models" / folder;
+}
+
+fs::path AssetManager::FindProjectRoot()
 {
 	fs::path result = fs::current_path();
 	while (!helpers::IsProjectRoot(result))
@@ -181,17 +425,15 @@ fs::path AssetManager::ConvertToPath(const fs::path& folder)
 		}
 	}
 
-	result = result / "resources" / "models" / folder;
-
 	return result;
 }
 
-fs::path AssetManager::FindGLTFByPath(const fs::path& path)
+fs::path AssetManager::FindGLTFByPath(const fs::path& path) const
 {
-	std::string ext(".gltf");
+	// Both text and binary glTF, single file GLB keeps the images inside
 	for (auto& p : fs::recursive_directory_iterator(path))
 	{
-		if (p.path().extension() == ext)
+		if (p.path().extension() == ".gltf" || p.path().extension() == ".glb")
 			return p.path();
 	}
 
@@ -1,10 +1,30 @@
 #include "../../headers/asset/asset_storage.h"
+#include "../../headers/asset/vertex_packing.h"
+#include "../../headers/asset/mesh_bounds.h"
+
+namespace
+{
+	// Host bytes of the geometry as it's stored, the mapping of the cooked mesh has the same layout
+	u64 GetGeometryBytes(const std::vector<SubmeshDescription>& submeshes)
+	{
+		u64 result = 0;
+		for (const SubmeshDescription& submesh : submeshes)
+		{
+			result += submesh.vertexDesc.vertexCount * sizeof(Vertex) + submesh.vertexDesc.indexCount * sizeof(u32) +
+				submesh.meshletDesc.meshletsCount * sizeof(Meshlet) + submesh.meshletDesc.verticesCount * sizeof(u32) +
+				submesh.meshletDesc.trianglesBytesCount + submesh.lodDesc.lodsCount * sizeof(MeshLod);
+		}
+
+		return result;
+	}
+}
 
 
 void AssetStorage::StoreVertex(const LoadedGLTF& loadedGLTF, AssetID assetID)
 {
 	StoreVertexResult result{};
 	result.desc.resize(loadedGLTF.meshes.size());
+	std::vector<SubmeshRanges>& assetRanges = _geometryRanges[assetID];
 
 	for (u32 i = 0; i < loadedGLTF.meshes.size(); ++i)
 	{
@@ -14,23 +34,43 @@ void AssetStorage::StoreVertex(const LoadedGLTF& loadedGLTF, AssetID assetID)
 
 		assert(vertexSize > 0 && indicesSize && "Trying to store some model with empty vertices/indices");
 
-		//// If storage is reallocated need to update pointers in asset manager class
-		//if (_allVertexStorage.capacity() < _allVertexStorage.size() + vertexSize)
-		//	result.shouldUpdateVertexPtrs = true;
+		// Copy only the new data, the stored ranges never move
+		SubmeshRanges ranges{};
+		ranges.vertices = _vertexArena.Store(mesh.vertex.data(), static_cast<u32>(vertexSize));
+		ranges.indices = _indicesArena.Store(mesh.indices.data(), static_cast<u32>(indicesSize));
+
+		ranges.meshlets = _meshletsArena.Store(mesh.meshlets.data(), static_cast<u32>(mesh.meshlets.size()));
+		ranges.meshletVertices = _meshletVerticesArena.Store(mesh.meshletVertices.data(), static_cast<u32>(mesh.meshletVertices.size()));
+		ranges.meshletTriangles = _meshletTrianglesArena.Store(mesh.meshletTriangles.data(), static_cast<u32>(mesh.meshletTriangles.size()));
 
-		//if (_allIndicesStorage.capacity() < _allIndicesStorage.size() + indicesSize)
-		//	result.shouldUpdateIndicesPtrs = true;
+		// Every submesh has at least LOD 0 which is the whole index range
+		const MeshLod wholeRange{ 0, static_cast<u32>(indicesSize), 0.0f };
+		if (mesh.lods.empty())
+			ranges.lods = _lodsArena.Store(&wholeRange, 1);
+		else
+			ranges.lods = _lodsArena.Store(mesh.lods.data(), static_cast<u32>(mesh.lods.size()));
 
-		// Insert all the data into storages
-		_allVertexStorage.insert(_allVertexStorage.end(), std::make_move_iterator(mesh.vertex.begin()), std::make_move_iterator(mesh.vertex.end()));
-		_allIndicesStorage.insert(_allIndicesStorage.end(), std::make_move_iterator(mesh.indices.begin()), std::make_move_iterator(mesh.indices.end()));
+		assetRanges.push_back(ranges);
 
 
 		// Store geometry data properties to retrieve them later if would need from this class.
-		result.desc[i].vertexDesc.vertexPtr = nullptr;
-		result.desc[i].vertexDesc.indicesPtr = nullptr;
+		// Meshlets are optional, the arena gives nullptr for the empty ranges
+		result.desc[i].vertexDesc.vertexPtr = _vertexArena.Get(ranges.vertices);
+		result.desc[i].vertexDesc.indicesPtr = _indicesArena.Get(ranges.indices);
 		result.desc[i].vertexDesc.vertexCount = vertexSize;
 		result.desc[i].vertexDesc.indexCount = indicesSize;
+		result.desc[i].meshletDesc.meshletsPtr = _meshletsArena.Get(ranges.meshlets);
+		result.desc[i].meshletDesc.verticesPtr = _meshletVerticesArena.Get(ranges.meshletVertices);
+		result.desc[i].meshletDesc.trianglesPtr = _meshletTrianglesArena.Get(ranges.meshletTriangles);
+		result.desc[i].meshletDesc.meshletsCount = static_cast<u32>(mesh.meshlets.size());
+		result.desc[i].meshletDesc.verticesCount = static_cast<u32>(mesh.meshletVertices.size());
+		result.desc[i].meshletDesc.trianglesBytesCount = static_cast<u32>(mesh.meshletTriangles.size());
+		result.desc[i].lodDesc.lodsPtr = _lodsArena.Get(ranges.lods);
+		result.desc[i].lodDesc.lodsCount = ranges.lods.count;
+		result.desc[i].boundingBox = mesh.boundingBox;
+		result.desc[i].boundingSphere = mesh.boundingSphere;
+		result.desc[i].vertexEncoding = mesh.vertexEncoding;
+		result.desc[i].indexType = vertexpacking::SelectIndexType(static_cast<u32>(vertexSize));
 		result.desc[i].alphaMode = mesh.alphaMode;	
 
 
@@ -40,8 +80,96 @@ void AssetStorage::StoreVertex(const LoadedGLTF& loadedGLTF, AssetID assetID)
 			_submeshesDesc.insert({ assetID, {result.desc[i]} });
 	}
 
-	
-	UpdateGeometryPropsStorage();
+	AssetResidency& residency = _residency[assetID];
+	residency.cpuBytes = GetGeometryBytes(_submeshesDesc[assetID]);
+	residency.isCpuResident = true;
+
+	_hierarchies[assetID] = loadedGLTF.hierarchy;
+	_bounds[assetID] = meshbounds::ComputeAssetBounds(_submeshesDesc[assetID], _hierarchies[assetID]);
+}
+
+void AssetStorage::StoreCookedVertex(CookedMesh& cookedMesh, AssetID assetID)
+{
+	assert(cookedMesh.file && cookedMesh.file->IsMapped() && "Trying to store cooked mesh without mapped file");
+	assert(!_submeshesDesc.contains(assetID) && "Trying to store cooked mesh for already used asset ID");
+
+	_submeshesDesc.insert({ assetID, cookedMesh.submeshes });
+	_mappedGeometry.insert({ assetID, std::move(cookedMesh.file) });
+
+	AssetResidency& residency = _residency[assetID];
+	residency.cpuBytes = GetGeometryBytes(cookedMesh.submeshes);
+	residency.isCpuResident = true;
+
+	_hierarchies[assetID] = std::move(cookedMesh.hierarchy);
+	_bounds[assetID] = meshbounds::ComputeAssetBounds(_submeshesDesc[assetID], _hierarchies[assetID]);
+}
+
+bool AssetStorage::RestoreCookedVertex(CookedMesh& cookedMesh, AssetID assetID)
+{
+	assert(cookedMesh.file && cookedMesh.file->IsMapped() && "Trying to restore geometry from cooked mesh without mapped file");
+
+	auto it = _submeshesDesc.find(assetID);
+	if (it == _submeshesDesc.end() || it->second.size() != cookedMesh.submeshes.size())
+		return false;
+
+	// Source might be changed and cooked again since the asset was stored
+	for (u32 i = 0; i < cookedMesh.submeshes.size(); ++i)
+	{
+		const SubmeshDescription& cooked = cookedMesh.submeshes[i];
+		const SubmeshDescription& stored = it->second[i];
+		if (cooked.vertexDesc.vertexCount != stored.vertexDesc.vertexCount || cooked.vertexDesc.indexCount != stored.vertexDesc.indexCount)
+			return false;
+	}
+
+	FreeGeometryRanges(assetID);
+	for (u32 i = 0; i < cookedMesh.submeshes.size(); ++i)
+	{
+		SubmeshDescription& submesh = it->second[i];
+		submesh.vertexDesc = cookedMesh.submeshes[i].vertexDesc;
+		submesh.meshletDesc = cookedMesh.submeshes[i].meshletDesc;
+		submesh.lodDesc = cookedMesh.submeshes[i].lodDesc;
+	}
+
+	_mappedGeometry[assetID] = std::move(cookedMesh.file);
+
+	AssetResidency& residency = _residency[assetID];
+	residency.cpuBytes = GetGeometryBytes(it->second);
+	residency.isCpuResident = true;
+
+	return true;
+}
+
+void AssetStorage::DropGeometry(AssetID assetID)
+{
+	auto it = _submeshesDesc.find(assetID);
+	AssetResidency& residency = _residency[assetID];
+	if (it == _submeshesDesc.end() || !residency.isCpuResident)
+		return;
+
+	// LODs are tiny and draws are built from them, they're copied to the arena before the geometry is freed
+	std::vector<SubmeshRanges> lodRanges(it->second.size());
+	for (u32 i = 0; i < it->second.size(); ++i)
+		lodRanges[i].lods = _lodsArena.Store(it->second[i].lodDesc.lodsPtr, it->second[i].lodDesc.lodsCount);
+
+	FreeGeometryRanges(assetID);
+	_mappedGeometry.erase(assetID);
+	_geometryRanges[assetID] = lodRanges;
+
+	for (u32 i = 0; i < it->second.size(); ++i)
+	{
+		SubmeshDescription& submesh = it->second[i];
+		submesh.vertexDesc.vertexPtr = nullptr;
+		submesh.vertexDesc.indicesPtr = nullptr;
+		submesh.meshletDesc.meshletsPtr = nullptr;
+		submesh.meshletDesc.verticesPtr = nullptr;
+		submesh.meshletDesc.trianglesPtr = nullptr;
+		submesh.lodDesc.lodsPtr = _lodsArena.Get(lodRanges[i].lods);
+	}
+
+	residency.cpuBytes = 0;
+	for (const SubmeshRanges& ranges : lodRanges)
+		residency.cpuBytes += ranges.lods.count * sizeof(MeshLod);
+	residency.isCpuResident = false;
 }
 
 const std::vector<SubmeshDescription>* AssetStorage::GetAssetSubmeshes(AssetID id) const
@@ -54,41 +182,72 @@ const std::vector<SubmeshDescription>* AssetStorage::GetAssetSubmeshes(AssetID i
 	return &it->second;
 }
 
-// Purpose: method to update all the pointers to the data inside of storage after reallocation
-void AssetStorage::UpdateGeometryPropsStorage()
+const ModelHierarchy* AssetStorage::GetAssetHierarchy(AssetID id) const
 {
-	size_t vertexIndex = 0;
-	size_t indicesIndex = 0;
-	for (auto& meshes : _submeshesDesc)
-	{
-		for (auto& mesh : meshes.second)
-		{
-			mesh.vertexDesc.vertexPtr  = &_allVertexStorage[vertexIndex];
-			mesh.vertexDesc.indicesPtr = &_allIndicesStorage[indicesIndex];
+	auto it = _hierarchies.find(id);
 
+	if (it == _hierarchies.end())
+		return nullptr;
 
-			vertexIndex  += mesh.vertexDesc.vertexCount;
-			indicesIndex += mesh.vertexDesc.indexCount;
+	return &it->second;
+}
 
-			assert(vertexIndex > 0 && indicesIndex > 0 && "Trying to update ptr to the data in asset storage, but some model contains <= 0 elements");
-		}
+const MeshBounds* AssetStorage::GetAssetBounds(AssetID id) const
+{
+	auto it = _bounds.find(id);
+
+	if (it == _bounds.end())
+		return nullptr;
+
+	return &it->second;
+}
+
+const AssetResidency* AssetStorage::GetAssetResidency(AssetID id) const
+{
+	auto it = _residency.find(id);
+
+	if (it == _residency.end())
+		return nullptr;
+
+	return &it->second;
+}
+
+void AssetStorage::FreeGeometryRanges(AssetID assetID)
+{
+	auto it = _geometryRanges.find(assetID);
+	if (it == _geometryRanges.end())
+		return;
+
+	for (const SubmeshRanges& ranges : it->second)
+	{
+		_vertexArena.Free(ranges.vertices);
+		_indicesArena.Free(ranges.indices);
+		_meshletsArena.Free(ranges.meshlets);
+		_meshletVerticesArena.Free(ranges.meshletVertices);
+		_meshletTrianglesArena.Free(ranges.meshletTriangles);
+		_lodsArena.Free(ranges.lods);
 	}
+
+	_geometryRanges.erase(it);
 }
 
-void AssetStorage::UpdateMaterialPropsStorage()
+void AssetStorage::RemoveAsset(AssetID assetID)
 {
-	size_t materialIndex = 0;
-	for (auto& data : _submeshesDesc)
+	FreeGeometryRanges(assetID);
+
+	if (auto it = _materialRanges.find(assetID); it != _materialRanges.end())
 	{
-		for(auto& submesh : data.second)
-		{
-			submesh.materialDesc.materialTexturesPtr = &_allCreatedMaterialsStorage[materialIndex];
-			
-			materialIndex += submesh.materialDesc.materialsCount;
+		for (const ArenaRange& range : it->second)
+			_materialsArena.Free(range);
 
-			assert(materialIndex > 0 && "Trying to update stored materials props, but some descriptor contains <= 0 elements");
-		}
+		_materialRanges.erase(it);
 	}
+
+	_submeshesDesc.erase(assetID);
+	_mappedGeometry.erase(assetID);
+	_residency.erase(assetID);
+	_hierarchies.erase(assetID);
+	_bounds.erase(assetID);
 }
 
 
@@ -98,18 +257,12 @@ void AssetStorage::StoreMeshMaterials(const std::vector<MaterialTexturesDesc>& m
 	{
 		StoreMaterialResult result{};
 
-		if (_allCreatedMaterialsStorage.capacity() < _allCreatedMaterialsStorage.size() + 1)
-		{
-			const size_t currentCapacity = _allCreatedMaterialsStorage.capacity();
-			const size_t exponentedCapacity = currentCapacity + currentCapacity / 2;
-			_allCreatedMaterialsStorage.reserve(exponentedCapacity); // to avoid a lot of reallocations
-		}
+		const ArenaRange range = _materialsArena.Store(&materialsDesc[i], 1);
+		_materialRanges[assetID].push_back(range);
 
-		result.desc.materialTexturesPtr = nullptr;
+		result.desc.materialTexturesPtr = _materialsArena.Get(range);
 		result.desc.materialsCount = 1; // 1 material per submesh
 
-		_allCreatedMaterialsStorage.push_back(materialsDesc[i]);
-
 
 		if (auto it = _submeshesDesc.find(assetID); it != _submeshesDesc.end())
 		{
@@ -133,8 +286,5 @@ void AssetStorage::StoreMeshMaterials(const std::vector<MaterialTexturesDesc>& m
 
 	}
 
-	assert(_allCreatedMaterialsStorage.size() > 0 && "Trying to store materials data for some mesh, but it is empty");
-
-	UpdateMaterialPropsStorage();
-
+	assert(!materialsDesc.empty() && "Trying to store materials data for some mesh, but it is empty");
 }
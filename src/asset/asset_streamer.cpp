@@ -0,0 +1,90 @@
+#include "../../headers/asset/asset_streamer.h"
+#include "../../headers/asset/asset_manager.h"
+
+
+namespace
+{
+	template<typename T>
+	usize FindNearest(const std::vector<T>& items, glm::vec3 viewerPosition)
+	{
+		usize nearest = 0;
+		float nearestDistance = std::numeric_limits<float>::max();
+		for (usize i = 0; i < items.size(); ++i)
+		{
+			const glm::vec3 offset = items[i].position - viewerPosition;
+			const float distance = glm::dot(offset, offset);
+			if (distance < nearestDistance)
+			{
+				nearestDistance = distance;
+				nearest = i;
+			}
+		}
+
+		return nearest;
+	}
+}
+
+AssetStreamer::AssetStreamer(const AssetManager& assetManager) : _assetManager{ assetManager }
+{
+	_worker = std::jthread([this](std::stop_token stopToken) { Work(stopToken); });
+}
+
+void AssetStreamer::Work(std::stop_token stopToken)
+{
+	while (true)
+	{
+		StreamRequest request;
+		{
+			std::unique_lock lock(_mutex);
+			if (!_requestAdded.wait(lock, stopToken, [this]() { return !_requests.empty(); }))
+				return;
+
+			// Viewer might have moved since the requests were added, so the order is decided only now
+			const usize nearest = FindNearest(_requests, _viewerPosition);
+			request = std::move(_requests[nearest]);
+			_requests.erase(_requests.begin() + nearest);
+		}
+
+		StreamedMesh streamedMesh{};
+		streamedMesh.requestID = request.id;
+		streamedMesh.position = request.position;
+		streamedMesh.preparedMesh = _assetManager.PrepareMesh(request.folder, true);
+
+		std::scoped_lock lock(_mutex);
+		_preparedMeshes.push_back(std::move(streamedMesh));
+	}
+}
+
+AssetStreamer::RequestID AssetStreamer::Enqueue(const fs::path& folder, glm::vec3 position)
+{
+	RequestID requestID = 0;
+	{
+		std::scoped_lock lock(_mutex);
+		requestID = _nextRequestID++;
+		_requests.push_back(StreamRequest{ requestID, folder, position });
+	}
+
+	_requestAdded.notify_one();
+	return requestID;
+}
+
+void AssetStreamer::SetViewerPosition(glm::vec3 position)
+{
+	std::scoped_lock lock(_mutex);
+	_viewerPosition = position;
+}
+
+std::optional<StreamedMesh> AssetStreamer::TryTakeNearest(u64 uploadBytesLimit)
+{
+	std::scoped_lock lock(_mutex);
+	if (_preparedMeshes.empty())
+		return std::nullopt;
+
+	const usize nearest = FindNearest(_preparedMeshes, _viewerPosition);
+	if (_preparedMeshes[nearest].GetUploadBytes() > uploadBytesLimit)
+		return std::nullopt;
+
+	StreamedMesh result = std::move(_preparedMeshes[nearest]);
+	_preparedMeshes.erase(_preparedMeshes.begin() + nearest);
+	return result;
+}
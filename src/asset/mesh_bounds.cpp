@@ -0,0 +1,220 @@
+#include "../../headers/asset/mesh_bounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUX_BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace meshbounds
+{
+#ifdef LUX_BOUNDS_SSE
+	// Position is followed by the normal in the vertex, so 4 floats can be loaded and the last lane is ignored
+	static_assert(offsetof(Vertex, normal) >= offsetof(Vertex, position) + sizeof(float) * 3, "Position load reads past the vertex");
+
+	inline __m128 LoadPosition(const Vertex& vertex)
+	{
+		return _mm_loadu_ps(&vertex.position.x);
+	}
+
+	inline float GetMaxLane(__m128 value)
+	{
+		value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+		value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(value);
+	}
+#endif
+
+	BoundingBox ComputeBox(std::span<const Vertex> vertices)
+	{
+		BoundingBox result{};
+		if (vertices.empty())
+			return result;
+
+#ifdef LUX_BOUNDS_SSE
+		// Two pairs of accumulators, so the next vertex doesn't wait for the previous min/max
+		__m128 min0 = LoadPosition(vertices[0]);
+		__m128 max0 = min0;
+		__m128 min1 = min0;
+		__m128 max1 = min0;
+
+		usize i = 1;
+		for (; i + 1 < vertices.size(); i += 2)
+		{
+			const __m128 position0 = LoadPosition(vertices[i]);
+			const __m128 position1 = LoadPosition(vertices[i + 1]);
+			min0 = _mm_min_ps(min0, position0);
+			max0 = _mm_max_ps(max0, position0);
+			min1 = _mm_min_ps(min1, position1);
+			max1 = _mm_max_ps(max1, position1);
+		}
+
+		if (i < vertices.size())
+		{
+			const __m128 position = LoadPosition(vertices[i]);
+			min0 = _mm_min_ps(min0, position);
+			max0 = _mm_max_ps(max0, position);
+		}
+
+		alignas(16) float minValues[4];
+		alignas(16) float maxValues[4];
+		_mm_store_ps(minValues, _mm_min_ps(min0, min1));
+		_mm_store_ps(maxValues, _mm_max_ps(max0, max1));
+
+		result.minPosition = glm::vec3(minValues[0], minValues[1], minValues[2]);
+		result.maxPosition = glm::vec3(maxValues[0], maxValues[1], maxValues[2]);
+#else
+		result.minPosition = vertices[0].position;
+		result.maxPosition = vertices[0].position;
+		for (const Vertex& vertex : vertices)
+		{
+			result.minPosition = glm::min(result.minPosition, vertex.position);
+			result.maxPosition = glm::max(result.maxPosition, vertex.position);
+		}
+#endif
+
+		return result;
+	}
+
+	BoundingSphere ComputeSphere(std::span<const Vertex> vertices, const BoundingBox& box)
+	{
+		BoundingSphere result{};
+		result.center = (box.minPosition + box.maxPosition) * 0.5f;
+
+		float maxDistanceSquared = 0.0f;
+		usize i = 0;
+
+#ifdef LUX_BOUNDS_SSE
+		// 4 vertices at once: positions are transposed into x, y and z lanes
+		const __m128 centerX = _mm_set1_ps(result.center.x);
+		const __m128 centerY = _mm_set1_ps(result.center.y);
+		const __m128 centerZ = _mm_set1_ps(result.center.z);
+		__m128 maxDistances = _mm_setzero_ps();
+
+		for (; i + 4 <= vertices.size(); i += 4)
+		{
+			__m128 x = LoadPosition(vertices[i]);
+			__m128 y = LoadPosition(vertices[i + 1]);
+			__m128 z = LoadPosition(vertices[i + 2]);
+			__m128 unused = LoadPosition(vertices[i + 3]);
+			_MM_TRANSPOSE4_PS(x, y, z, unused);
+
+			const __m128 dx = _mm_sub_ps(x, centerX);
+			const __m128 dy = _mm_sub_ps(y, centerY);
+			const __m128 dz = _mm_sub_ps(z, centerZ);
+			const __m128 distances = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			maxDistances = _mm_max_ps(maxDistances, distances);
+		}
+
+		maxDistanceSquared = GetMaxLane(maxDistances);
+#endif
+
+		for (; i < vertices.size(); ++i)
+		{
+			const glm::vec3 offset = vertices[i].position - result.center;
+			maxDistanceSquared = std::max(maxDistanceSquared, glm::dot(offset, offset));
+		}
+
+		result.radius = std::sqrt(maxDistanceSquared);
+		return result;
+	}
+
+	void ComputeBounds(LoadedMesh& mesh)
+	{
+		mesh.boundingBox = ComputeBox(mesh.vertex);
+		mesh.boundingSphere = ComputeSphere(mesh.vertex, mesh.boundingBox);
+	}
+
+	void Merge(BoundingBox& box, const BoundingBox& other)
+	{
+		box.minPosition = glm::min(box.minPosition, other.minPosition);
+		box.maxPosition = glm::max(box.maxPosition, other.maxPosition);
+	}
+
+	// Purpose: every axis of the result gets the smallest and the largest contribution of the matrix columns(Arvo)
+	BoundingBox TransformBox(const BoundingBox& box, const glm::mat4& transform)
+	{
+		BoundingBox result{};
+		result.minPosition = glm::vec3(transform[3]);
+		result.maxPosition = glm::vec3(transform[3]);
+
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			const glm::vec3 column = glm::vec3(transform[axis]);
+			const glm::vec3 a = column * box.minPosition[axis];
+			const glm::vec3 b = column * box.maxPosition[axis];
+			result.minPosition += glm::min(a, b);
+			result.maxPosition += glm::max(a, b);
+		}
+
+		return result;
+	}
+
+	BoundingSphere TransformSphere(const BoundingSphere& sphere, const glm::mat4& transform)
+	{
+		const float maxScale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+
+		BoundingSphere result{};
+		result.center = glm::vec3(transform * glm::vec4(sphere.center, 1.0f));
+		result.radius = sphere.radius * maxScale;
+		return result;
+	}
+
+	MeshBounds ComputeAssetBounds(const std::vector<SubmeshDescription>& submeshes, const ModelHierarchy& hierarchy)
+	{
+		// Placed submesh volumes, the hierarchy ones are in the model space
+		std::vector<BoundingBox> boxes;
+		std::vector<BoundingSphere> spheres;
+
+		if (hierarchy.nodes.empty())
+		{
+			for (const SubmeshDescription& submesh : submeshes)
+			{
+				boxes.push_back(submesh.boundingBox);
+				spheres.push_back(submesh.boundingSphere);
+			}
+		}
+		else
+		{
+			// Parents go first, as in the renderer
+			std::vector<glm::mat4> modelTransforms(hierarchy.nodes.size());
+			for (usize i = 0; i < hierarchy.nodes.size(); ++i)
+			{
+				const ModelNode& node = hierarchy.nodes[i];
+				modelTransforms[i] = node.parent == ModelNode::NoParent ? node.localTransform : modelTransforms[node.parent] * node.localTransform;
+
+				if (node.mesh == ModelNode::NoMesh)
+					continue;
+
+				const MeshSubmeshRange& range = hierarchy.meshes[node.mesh];
+				for (u32 submesh = range.firstSubmesh; submesh < range.firstSubmesh + range.submeshCount && submesh < submeshes.size(); ++submesh)
+				{
+					boxes.push_back(TransformBox(submeshes[submesh].boundingBox, modelTransforms[i]));
+					spheres.push_back(TransformSphere(submeshes[submesh].boundingSphere, modelTransforms[i]));
+				}
+			}
+		}
+
+		MeshBounds result{};
+		if (boxes.empty())
+			return result;
+
+		result.boundingBox = boxes[0];
+		for (const BoundingBox& box : boxes)
+			Merge(result.boundingBox, box);
+
+		// Sphere around the merged box is enough, but the submesh spheres might give a tighter one
+		const glm::vec3 center = (result.boundingBox.minPosition + result.boundingBox.maxPosition) * 0.5f;
+		float radius = 0.0f;
+		for (const BoundingSphere& sphere : spheres)
+			radius = std::max(radius, glm::length(sphere.center - center) + sphere.radius);
+
+		result.boundingSphere.center = center;
+		result.boundingSphere.radius = std::min(radius, glm::length(result.boundingBox.maxPosition - center));
+		return result;
+	}
+}
@@ -0,0 +1,566 @@
+#include "../../headers/asset/mesh_cache.h"
+#include "../../headers/asset/vertex_packing.h"
+#include "../../headers/util/helpers.h"
+
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+// On disk layout of the .luxmesh file: header, submeshes, vertices, indices, meshlets, meshlet vertices, meshlet triangles, LODs,
+// materials and the node hierarchy.
+// Sections are 16 bytes aligned, so the mapped data can be used in place
+namespace luxmesh
+{
+	constexpr u64 SectionAlignment{ 16 };
+
+	struct FileHeader
+	{
+		u32 magic{ 0 };
+		u32 version{ 0 };
+		u64 sourceHash{ 0 };
+		i64 sourceMtime{ 0 };
+
+		u32 vertexStride{ 0 }; // sizeof(Vertex) when cooked, layout change invalidates the file
+		u32 submeshCount{ 0 };
+		u32 materialCount{ 0 };
+		u32 pad{ 0 };
+
+		u64 vertexCount{ 0 };
+		u64 indexCount{ 0 };
+		u64 meshletCount{ 0 };
+		u64 meshletVertexCount{ 0 };
+		u64 meshletTrianglesBytes{ 0 };
+		u64 lodCount{ 0 };
+
+		u64 submeshesOffset{ 0 };
+		u64 verticesOffset{ 0 };
+		u64 indicesOffset{ 0 };
+		u64 meshletsOffset{ 0 };
+		u64 meshletVerticesOffset{ 0 };
+		u64 meshletTrianglesOffset{ 0 };
+		u64 lodsOffset{ 0 };
+		u64 materialsOffset{ 0 };
+		u64 fileSize{ 0 };
+	};
+
+	struct CookedSubmesh
+	{
+		u64 firstVertex{ 0 };
+		u64 firstIndex{ 0 };
+		u64 firstMeshlet{ 0 };
+		u64 firstMeshletVertex{ 0 };
+		u64 firstMeshletTriangle{ 0 };
+		u64 firstLod{ 0 };
+		u32 vertexCount{ 0 };
+		u32 indexCount{ 0 };
+		u32 meshletCount{ 0 };
+		u32 meshletVertexCount{ 0 };
+		u32 meshletTrianglesBytes{ 0 };
+		u32 lodCount{ 0 };
+		u32 materialIndex{ 0 };
+		float alphaCutoff{ 0.0f };
+		glm::vec3 positionScale{ glm::vec3(1.0f) };
+		glm::vec3 positionOffset{ glm::vec3(0.0f) };
+		BoundingSphere boundingSphere{};
+		BoundingBox boundingBox{};
+		u8 alphaType{ 0 };
+		u8 quantizedPosition{ 0 };
+		u8 unormUV{ 0 };
+		u8 pad[5]{};
+	};
+
+	static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is written to the cooked file as is");
+	static_assert(std::is_trivially_copyable_v<Meshlet>, "Meshlet is written to the cooked file as is");
+	static_assert(std::is_trivially_copyable_v<MeshLod>, "MeshLod is written to the cooked file as is");
+
+	// Submesh without generated levels still gets LOD 0, so the loaded one always has at least one
+	inline std::vector<MeshLod> GetSubmeshLods(const LoadedMesh& mesh)
+	{
+		if (mesh.lods.empty())
+			return { MeshLod{ 0, static_cast<u32>(mesh.indices.size()), 0.0f } };
+
+		return mesh.lods;
+	}
+
+	inline u64 AlignUp(u64 value, u64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Purpose: bounds checked reading of the mapped data
+	struct Reader
+	{
+		const byte* data{ nullptr };
+		u64 size{ 0 };
+		u64 offset{ 0 };
+		bool isValid{ true };
+
+		template<typename T>
+		T Read()
+		{
+			T value{};
+			if (!isValid || offset + sizeof(T) > size)
+			{
+				isValid = false;
+				return value;
+			}
+
+			std::memcpy(&value, data + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		const byte* ReadBytes(u64 bytesCount)
+		{
+			if (!isValid || offset + bytesCount > size)
+			{
+				isValid = false;
+				return nullptr;
+			}
+
+			const byte* result = data + offset;
+			offset += bytesCount;
+			return result;
+		}
+	};
+
+	template<typename T>
+	void Write(std::vector<byte>& out, const T& value)
+	{
+		const byte* bytes = reinterpret_cast<const byte*>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	void SerializeMaterial(std::vector<byte>& out, const MeshMaterial& material)
+	{
+		Write(out, material.baseColorFactor);
+		Write(out, material.metallicFactor);
+		Write(out, material.roughnessFactor);
+		Write(out, static_cast<u32>(material.materialTextures.size()));
+
+		for (const auto& texture : material.materialTextures)
+		{
+			const std::string path = texture.path.generic_string();
+
+			Write(out, static_cast<u8>(texture.dataType));
+			Write(out, static_cast<u8>(texture.textureType));
+			Write(out, texture.factor);
+			Write(out, static_cast<u32>(path.size()));
+			out.insert(out.end(), path.begin(), path.end());
+			Write(out, texture.byteOffset);
+			Write(out, texture.byteLength);
+			Write(out, static_cast<u64>(texture.bytes.size()));
+			out.insert(out.end(), texture.bytes.begin(), texture.bytes.end());
+		}
+	}
+
+	bool DeserializeMaterial(Reader& reader, MeshMaterial& material)
+	{
+		material.baseColorFactor = reader.Read<glm::vec3>();
+		material.metallicFactor = reader.Read<float>();
+		material.roughnessFactor = reader.Read<float>();
+
+		const u32 texturesCount = reader.Read<u32>();
+		for (u32 i = 0; i < texturesCount && reader.isValid; ++i)
+		{
+			TexturesData texture{};
+			texture.dataType = static_cast<TexturesData::Type>(reader.Read<u8>());
+			texture.textureType = static_cast<TextureType>(reader.Read<u8>());
+			texture.factor = reader.Read<float>();
+
+			const u32 pathLength = reader.Read<u32>();
+			const byte* path = reader.ReadBytes(pathLength);
+			if (path)
+				texture.path = std::string(reinterpret_cast<const char*>(path), pathLength);
+
+			texture.byteOffset = reader.Read<u64>();
+			texture.byteLength = reader.Read<u64>();
+
+			const u64 bytesCount = reader.Read<u64>();
+			const byte* bytes = reader.ReadBytes(bytesCount);
+			if (bytes)
+				texture.bytes.assign(bytes, bytes + bytesCount);
+
+			material.materialTextures.push_back(std::move(texture));
+		}
+
+		return reader.isValid;
+	}
+
+	void SerializeHierarchy(std::vector<byte>& out, const ModelHierarchy& hierarchy)
+	{
+		Write(out, static_cast<u32>(hierarchy.meshes.size()));
+		for (const MeshSubmeshRange& range : hierarchy.meshes)
+			Write(out, range);
+
+		Write(out, static_cast<u32>(hierarchy.nodes.size()));
+		for (const ModelNode& node : hierarchy.nodes)
+		{
+			Write(out, node.localTransform);
+			Write(out, node.parent);
+			Write(out, node.mesh);
+			Write(out, static_cast<u32>(node.name.size()));
+			out.insert(out.end(), node.name.begin(), node.name.end());
+		}
+	}
+
+	// Ranges and parents are checked, so the hierarchy is safe to walk
+	bool DeserializeHierarchy(Reader& reader, u32 submeshCount, ModelHierarchy& hierarchy)
+	{
+		const u32 meshesCount = reader.Read<u32>();
+		for (u32 i = 0; i < meshesCount && reader.isValid; ++i)
+		{
+			const MeshSubmeshRange range = reader.Read<MeshSubmeshRange>();
+			if (static_cast<u64>(range.firstSubmesh) + range.submeshCount > submeshCount)
+				return false;
+
+			hierarchy.meshes.push_back(range);
+		}
+
+		const u32 nodesCount = reader.Read<u32>();
+		for (u32 i = 0; i < nodesCount && reader.isValid; ++i)
+		{
+			ModelNode node{};
+			node.localTransform = reader.Read<glm::mat4>();
+			node.parent = reader.Read<u32>();
+			node.mesh = reader.Read<u32>();
+			if ((node.parent != ModelNode::NoParent && node.parent >= i) || (node.mesh != ModelNode::NoMesh && node.mesh >= meshesCount))
+				return false;
+
+			const u32 nameLength = reader.Read<u32>();
+			const byte* name = reader.ReadBytes(nameLength);
+			if (name)
+				node.name.assign(reinterpret_cast<const char*>(name), nameLength);
+
+			hierarchy.nodes.push_back(std::move(node));
+		}
+
+		return reader.isValid;
+	}
+}
+
+
+fs::path MeshCache::GetCookedPath(const fs::path& sourcePath)
+{
+	fs::path result = sourcePath;
+	result.replace_extension(".luxmesh");
+	return result;
+}
+
+// Purpose: the .gltf file and all the buffers next to it. Sorted so the hash doesn't depend on the directory order
+std::vector<fs::path> MeshCache::GetSourceFiles(const fs::path& sourcePath) const
+{
+	std::vector<fs::path> result{ sourcePath };
+
+	std::error_code error;
+	for (const auto& entry : fs::directory_iterator(sourcePath.parent_path(), error))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".bin")
+			result.push_back(entry.path());
+	}
+
+	std::sort(result.begin() + 1, result.end());
+	return result;
+}
+
+i64 MeshCache::GetSourceMtime(const std::vector<fs::path>& sourceFiles) const
+{
+	i64 result = std::numeric_limits<i64>::min(); // file clock epoch is implementation defined, counts might be negative
+	for (const auto& file : sourceFiles)
+	{
+		std::error_code error;
+		const auto writeTime = fs::last_write_time(file, error);
+		if (!error)
+			result = std::max<i64>(result, writeTime.time_since_epoch().count());
+	}
+
+	return result;
+}
+
+u64 MeshCache::GetSourceHash(const std::vector<fs::path>& sourceFiles) const
+{
+	u64 hash = helpers::HashBytes(nullptr, 0);
+	for (const auto& file : sourceFiles)
+	{
+		MappedFile mapped(file);
+		if (mapped.IsMapped())
+			hash = helpers::HashBytes(mapped.GetData(), mapped.GetSize(), hash);
+	}
+
+	return hash;
+}
+
+bool MeshCache::Write(const fs::path& sourcePath, const LoadedGLTF& loadedGLTF) const
+{
+	using namespace luxmesh;
+
+	const std::vector<fs::path> sourceFiles = GetSourceFiles(sourcePath);
+
+	FileHeader header{};
+	header.magic = Magic;
+	header.version = Version;
+	header.sourceHash = GetSourceHash(sourceFiles);
+	header.sourceMtime = GetSourceMtime(sourceFiles);
+	header.vertexStride = sizeof(Vertex);
+	header.submeshCount = static_cast<u32>(loadedGLTF.meshes.size());
+	header.materialCount = static_cast<u32>(loadedGLTF.materials.size());
+
+	std::vector<CookedSubmesh> submeshes(loadedGLTF.meshes.size());
+	for (u32 i = 0; i < loadedGLTF.meshes.size(); ++i)
+	{
+		const auto& mesh = loadedGLTF.meshes[i];
+
+		submeshes[i].firstVertex = header.vertexCount;
+		submeshes[i].firstIndex = header.indexCount;
+		submeshes[i].vertexCount = static_cast<u32>(mesh.vertex.size());
+		submeshes[i].indexCount = static_cast<u32>(mesh.indices.size());
+		submeshes[i].firstMeshlet = header.meshletCount;
+		submeshes[i].firstMeshletVertex = header.meshletVertexCount;
+		submeshes[i].firstMeshletTriangle = header.meshletTrianglesBytes;
+		submeshes[i].meshletCount = static_cast<u32>(mesh.meshlets.size());
+		submeshes[i].meshletVertexCount = static_cast<u32>(mesh.meshletVertices.size());
+		submeshes[i].meshletTrianglesBytes = static_cast<u32>(mesh.meshletTriangles.size());
+		submeshes[i].firstLod = header.lodCount;
+		submeshes[i].lodCount = static_cast<u32>(GetSubmeshLods(mesh).size());
+		submeshes[i].boundingSphere = mesh.boundingSphere;
+		submeshes[i].boundingBox = mesh.boundingBox;
+		submeshes[i].materialIndex = mesh.materialIndex;
+		submeshes[i].alphaCutoff = mesh.alphaMode.alphaCutoff;
+		submeshes[i].alphaType = static_cast<u8>(mesh.alphaMode.type);
+		submeshes[i].positionScale = mesh.vertexEncoding.positionScale;
+		submeshes[i].positionOffset = mesh.vertexEncoding.positionOffset;
+		submeshes[i].quantizedPosition = mesh.vertexEncoding.quantizedPosition ? 1 : 0;
+		submeshes[i].unormUV = mesh.vertexEncoding.unormUV ? 1 : 0;
+
+		header.vertexCount += mesh.vertex.size();
+		header.indexCount += mesh.indices.size();
+		header.meshletCount += mesh.meshlets.size();
+		header.meshletVertexCount += mesh.meshletVertices.size();
+		header.meshletTrianglesBytes += mesh.meshletTriangles.size();
+		header.lodCount += submeshes[i].lodCount;
+	}
+
+	std::vector<byte> materialsBlob;
+	for (const auto& material : loadedGLTF.materials)
+		SerializeMaterial(materialsBlob, material);
+	SerializeHierarchy(materialsBlob, loadedGLTF.hierarchy);
+
+	header.submeshesOffset = AlignUp(sizeof(FileHeader), SectionAlignment);
+	header.verticesOffset = AlignUp(header.submeshesOffset + submeshes.size() * sizeof(CookedSubmesh), SectionAlignment);
+	header.indicesOffset = AlignUp(header.verticesOffset + header.vertexCount * sizeof(Vertex), SectionAlignment);
+	header.meshletsOffset = AlignUp(header.indicesOffset + header.indexCount * sizeof(u32), SectionAlignment);
+	header.meshletVerticesOffset = AlignUp(header.meshletsOffset + header.meshletCount * sizeof(Meshlet), SectionAlignment);
+	header.meshletTrianglesOffset = AlignUp(header.meshletVerticesOffset + header.meshletVertexCount * sizeof(u32), SectionAlignment);
+	header.lodsOffset = AlignUp(header.meshletTrianglesOffset + header.meshletTrianglesBytes, SectionAlignment);
+	header.materialsOffset = AlignUp(header.lodsOffset + header.lodCount * sizeof(MeshLod), SectionAlignment);
+	header.fileSize = header.materialsOffset + materialsBlob.size();
+
+	// Written to the temporary file first, so the interrupted write never leaves a broken cache
+	const fs::path cookedPath = GetCookedPath(sourcePath);
+	fs::path tempPath = cookedPath;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Failed to create cooked mesh file: " << tempPath << '\n';
+			return false;
+		}
+
+		const auto pad = [&file](u64 offset)
+			{
+				static constexpr char zeros[SectionAlignment]{};
+				const u64 current = static_cast<u64>(file.tellp());
+				file.write(zeros, static_cast<std::streamsize>(offset - current));
+			};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		pad(header.submeshesOffset);
+		file.write(reinterpret_cast<const char*>(submeshes.data()), static_cast<std::streamsize>(submeshes.size() * sizeof(CookedSubmesh)));
+
+		pad(header.verticesOffset);
+		for (const auto& mesh : loadedGLTF.meshes)
+			file.write(reinterpret_cast<const char*>(mesh.vertex.data()), static_cast<std::streamsize>(mesh.vertex.size() * sizeof(Vertex)));
+
+		pad(header.indicesOffset);
+		for (const auto& mesh : loadedGLTF.meshes)
+			file.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(u32)));
+
+		pad(header.meshletsOffset);
+		for (const auto& mesh : loadedGLTF.meshes)
+			file.write(reinterpret_cast<const char*>(mesh.meshlets.data()), static_cast<std::streamsize>(mesh.meshlets.size() * sizeof(Meshlet)));
+
+		pad(header.meshletVerticesOffset);
+		for (const auto& mesh : loadedGLTF.meshes)
+			file.write(reinterpret_cast<const char*>(mesh.meshletVertices.data()), static_cast<std::streamsize>(mesh.meshletVertices.size() * sizeof(u32)));
+
+		pad(header.meshletTrianglesOffset);
+		for (const auto& mesh : loadedGLTF.meshes)
+			file.write(reinterpret_cast<const char*>(mesh.meshletTriangles.data()), static_cast<std::streamsize>(mesh.meshletTriangles.size()));
+
+		pad(header.lodsOffset);
+		for (const auto& mesh : loadedGLTF.meshes)
+		{
+			const std::vector<MeshLod> lods = GetSubmeshLods(mesh);
+			file.write(reinterpret_cast<const char*>(lods.data()), static_cast<std::streamsize>(lods.size() * sizeof(MeshLod)));
+		}
+
+		pad(header.materialsOffset);
+		file.write(reinterpret_cast<const char*>(materialsBlob.data()), static_cast<std::streamsize>(materialsBlob.size()));
+
+		if (!file)
+		{
+			std::cout << "Failed to write cooked mesh file: " << tempPath << '\n';
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(tempPath, cookedPath, error);
+	if (error)
+	{
+		std::cout << "Failed to store cooked mesh file: " << cookedPath << ", " << error.message() << '\n';
+		fs::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+std::optional<CookedMesh> MeshCache::TryLoad(const fs::path& sourcePath) const
+{
+	using namespace luxmesh;
+
+	const fs::path cookedPath = GetCookedPath(sourcePath);
+	if (!fs::exists(cookedPath))
+		return std::nullopt;
+
+	// Header is read without the mapping, so it can be restamped in place when only the write time is changed
+	FileHeader header{};
+	{
+		std::ifstream file(cookedPath, std::ios::binary);
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!file || header.magic != Magic || header.version != Version || header.vertexStride != sizeof(Vertex))
+			return std::nullopt;
+	}
+
+	const std::vector<fs::path> sourceFiles = GetSourceFiles(sourcePath);
+	const i64 sourceMtime = GetSourceMtime(sourceFiles);
+	if (header.sourceMtime != sourceMtime)
+	{
+		if (header.sourceHash != GetSourceHash(sourceFiles))
+			return std::nullopt;
+
+		// Content is the same, restamp to skip hashing next time
+		header.sourceMtime = sourceMtime;
+		std::fstream file(cookedPath, std::ios::binary | std::ios::in | std::ios::out);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+
+	CookedMesh result{};
+	result.file = std::make_unique<MappedFile>(cookedPath);
+	const MappedFile& mapped = *result.file;
+	if (!mapped.IsMapped() || mapped.GetSize() != header.fileSize)
+	{
+		std::cout << "Cooked mesh file is corrupted: " << cookedPath << '\n';
+		return std::nullopt;
+	}
+
+	const byte* data = mapped.GetData();
+	const auto sectionFits = [&header](u64 offset, u64 size) { return offset % SectionAlignment == 0 && offset + size <= header.fileSize; };
+	if (!sectionFits(header.submeshesOffset, header.submeshCount * sizeof(CookedSubmesh)) ||
+		!sectionFits(header.verticesOffset, header.vertexCount * sizeof(Vertex)) ||
+		!sectionFits(header.indicesOffset, header.indexCount * sizeof(u32)) ||
+		!sectionFits(header.meshletsOffset, header.meshletCount * sizeof(Meshlet)) ||
+		!sectionFits(header.meshletVerticesOffset, header.meshletVertexCount * sizeof(u32)) ||
+		!sectionFits(header.meshletTrianglesOffset, header.meshletTrianglesBytes) ||
+		!sectionFits(header.lodsOffset, header.lodCount * sizeof(MeshLod)) ||
+		!sectionFits(header.materialsOffset, 0))
+	{
+		std::cout << "Cooked mesh file is corrupted: " << cookedPath << '\n';
+		return std::nullopt;
+	}
+
+	const auto* submeshes = reinterpret_cast<const CookedSubmesh*>(data + header.submeshesOffset);
+	const auto* vertices = reinterpret_cast<const Vertex*>(data + header.verticesOffset);
+	const auto* indices = reinterpret_cast<const u32*>(data + header.indicesOffset);
+	const auto* meshlets = reinterpret_cast<const Meshlet*>(data + header.meshletsOffset);
+	const auto* meshletVertices = reinterpret_cast<const u32*>(data + header.meshletVerticesOffset);
+	const auto* meshletTriangles = data + header.meshletTrianglesOffset;
+	const auto* lods = reinterpret_cast<const MeshLod*>(data + header.lodsOffset);
+
+	// Levels end up in the draw commands, every one has to stay in the indices of its submesh
+	const auto lodsFit = [lods](const CookedSubmesh& cooked)
+		{
+			return std::all_of(lods + cooked.firstLod, lods + cooked.firstLod + cooked.lodCount, [&cooked](const MeshLod& lod)
+				{ return static_cast<u64>(lod.firstIndex) + lod.indexCount <= cooked.indexCount; });
+		};
+
+	result.submeshes.resize(header.submeshCount);
+	result.submeshMaterials.resize(header.submeshCount);
+	for (u32 i = 0; i < header.submeshCount; ++i)
+	{
+		const CookedSubmesh& cooked = submeshes[i];
+		if (cooked.firstVertex + cooked.vertexCount > header.vertexCount ||
+			cooked.firstIndex + cooked.indexCount > header.indexCount ||
+			cooked.firstMeshlet + cooked.meshletCount > header.meshletCount ||
+			cooked.firstMeshletVertex + cooked.meshletVertexCount > header.meshletVertexCount ||
+			cooked.firstMeshletTriangle + cooked.meshletTrianglesBytes > header.meshletTrianglesBytes ||
+			cooked.lodCount == 0 || cooked.lodCount > LodDescription::MaxLodsCount ||
+			cooked.firstLod + cooked.lodCount > header.lodCount || !lodsFit(cooked) ||
+			cooked.materialIndex >= header.materialCount ||
+			cooked.alphaType > static_cast<u8>(AlphaMode::AlphaType::ALPHA_MASK)) // blend isn't cooked, it has no batch to draw it
+		{
+			std::cout << "Cooked mesh file is corrupted: " << cookedPath << '\n';
+			return std::nullopt;
+		}
+
+		SubmeshDescription& desc = result.submeshes[i];
+		desc.vertexDesc.vertexPtr = vertices + cooked.firstVertex;
+		desc.vertexDesc.vertexCount = cooked.vertexCount;
+		desc.vertexDesc.indicesPtr = indices + cooked.firstIndex;
+		desc.vertexDesc.indexCount = cooked.indexCount;
+		desc.meshletDesc.meshletsPtr = cooked.meshletCount > 0 ? meshlets + cooked.firstMeshlet : nullptr;
+		desc.meshletDesc.meshletsCount = cooked.meshletCount;
+		desc.meshletDesc.verticesPtr = cooked.meshletVertexCount > 0 ? meshletVertices + cooked.firstMeshletVertex : nullptr;
+		desc.meshletDesc.verticesCount = cooked.meshletVertexCount;
+		desc.meshletDesc.trianglesPtr = cooked.meshletTrianglesBytes > 0 ? meshletTriangles + cooked.firstMeshletTriangle : nullptr;
+		desc.meshletDesc.trianglesBytesCount = cooked.meshletTrianglesBytes;
+		desc.lodDesc.lodsPtr = lods + cooked.firstLod;
+		desc.lodDesc.lodsCount = cooked.lodCount;
+		desc.boundingSphere = cooked.boundingSphere;
+		desc.boundingBox = cooked.boundingBox;
+		desc.alphaMode.type = static_cast<AlphaMode::AlphaType>(cooked.alphaType);
+		desc.alphaMode.alphaCutoff = cooked.alphaCutoff;
+		desc.vertexEncoding.positionScale = cooked.positionScale;
+		desc.vertexEncoding.positionOffset = cooked.positionOffset;
+		desc.vertexEncoding.quantizedPosition = cooked.quantizedPosition != 0;
+		desc.vertexEncoding.unormUV = cooked.unormUV != 0;
+		desc.indexType = vertexpacking::SelectIndexType(cooked.vertexCount);
+
+		result.submeshMaterials[i] = cooked.materialIndex;
+	}
+
+	Reader reader{ data, header.fileSize, header.materialsOffset };
+	result.materials.resize(header.materialCount);
+	for (u32 i = 0; i < header.materialCount; ++i)
+	{
+		if (!DeserializeMaterial(reader, result.materials[i]))
+		{
+			std::cout << "Cooked mesh file is corrupted: " << cookedPath << '\n';
+			return std::nullopt;
+		}
+
+		result.materials[i].materialIndex = i;
+	}
+
+	if (!DeserializeHierarchy(reader, header.submeshCount, result.hierarchy))
+	{
+		std::cout << "Cooked mesh file is corrupted: " << cookedPath << '\n';
+		return std::nullopt;
+	}
+
+	return result;
+}
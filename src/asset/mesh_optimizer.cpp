@@ -0,0 +1,308 @@
+#include "../../headers/asset/mesh_optimizer.h"
+#include "../../headers/util/helpers.h"
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+
+MeshOptimizer::PassStatistics& MeshOptimizer::PassStatistics::operator+=(const PassStatistics& other)
+{
+	verticesCount += other.verticesCount;
+	trianglesCount += other.trianglesCount;
+	verticesTransformed += other.verticesTransformed;
+	pixelsCovered += other.pixelsCovered;
+	pixelsShaded += other.pixelsShaded;
+	meshletsCount += other.meshletsCount;
+	for (u32 i = 0; i < lodTrianglesCount.size(); ++i)
+		lodTrianglesCount[i] += other.lodTrianglesCount[i];
+
+	return *this;
+}
+
+void MeshOptimizer::Optimize(LoadedGLTF& loadedGLTF) const
+{
+	std::vector<MeshStatistics> meshesStatistics(loadedGLTF.meshes.size());
+	helpers::ParallelFor(static_cast<u32>(loadedGLTF.meshes.size()), [&](u32 i)
+		{
+			OptimizeMesh(loadedGLTF.meshes[i], meshesStatistics[i]);
+		});
+
+	if (!_settings.reportStatistics)
+		return;
+
+	MeshStatistics totalStatistics{};
+	for (const auto& meshStatistics : meshesStatistics)
+	{
+		for (u32 pass = 0; pass < totalStatistics.size(); ++pass)
+			totalStatistics[pass] += meshStatistics[pass];
+	}
+
+	ReportStatistics(totalStatistics);
+}
+
+void MeshOptimizer::OptimizeMesh(LoadedMesh& mesh, MeshStatistics& statistics) const
+{
+	assert(mesh.indices.size() % 3 == 0 && "Trying to optimize mesh which isn't a triangle list");
+	if (mesh.indices.empty() || mesh.vertex.empty())
+		return;
+
+	const usize indexCount = mesh.indices.size();
+	const auto passResult = [this, &mesh, &statistics](OptimizationPass pass, bool isExecuted)
+		{
+			const u32 current = static_cast<u32>(pass);
+			if (!_settings.reportStatistics)
+				return;
+
+			// Skipped pass doesn't change anything
+			statistics[current] = isExecuted ? AnalyzeMesh(mesh) : statistics[current - 1];
+		};
+
+	passResult(OptimizationPass::PASS_SOURCE, true);
+
+	if (_settings.weldVertices)
+	{
+		std::vector<u32> remap(mesh.vertex.size());
+		const usize uniqueVertexCount = meshopt_generateVertexRemap(remap.data(), mesh.indices.data(), indexCount,
+			mesh.vertex.data(), mesh.vertex.size(), sizeof(Vertex));
+
+		meshopt_remapIndexBuffer(mesh.indices.data(), mesh.indices.data(), indexCount, remap.data());
+		meshopt_remapVertexBuffer(mesh.vertex.data(), mesh.vertex.data(), mesh.vertex.size(), sizeof(Vertex), remap.data());
+		mesh.vertex.resize(uniqueVertexCount);
+	}
+	passResult(OptimizationPass::PASS_WELD, _settings.weldVertices);
+
+	if (_settings.optimizeVertexCache)
+		meshopt_optimizeVertexCache(mesh.indices.data(), mesh.indices.data(), indexCount, mesh.vertex.size());
+	passResult(OptimizationPass::PASS_VERTEX_CACHE, _settings.optimizeVertexCache);
+
+	// Transparent triangles are drawn in their order, so only opaque ones might be reordered
+	const bool shouldOptimizeOverdraw = _settings.optimizeOverdraw && mesh.alphaMode.type == AlphaMode::AlphaType::ALPHA_OPAQUE;
+	if (shouldOptimizeOverdraw)
+	{
+		meshopt_optimizeOverdraw(mesh.indices.data(), mesh.indices.data(), indexCount,
+			&mesh.vertex[0].position.x, mesh.vertex.size(), sizeof(Vertex), _settings.overdrawThreshold);
+	}
+	passResult(OptimizationPass::PASS_OVERDRAW, shouldOptimizeOverdraw);
+
+	// Must be the last one, it reorders vertices in the order of the indices
+	if (_settings.optimizeVertexFetch)
+	{
+		const usize usedVertexCount = meshopt_optimizeVertexFetch(mesh.vertex.data(), mesh.indices.data(), indexCount,
+			mesh.vertex.data(), mesh.vertex.size(), sizeof(Vertex));
+		mesh.vertex.resize(usedVertexCount);
+	}
+	passResult(OptimizationPass::PASS_VERTEX_FETCH, _settings.optimizeVertexFetch);
+
+	// Meshlets reference the final vertices, so they're built after all the reordering
+	if (_settings.buildMeshlets)
+	{
+		BuildMeshlets(mesh);
+		statistics.back().meshletsCount = mesh.meshlets.size();
+
+		if (_settings.validateMeshlets && !ValidateMeshlets(mesh))
+		{
+			std::cout << "Meshlets don't match the index buffer, they're discarded\n";
+			mesh.meshlets.clear();
+			mesh.meshletVertices.clear();
+			mesh.meshletTriangles.clear();
+		}
+	}
+
+	// Appends the levels to the indices, so it goes after everything which works with LOD 0 only
+	if (_settings.generateLods)
+	{
+		GenerateLods(mesh);
+		for (u32 i = 0; i < mesh.lods.size(); ++i)
+			statistics.back().lodTrianglesCount[i] = mesh.lods[i].indexCount / 3;
+	}
+}
+
+// Purpose: every level is simplified from LOD 0, so its error is the real deviation from the source mesh.
+// Vertices are shared by all the levels, only indices are generated
+void MeshOptimizer::GenerateLods(LoadedMesh& mesh) const
+{
+	const u32 sourceIndexCount = static_cast<u32>(mesh.indices.size());
+	const float meshScale = meshopt_simplifyScale(&mesh.vertex[0].position.x, mesh.vertex.size(), sizeof(Vertex));
+
+	mesh.lods.clear();
+	mesh.lods.push_back(MeshLod{ 0, sourceIndexCount, 0.0f });
+
+	const u32 lodsCount = std::min<u32>(_settings.lodsCount, LodDescription::MaxLodsCount - 1);
+	std::vector<u32> lodIndices(sourceIndexCount);
+	for (u32 i = 0; i < lodsCount; ++i)
+	{
+		const usize targetIndexCount = static_cast<usize>(sourceIndexCount * _settings.lodIndexRatios[i]) / 3 * 3;
+		if (targetIndexCount < 3)
+			break;
+
+		float resultError = 0.0f;
+		const usize lodIndexCount = meshopt_simplify(lodIndices.data(), mesh.indices.data(), sourceIndexCount,
+			&mesh.vertex[0].position.x, mesh.vertex.size(), sizeof(Vertex), targetIndexCount, _settings.lodTargetErrors[i], 0, &resultError);
+
+		// Error target is reached before the ratio, next levels wouldn't be much better
+		const u32 previousIndexCount = mesh.lods.back().indexCount;
+		if (lodIndexCount == 0 || lodIndexCount > previousIndexCount * 9 / 10)
+			break;
+
+		meshopt_optimizeVertexCache(lodIndices.data(), lodIndices.data(), lodIndexCount, mesh.vertex.size());
+
+		MeshLod lod{};
+		lod.firstIndex = static_cast<u32>(mesh.indices.size());
+		lod.indexCount = static_cast<u32>(lodIndexCount);
+		lod.error = resultError * meshScale;
+		mesh.lods.push_back(lod);
+
+		mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.begin() + lodIndexCount);
+	}
+}
+
+void MeshOptimizer::BuildMeshlets(LoadedMesh& mesh) const
+{
+	const usize indexCount = mesh.indices.size();
+	const usize maxMeshlets = meshopt_buildMeshletsBound(indexCount, _settings.maxMeshletVertices, _settings.maxMeshletTriangles);
+
+	std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+	mesh.meshletVertices.resize(maxMeshlets * _settings.maxMeshletVertices);
+	mesh.meshletTriangles.resize(maxMeshlets * _settings.maxMeshletTriangles * 3);
+
+	const usize meshletsCount = meshopt_buildMeshlets(meshlets.data(), mesh.meshletVertices.data(), mesh.meshletTriangles.data(),
+		mesh.indices.data(), indexCount, &mesh.vertex[0].position.x, mesh.vertex.size(), sizeof(Vertex),
+		_settings.maxMeshletVertices, _settings.maxMeshletTriangles, _settings.meshletConeWeight);
+
+	if (meshletsCount == 0)
+	{
+		mesh.meshletVertices.clear();
+		mesh.meshletTriangles.clear();
+		return;
+	}
+
+	// Trim to the last meshlet, its triangles are padded to 4 bytes to keep the next offsets aligned
+	const meshopt_Meshlet& last = meshlets[meshletsCount - 1];
+	mesh.meshletVertices.resize(last.vertex_offset + last.vertex_count);
+	mesh.meshletTriangles.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3u));
+
+	mesh.meshlets.resize(meshletsCount);
+	for (usize i = 0; i < meshletsCount; ++i)
+	{
+		const meshopt_Meshlet& source = meshlets[i];
+		const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&mesh.meshletVertices[source.vertex_offset],
+			&mesh.meshletTriangles[source.triangle_offset], source.triangle_count,
+			&mesh.vertex[0].position.x, mesh.vertex.size(), sizeof(Vertex));
+
+		Meshlet& meshlet = mesh.meshlets[i];
+		meshlet.center = glm::vec3(bounds.center[0], bounds.center[1], bounds.center[2]);
+		meshlet.radius = bounds.radius;
+		meshlet.coneAxis = glm::vec3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]);
+		meshlet.coneCutoff = bounds.cone_cutoff;
+		meshlet.coneApex = glm::vec3(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]);
+		meshlet.vertexOffset = source.vertex_offset;
+		meshlet.triangleOffset = source.triangle_offset;
+		meshlet.vertexCount = source.vertex_count;
+		meshlet.triangleCount = source.triangle_count;
+	}
+}
+
+// Purpose: every triangle of the index buffer must be in exactly one meshlet. Meshlets might rotate the triangle
+// vertices, so triangles are compared starting from the smallest index which keeps the winding
+bool MeshOptimizer::ValidateMeshlets(const LoadedMesh& mesh) const
+{
+	using Triangle = std::array<u32, 3>;
+	const auto normalize = [](u32 a, u32 b, u32 c) -> Triangle
+		{
+			if (a <= b && a <= c)
+				return { a, b, c };
+			if (b <= a && b <= c)
+				return { b, c, a };
+			return { c, a, b };
+		};
+
+	std::vector<Triangle> sourceTriangles;
+	sourceTriangles.reserve(mesh.indices.size() / 3);
+	for (usize i = 0; i + 2 < mesh.indices.size(); i += 3)
+		sourceTriangles.push_back(normalize(mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]));
+
+	std::vector<Triangle> meshletTriangles;
+	meshletTriangles.reserve(sourceTriangles.size());
+	for (const Meshlet& meshlet : mesh.meshlets)
+	{
+		if (meshlet.vertexOffset + meshlet.vertexCount > mesh.meshletVertices.size() ||
+			meshlet.triangleOffset + meshlet.triangleCount * 3 > mesh.meshletTriangles.size() ||
+			meshlet.vertexCount > _settings.maxMeshletVertices || meshlet.triangleCount > _settings.maxMeshletTriangles)
+			return false;
+
+		const u32* vertices = &mesh.meshletVertices[meshlet.vertexOffset];
+		const u8* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+		for (u32 i = 0; i < meshlet.triangleCount * 3; i += 3)
+		{
+			if (triangles[i] >= meshlet.vertexCount || triangles[i + 1] >= meshlet.vertexCount || triangles[i + 2] >= meshlet.vertexCount)
+				return false;
+
+			meshletTriangles.push_back(normalize(vertices[triangles[i]], vertices[triangles[i + 1]], vertices[triangles[i + 2]]));
+		}
+	}
+
+	std::sort(sourceTriangles.begin(), sourceTriangles.end());
+	std::sort(meshletTriangles.begin(), meshletTriangles.end());
+
+	return sourceTriangles == meshletTriangles;
+}
+
+MeshOptimizer::PassStatistics MeshOptimizer::AnalyzeMesh(const LoadedMesh& mesh) const
+{
+	const usize indexCount = mesh.indices.size();
+
+	const meshopt_VertexCacheStatistics cacheStatistics = meshopt_analyzeVertexCache(mesh.indices.data(), indexCount,
+		mesh.vertex.size(), _settings.statisticsCacheSize, 0, 0);
+
+	const meshopt_OverdrawStatistics overdrawStatistics = meshopt_analyzeOverdraw(mesh.indices.data(), indexCount,
+		&mesh.vertex[0].position.x, mesh.vertex.size(), sizeof(Vertex));
+
+	PassStatistics result{};
+	result.verticesCount = mesh.vertex.size();
+	result.trianglesCount = indexCount / 3;
+	result.verticesTransformed = cacheStatistics.vertices_transformed;
+	result.pixelsCovered = overdrawStatistics.pixels_covered;
+	result.pixelsShaded = overdrawStatistics.pixels_shaded;
+
+	return result;
+}
+
+// Purpose: ACMR - transformed vertices per triangle, ATVR - transformed vertices per vertex(1.0 is the best),
+// overdraw - shaded pixels per covered pixel. All of them are for the whole model
+void MeshOptimizer::ReportStatistics(const MeshStatistics& statistics) const
+{
+	static constexpr std::array<const char*, static_cast<u32>(OptimizationPass::PASS_COUNT)> passNames =
+	{
+		"source", "weld", "vertex cache", "overdraw", "vertex fetch"
+	};
+
+	const auto ratio = [](u64 numerator, u64 denominator)
+		{
+			return denominator == 0 ? 0.0 : static_cast<double>(numerator) / static_cast<double>(denominator);
+		};
+
+	std::cout << "Mesh optimization statistics:\n";
+	for (u32 pass = 0; pass < statistics.size(); ++pass)
+	{
+		const PassStatistics& current = statistics[pass];
+		std::cout << "\t" << passNames[pass]
+			<< ": vertices " << current.verticesCount
+			<< ", ACMR " << ratio(current.verticesTransformed, current.trianglesCount)
+			<< ", ATVR " << ratio(current.verticesTransformed, current.verticesCount)
+			<< ", overdraw " << ratio(current.pixelsShaded, current.pixelsCovered) << '\n';
+	}
+
+	if (_settings.buildMeshlets)
+		std::cout << "\tmeshlets: " << statistics.back().meshletsCount << '\n';
+
+	if (_settings.generateLods)
+	{
+		std::cout << "\tLOD triangles:";
+		for (u64 trianglesCount : statistics.back().lodTrianglesCount)
+		{
+			if (trianglesCount > 0)
+				std::cout << ' ' << trianglesCount;
+		}
+		std::cout << '\n';
+	}
+}
@@ -1,9 +1,13 @@
 #include "../../headers/asset/model_importer.h"
+#include "../../headers/asset/mesh_bounds.h"
+#include "../../headers/util/helpers.h"
 
 #include <fastgltf/core.hpp>
 #include <fastgltf/types.hpp>
 #include <fastgltf/tools.hpp>
 
+#include <cstring>
+
 LoadedGLTF ModelImporter::LoadGltf(const fs::path& path)
 {
 	LoadedGLTF gltfData; // by default is unloaded so can return
@@ -40,252 +44,381 @@ LoadedGLTF ModelImporter::LoadGltf(const fs::path& path)
 		return gltfData;
 	}
 
-	if (!LoadMeshes(asset.get(), gltfData))
+
+	ImageSourceFile sourceFile{};
+	sourceFile.fileName = path.filename();
+	sourceFile.glbBinaryOffset = FindGlbBinaryChunk(path);
+
+	if (!LoadMeshes(asset.get(), sourceFile, gltfData))
 		return gltfData;
-	
+
+	LoadHierarchy(asset.get(), gltfData.hierarchy);
+
 	gltfData.isLoaded = true;
 	return gltfData;
 }
 
-void ModelImporter::StoreTextureData(const fastgltf::Image& image, TexturesData& InTexture)
+// Purpose: offset of the binary chunk data in the GLB file, nullopt for the .gltf one
+std::optional<u64> ModelImporter::FindGlbBinaryChunk(const fs::path& path)
 {
+	constexpr u32 glbMagic{ 0x46546C67 }; // 'glTF'
+	constexpr u32 jsonChunkType{ 0x4E4F534A }; // 'JSON'
+	constexpr u32 binaryChunkType{ 0x004E4942 }; // 'BIN'
+	constexpr u64 headerSize{ 12 };
+	constexpr u64 chunkHeaderSize{ 8 };
+
+	std::ifstream file(path, std::ios::binary);
+	u32 header[3]{};
+	u32 jsonChunk[2]{};
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	file.read(reinterpret_cast<char*>(jsonChunk), sizeof(jsonChunk));
+	if (!file || header[0] != glbMagic || jsonChunk[1] != jsonChunkType)
+		return std::nullopt;
+
+	const u64 binaryChunkOffset = headerSize + chunkHeaderSize + jsonChunk[0];
+	u32 binaryChunk[2]{};
+	file.seekg(static_cast<std::streamoff>(binaryChunkOffset));
+	file.read(reinterpret_cast<char*>(binaryChunk), sizeof(binaryChunk));
+	if (!file || binaryChunk[1] != binaryChunkType)
+		return std::nullopt;
+
+	return binaryChunkOffset + chunkHeaderSize;
+}
+
+// Images of the GLB binary chunk are referenced by their range in the file and decoded right from its mapping later.
+// Only the ones which don't exist in the file as is are copied
+void ModelImporter::StoreTextureData(const fastgltf::Asset& asset, const ImageSourceFile& sourceFile, const fastgltf::Image& image, TexturesData& InTexture)
+{
+	const auto copyBytes = [&InTexture](const auto& bytes)
+		{
+			const u8* data = reinterpret_cast<const u8*>(bytes.data());
+			InTexture.bytes.assign(data, data + bytes.size());
+			InTexture.dataType = TexturesData::Type::EMBEDDED;
+		};
+
 	std::visit(fastgltf::visitor{
-	[](auto& arg) {},
-		[&](fastgltf::sources::URI filePath)
+	[](auto& arg) { std::cout << "Unsupported image source\n"; },
+		[&](const fastgltf::sources::URI& filePath)
 			{
 				assert(filePath.uri.isLocalPath());
 				// index is 0. change later
 				InTexture.path = fs::path(filePath.uri.path().begin(), filePath.uri.path().end());
 				InTexture.dataType = TexturesData::Type::URI;
 			},
-		[&](fastgltf::sources::Array array)
-			{
-				std::cout << "IT WORKS\n";
-				/*gltfData.textures.push_back(LoadedTexture{LoadedTexture::Type::EMBEDDED, 0, "", array.bytes});*/
-			},
-		[&](fastgltf::sources::BufferView view)
+		[&](const fastgltf::sources::Array& array) { copyBytes(array.bytes); },
+		[&](const fastgltf::sources::Vector& vector) { copyBytes(vector.bytes); },
+		[&](const fastgltf::sources::BufferView& view)
 			{
-				std::cout << "IT WORKS\n";
-			}	
+				const auto& bufferView = asset.bufferViews[view.bufferViewIndex];
+				if (bufferView.bufferIndex == 0 && sourceFile.glbBinaryOffset.has_value())
+				{
+					InTexture.path = sourceFile.fileName;
+					InTexture.byteOffset = sourceFile.glbBinaryOffset.value() + bufferView.byteOffset;
+					InTexture.byteLength = bufferView.byteLength;
+					InTexture.dataType = TexturesData::Type::EMBEDDED;
+				}
+				else // external buffer is loaded into memory, its file isn't known here anymore
+					copyBytes(fastgltf::DefaultBufferDataAdapter{}(asset, view.bufferViewIndex));
+			}
 	}, image.data);
 }
 
-// This system works only for one mesh for now. To add a support of multiple meshes need to account some kind of indices.
-// It's good for the purpose of this engine for now: to learn graphics techniques
-bool ModelImporter::LoadMeshes(const fastgltf::Asset& asset, LoadedGLTF& gltfData)
+// Purpose: decode one primitive into its own mesh, attributes are copied in bulk right into the interleaved vertices
+bool ModelImporter::DecodePrimitive(const fastgltf::Asset& asset, const fastgltf::Primitive& primitive, LoadedMesh& mesh) const
 {
-	for (u32 i = 0; i < asset.meshes.size(); ++i)
+	static_assert(sizeof(fastgltf::math::fvec4) == sizeof(glm::vec4) && sizeof(fastgltf::math::fvec3) == sizeof(glm::vec3) &&
+		sizeof(fastgltf::math::fvec2) == sizeof(glm::vec2), "fastgltf vectors must match glm ones to copy them directly into the Vertex");
+
+	auto* positionIt = primitive.findAttribute("POSITION");
+	assert(positionIt != primitive.attributes.end());
+	assert(primitive.indicesAccessor.has_value()); // Mesh MUST have indices
+
+	auto& positionAccessor = asset.accessors[positionIt->accessorIndex];
+	if (!positionAccessor.bufferViewIndex.has_value())
+		return false;
+
+	auto& meshVertex = mesh.vertex;
+	meshVertex.resize(positionAccessor.count); // normal, tangent and UV are zero if they're not present
+
+	fastgltf::copyFromAccessor<fastgltf::math::fvec3, sizeof(Vertex)>(asset, positionAccessor, &meshVertex[0].position);
+	SetSourcePositionGrid(positionAccessor, mesh.vertexEncoding);
+
+	size_t baseColorTexCoordIdx = 0;
+	if (primitive.materialIndex.has_value())
 	{
-		u32 j = 0;
-		for (auto it = asset.meshes[i].primitives.begin(); it != asset.meshes[i].primitives.end(); ++it)
+		auto& baseColorTex = asset.materials[primitive.materialIndex.value()].pbrData.baseColorTexture;
+		if (baseColorTex.has_value())
 		{
-			gltfData.meshes.resize(gltfData.meshes.size() + 1);
+			if (baseColorTex->transform && baseColorTex->transform->texCoordIndex.has_value())
+				baseColorTexCoordIdx = baseColorTex->transform->texCoordIndex.value();
+			else
+				baseColorTexCoordIdx = baseColorTex->texCoordIndex;
+		}
+	}
 
-			auto& meshVertex = gltfData.meshes[j].vertex;
-			auto& meshIndices = gltfData.meshes[j].indices;
+	auto texCoordAttribute = std::string("TEXCOORD_") + std::to_string(baseColorTexCoordIdx);
+	if (const auto* texCoordIt = primitive.findAttribute(texCoordAttribute); texCoordIt != primitive.attributes.end())
+	{
+		auto& texCoordAccessor = asset.accessors[texCoordIt->accessorIndex];
+		if (!texCoordAccessor.bufferViewIndex.has_value())
+			return false;
 
-			auto* positionIt = it->findAttribute("POSITION");	
-			assert(positionIt != it->attributes.end());
-			assert(it->indicesAccessor.has_value()); // Mesh MUST have indices
+		fastgltf::copyFromAccessor<fastgltf::math::fvec2, sizeof(Vertex)>(asset, texCoordAccessor, &meshVertex[0].UV);
+	}
 
-			auto& positionAccessor = asset.accessors[positionIt->accessorIndex];
-			if (!positionAccessor.bufferViewIndex.has_value())
-				continue;
+	auto* normalIt = primitive.findAttribute("NORMAL");
+	assert(normalIt != primitive.attributes.end()); // Mesh must have normals
 
-			// IMPORTANT
-			//const size_t vertexOffset = meshVertex.size();
-			meshVertex.resize(positionAccessor.count);
+	auto& normalAccesor = asset.accessors[normalIt->accessorIndex];
+	if (!normalAccesor.bufferViewIndex.has_value())
+		return false;
 
-		
-			fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec3>(asset, positionAccessor, [&](fastgltf::math::fvec3 pos, size_t index)
-				{
-					meshVertex[index].position = glm::vec3(pos.x(), pos.y(), pos.z());
-					meshVertex[index].normal = glm::vec3();    
-					meshVertex[index].tangent = glm::vec3();   // left it empty in case it doesn't present
-					meshVertex[index].UV = glm::vec2();
-				});
+	fastgltf::copyFromAccessor<fastgltf::math::fvec3, sizeof(Vertex)>(asset, normalAccesor, &meshVertex[0].normal);
 
-			size_t baseColorTexCoordIdx = 0;
+	// for now MUST have tangents
+	auto* tangentIt = primitive.findAttribute("TANGENT");
+	assert(tangentIt != primitive.attributes.end());
 
-			if (it->materialIndex.has_value())
-			{
-				auto& material = asset.materials[it->materialIndex.value()];
-		
-				// Albedo
-				auto& baseColorTex = material.pbrData.baseColorTexture;
-				if (baseColorTex.has_value())
-				{
-					auto& texture = asset.textures[baseColorTex->textureIndex];
-					if (!texture.imageIndex.has_value())
-						return false;
-
-					if (baseColorTex->transform && baseColorTex->transform->texCoordIndex.has_value()) {
-						baseColorTexCoordIdx = baseColorTex->transform->texCoordIndex.value();
-					}
-					else {
-						baseColorTexCoordIdx = material.pbrData.baseColorTexture->texCoordIndex;
-					}
-				}
+	auto& tangentAccesor = asset.accessors[tangentIt->accessorIndex];
+	if (!tangentAccesor.bufferViewIndex.has_value())
+		return false;
 
-				const u32 materialIndex = it->materialIndex.has_value() ? it->materialIndex.value() : 0;
+	fastgltf::copyFromAccessor<fastgltf::math::fvec4, sizeof(Vertex)>(asset, tangentAccesor, &meshVertex[0].tangent);
 
-				bool isMaterialAlreadyStored = false;
-				for (const auto& material : gltfData.materials)
-				{
-					if (material.materialIndex == materialIndex)
-						isMaterialAlreadyStored = true;
-				}
+	auto& indicesAccessor = asset.accessors[primitive.indicesAccessor.value()];
+	if (!indicesAccessor.bufferViewIndex.has_value())
+		return false;
 
-				if (!isMaterialAlreadyStored)
-				{
-					// Normal
-					auto& normalTex = material.normalTexture;
-					// MetallicRoughness
-					auto& metallicRoughnessTex = material.pbrData.metallicRoughnessTexture;
+	// don't care about size, would assume every index is u32
+	mesh.indices.resize(indicesAccessor.count);
+	fastgltf::copyFromAccessor<u32>(asset, indicesAccessor, mesh.indices.data());
 
-					MeshMaterial meshMaterial;
-					// To verify it. Basically retrieve a path or data for texture and load it later in the asset manager
-					if (baseColorTex.has_value())
-					{
-						auto& baseColorTexture = asset.textures[baseColorTex->textureIndex];
+	return true;
+}
 
-						if (baseColorTexture.imageIndex.has_value())
-						{
-							const auto& image = asset.images[baseColorTexture.imageIndex.value()];
-							TexturesData baseTexReference;
-							baseTexReference.textureType = TextureType::TEXTURE_ALBEDO;
+// Purpose: KHR_mesh_quantization positions are integers already. Their grid is kept, so packing gets
+// exactly the source values back instead of quantizing them again in the mesh bounds
+void ModelImporter::SetSourcePositionGrid(const fastgltf::Accessor& accessor, VertexEncoding& encoding) const
+{
+	u32 bits = 0;
+	bool isSigned = false;
+	switch (accessor.componentType)
+	{
+	case fastgltf::ComponentType::Byte:          bits = 8;  isSigned = true;  break;
+	case fastgltf::ComponentType::UnsignedByte:  bits = 8;  isSigned = false; break;
+	case fastgltf::ComponentType::Short:         bits = 16; isSigned = true;  break;
+	case fastgltf::ComponentType::UnsignedShort: bits = 16; isSigned = false; break;
+	default: return; // float
+	}
 
-							StoreTextureData(image, baseTexReference);
+	// Stored value is shifted to be unsigned: position = (quantized + minValue) / divisor
+	const float minValue = isSigned ? -static_cast<float>(1u << (bits - 1)) : 0.0f;
+	const float maxValue = isSigned ? static_cast<float>((1u << (bits - 1)) - 1) : static_cast<float>((1u << bits) - 1);
+	const float divisor = accessor.normalized ? maxValue : 1.0f;
 
-							meshMaterial.materialTextures.emplace_back(std::move(baseTexReference));
+	encoding.quantizedPosition = true;
+	encoding.positionScale = glm::vec3(1.0f / divisor);
+	encoding.positionOffset = glm::vec3(minValue / divisor);
+}
 
-							const auto& fBaseFactor = material.pbrData.baseColorFactor;
+MeshMaterial ModelImporter::LoadMaterial(const fastgltf::Asset& asset, const ImageSourceFile& sourceFile, const fastgltf::Material& material, u32 materialIndex)
+{
+	MeshMaterial meshMaterial;
+	meshMaterial.materialIndex = materialIndex;
+
+	// Albedo
+	auto& baseColorTex = material.pbrData.baseColorTexture;
+	// Normal
+	auto& normalTex = material.normalTexture;
+	// MetallicRoughness
+	auto& metallicRoughnessTex = material.pbrData.metallicRoughnessTexture;
+
+	// To verify it. Basically retrieve a path or data for texture and load it later in the asset manager
+	if (baseColorTex.has_value())
+	{
+		auto& baseColorTexture = asset.textures[baseColorTex->textureIndex];
 
-							meshMaterial.baseColorFactor = glm::vec3(fBaseFactor.x(), fBaseFactor.y(), fBaseFactor.z());
-						}
-					}
+		if (baseColorTexture.imageIndex.has_value())
+		{
+			const auto& image = asset.images[baseColorTexture.imageIndex.value()];
+			TexturesData baseTexReference;
+			baseTexReference.textureType = TextureType::TEXTURE_ALBEDO;
 
-					if (normalTex.has_value())
-					{
-						auto& normalTexture = asset.textures[normalTex->textureIndex];
-						if (normalTexture.imageIndex.has_value())
-						{
-							const auto& image = asset.images[normalTexture.imageIndex.value()];
-							TexturesData normalTexReference;
-							normalTexReference.textureType = TextureType::TEXTURE_NORMAL;
+			StoreTextureData(asset, sourceFile, image, baseTexReference);
 
-							StoreTextureData(image, normalTexReference);
+			meshMaterial.materialTextures.emplace_back(std::move(baseTexReference));
 
-							meshMaterial.materialTextures.emplace_back(std::move(normalTexReference));
+			const auto& fBaseFactor = material.pbrData.baseColorFactor;
 
-						}
-					}
+			meshMaterial.baseColorFactor = glm::vec3(fBaseFactor.x(), fBaseFactor.y(), fBaseFactor.z());
+		}
+	}
 
-					if (metallicRoughnessTex.has_value())
-					{
-						auto& metallicRoughnessTexture = asset.textures[metallicRoughnessTex->textureIndex];
+	if (normalTex.has_value())
+	{
+		auto& normalTexture = asset.textures[normalTex->textureIndex];
+		if (normalTexture.imageIndex.has_value())
+		{
+			const auto& image = asset.images[normalTexture.imageIndex.value()];
+			TexturesData normalTexReference;
+			normalTexReference.textureType = TextureType::TEXTURE_NORMAL;
 
-						if (metallicRoughnessTexture.imageIndex.has_value())
-						{
-							const auto& image = asset.images[metallicRoughnessTexture.imageIndex.value()];
-							TexturesData metallicRoughnessTexReference;
-							metallicRoughnessTexReference.textureType = TextureType::TEXTURE_METALLICROUGHNESS;
+			StoreTextureData(asset, sourceFile, image, normalTexReference);
 
-							StoreTextureData(image, metallicRoughnessTexReference);
+			meshMaterial.materialTextures.emplace_back(std::move(normalTexReference));
+		}
+	}
 
+	if (metallicRoughnessTex.has_value())
+	{
+		auto& metallicRoughnessTexture = asset.textures[metallicRoughnessTex->textureIndex];
 
-							meshMaterial.materialTextures.emplace_back(std::move(metallicRoughnessTexReference));
+		if (metallicRoughnessTexture.imageIndex.has_value())
+		{
+			const auto& image = asset.images[metallicRoughnessTexture.imageIndex.value()];
+			TexturesData metallicRoughnessTexReference;
+			metallicRoughnessTexReference.textureType = TextureType::TEXTURE_METALLICROUGHNESS;
 
-							meshMaterial.metallicFactor  = material.pbrData.metallicFactor;
-							meshMaterial.roughnessFactor = material.pbrData.roughnessFactor;
- 
-						}
-					}
+			StoreTextureData(asset, sourceFile, image, metallicRoughnessTexReference);
 
-					auto& meshAlphaMode = gltfData.meshes[j].alphaMode;
-					switch (material.alphaMode)
-					{
-					case fastgltf::AlphaMode::Opaque:
-						meshAlphaMode.type = AlphaMode::AlphaType::ALPHA_OPAQUE;
-						break;
+			meshMaterial.materialTextures.emplace_back(std::move(metallicRoughnessTexReference));
 
-					case fastgltf::AlphaMode::Mask:
-						meshAlphaMode.type = AlphaMode::AlphaType::ALPHA_MASK;
-						break;
+			meshMaterial.metallicFactor  = material.pbrData.metallicFactor;
+			meshMaterial.roughnessFactor = material.pbrData.roughnessFactor;
+		}
+	}
 
-					case fastgltf::AlphaMode::Blend:
-						meshAlphaMode.type = AlphaMode::AlphaType::ALPHA_MASK; /// FOR NOW LIKE THAT BECAUSE HALF TRANSPARENT OBJECTS ARE NOT SUPPORTED!!!!!!
-						break;
+	return meshMaterial;
+}
 
-					default: std::unreachable();
-					}
+// Primitives are decoded in parallel, every one into its own LoadedMesh. Materials are discovered after that
+// on this thread in the primitives order, so the result doesn't depend on the scheduling
+bool ModelImporter::LoadMeshes(const fastgltf::Asset& asset, const ImageSourceFile& sourceFile, LoadedGLTF& gltfData)
+{
+	std::vector<const fastgltf::Primitive*> primitives;
+	std::vector<u32> primitiveMeshes; // glTF mesh of every primitive
+	for (u32 meshIndex = 0; meshIndex < asset.meshes.size(); ++meshIndex)
+	{
+		for (const auto& primitive : asset.meshes[meshIndex].primitives)
+		{
+			primitives.push_back(&primitive);
+			primitiveMeshes.push_back(meshIndex);
+		}
+	}
 
-					// Store alpha mode of the object to separate them later by type: opaque, mask, blend(TO DO)
-					meshAlphaMode.alphaCutoff = material.alphaCutoff;
+	// Primitives of one mesh stay together, the ones which failed to decode are just not counted
+	gltfData.hierarchy.meshes.assign(asset.meshes.size(), MeshSubmeshRange{});
 
-					gltfData.materials.emplace_back(std::move(meshMaterial));
-				}
-			}
+	std::vector<LoadedMesh> decodedMeshes(primitives.size());
+	std::vector<u8> isDecoded(primitives.size(), false); // not vector<bool>, every task writes its own element
 
-			
-			auto texCoordAttribute = std::string("TEXCOORD_") + std::to_string(baseColorTexCoordIdx);
-			if (const auto* texCoordIt = it->findAttribute(texCoordAttribute); texCoordIt != it->attributes.end())
-			{
-				auto& texCoordAccessor = asset.accessors[texCoordIt->accessorIndex];
+	helpers::ParallelFor(static_cast<u32>(primitives.size()), [&](u32 i)
+		{
+			isDecoded[i] = DecodePrimitive(asset, *primitives[i], decodedMeshes[i]);
+			if (isDecoded[i])
+				meshbounds::ComputeBounds(decodedMeshes[i]);
+		});
 
-				if (!texCoordAccessor.bufferViewIndex.has_value())
-					continue;
+	constexpr u32 noMaterial = std::numeric_limits<u32>::max();
+	std::unordered_map<u32, u32> gltfToLoadedMaterial; // glTF material index -> index in gltfData.materials
 
-				fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec2>(asset, texCoordAccessor, [&](fastgltf::math::fvec2 uv, std::size_t index) {
-						meshVertex[index].UV = glm::vec2(uv.x(), uv.y());
-					});
-			}
+	for (size_t i = 0; i < primitives.size(); ++i)
+	{
+		if (!isDecoded[i])
+			continue;
 
-			// Iterate for normals
-			auto* normalIt = it->findAttribute("NORMAL");
-			assert(normalIt != it->attributes.end()); // Mesh must have normals
-			
-			auto& normalAccesor = asset.accessors[normalIt->accessorIndex];
-			if (!normalAccesor.bufferViewIndex.has_value())
-				continue;
+		LoadedMesh& mesh = decodedMeshes[i];
+		const fastgltf::Primitive& primitive = *primitives[i];
 
-			fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec3>(asset, normalAccesor, [&](fastgltf::math::fvec3 normal, size_t index)
-				{
-					meshVertex[index].normal = glm::vec3(normal.x(), normal.y(), normal.z());
-				});
+		const u32 gltfMaterialIndex = primitive.materialIndex.has_value() ? static_cast<u32>(primitive.materialIndex.value()) : noMaterial;
 
-			// Iterate for tangents
-			auto* tangentIt = it->findAttribute("TANGENT");
-			assert(tangentIt != it->attributes.end());
+		if (auto it = gltfToLoadedMaterial.find(gltfMaterialIndex); it != gltfToLoadedMaterial.end())
+			mesh.materialIndex = it->second;
+		else
+		{
+			mesh.materialIndex = static_cast<u32>(gltfData.materials.size());
+			gltfToLoadedMaterial.insert({ gltfMaterialIndex, mesh.materialIndex });
 
-			// for now MUST have tangents
-			auto& tangentAccesor = asset.accessors[tangentIt->accessorIndex];
-			if (!tangentAccesor.bufferViewIndex.has_value())
-				continue;
+			if (gltfMaterialIndex != noMaterial)
+			{
+				const auto& material = asset.materials[gltfMaterialIndex];
 
-			fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec4>(asset, tangentAccesor, [&](fastgltf::math::fvec4 tangent, size_t index)
-				{
-					meshVertex[index].tangent = glm::vec3(tangent.x(), tangent.y(), tangent.z());
-				});
+				auto& baseColorTex = material.pbrData.baseColorTexture;
+				if (baseColorTex.has_value() && !asset.textures[baseColorTex->textureIndex].imageIndex.has_value())
+					return false;
 
-	
-			auto& indicesAccessor = asset.accessors[it->indicesAccessor.value()];
-			if (!indicesAccessor.bufferViewIndex.has_value())
-				return false;
-			// don't care about size, would assume every index is u32
-			std::vector<u32> tempIndices(indicesAccessor.count);
-
-			fastgltf::copyFromAccessor<u32>(asset, indicesAccessor, tempIndices.data());
-			/*for (u32& index : tempIndices)
+				gltfData.materials.emplace_back(LoadMaterial(asset, sourceFile, material, gltfMaterialIndex));
+			}
+			else
+				gltfData.materials.emplace_back(); // default one without textures
+		}
+
+		if (gltfMaterialIndex != noMaterial)
+		{
+			const auto& material = asset.materials[gltfMaterialIndex];
+			switch (material.alphaMode)
 			{
-				index += static_cast<u32>(vertexOffset);
-			}*/
-			meshIndices.insert(meshIndices.end(), std::make_move_iterator(tempIndices.begin()), std::make_move_iterator(tempIndices.end()));
+			case fastgltf::AlphaMode::Opaque:
+				mesh.alphaMode.type = AlphaMode::AlphaType::ALPHA_OPAQUE;
+				break;
+
+			case fastgltf::AlphaMode::Mask:
+				mesh.alphaMode.type = AlphaMode::AlphaType::ALPHA_MASK;
+				break;
+
+			case fastgltf::AlphaMode::Blend:
+				mesh.alphaMode.type = AlphaMode::AlphaType::ALPHA_MASK; /// FOR NOW LIKE THAT BECAUSE HALF TRANSPARENT OBJECTS ARE NOT SUPPORTED!!!!!!
+				break;
 
-			// increment current submesh index
-			++j;
+			default: std::unreachable();
+			}
+
+			// Store alpha mode of the object to separate them later by type: opaque, mask, blend(TO DO)
+			mesh.alphaMode.alphaCutoff = material.alphaCutoff;
 		}
+
+		MeshSubmeshRange& meshRange = gltfData.hierarchy.meshes[primitiveMeshes[i]];
+		if (meshRange.submeshCount == 0)
+			meshRange.firstSubmesh = static_cast<u32>(gltfData.meshes.size());
+		++meshRange.submeshCount;
+
+		gltfData.meshes.emplace_back(std::move(mesh));
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+// Purpose: nodes of the default scene parents first. glTF node has one parent at most, so it's a tree(or several)
+void ModelImporter::LoadHierarchy(const fastgltf::Asset& asset, ModelHierarchy& hierarchy) const
+{
+	if (asset.scenes.empty())
+		return;
+
+	const fastgltf::Scene& scene = asset.scenes[asset.defaultScene.value_or(0)];
+
+	// glTF node index and the index of its parent in hierarchy.nodes
+	std::vector<std::pair<usize, u32>> nodesToVisit;
+	for (auto it = scene.nodeIndices.rbegin(); it != scene.nodeIndices.rend(); ++it)
+		nodesToVisit.emplace_back(*it, ModelNode::NoParent);
+
+	while (!nodesToVisit.empty())
+	{
+		const auto [gltfNodeIndex, parent] = nodesToVisit.back();
+		nodesToVisit.pop_back();
+
+		const fastgltf::Node& node = asset.nodes[gltfNodeIndex];
+		const fastgltf::math::fmat4x4 localTransform = fastgltf::getTransformMatrix(node);
+
+		ModelNode modelNode{};
+		modelNode.name.assign(node.name.begin(), node.name.end());
+		std::memcpy(&modelNode.localTransform, localTransform.data(), sizeof(glm::mat4)); // both are column major
+		modelNode.parent = parent;
+		modelNode.mesh = node.meshIndex.has_value() ? static_cast<u32>(node.meshIndex.value()) : ModelNode::NoMesh;
+
+		const u32 nodeIndex = static_cast<u32>(hierarchy.nodes.size());
+		hierarchy.nodes.push_back(std::move(modelNode));
+
+		for (auto it = node.children.rbegin(); it != node.children.rend(); ++it)
+			nodesToVisit.emplace_back(*it, nodeIndex);
+	}
+}
@@ -0,0 +1,77 @@
+#include "../../headers/asset/texture_cache.h"
+
+
+std::string TextureCache::GetCanonicalKey(const fs::path& path)
+{
+	std::error_code error;
+	const fs::path canonical = fs::weakly_canonical(path, error);
+	return error ? path.lexically_normal().generic_string() : canonical.generic_string();
+}
+
+std::string TextureCache::GetTypedKey(const std::string& sourceKey, TextureType type)
+{
+	return sourceKey + '@' + std::to_string(static_cast<u32>(type));
+}
+
+u32 TextureCache::FindByKey(const std::string& key) const
+{
+	auto it = _indexByKey.find(key);
+	return it != _indexByKey.end() ? it->second : 0;
+}
+
+u32 TextureCache::FindByHash(u64 contentHash, TextureType type, const std::string& key)
+{
+	auto it = _indexByHash.find({ contentHash, type });
+	if (it == _indexByHash.end())
+		return 0;
+
+	if (_indexByKey.insert({ key, it->second }).second)
+		_textures[it->second].keys.push_back(key);
+
+	return it->second;
+}
+
+void TextureCache::Insert(const std::string& key, u64 contentHash, TextureType type, u32 bindlessIndex)
+{
+	assert(bindlessIndex != 0 && "Trying to cache texture with the reserved index");
+	assert(!_textures.contains(bindlessIndex) && "Trying to cache texture with already used index");
+
+	CachedTexture texture{};
+	texture.contentHash = contentHash;
+	texture.type = type;
+	texture.keys.push_back(key);
+	_textures.insert({ bindlessIndex, std::move(texture) });
+
+	_indexByKey.insert({ key, bindlessIndex });
+	_indexByHash.insert({ { contentHash, type }, bindlessIndex });
+}
+
+void TextureCache::AddReference(u32 bindlessIndex)
+{
+	auto it = _textures.find(bindlessIndex);
+	assert(it != _textures.end() && "Trying to reference texture which isn't cached");
+
+	++it->second.refCount;
+}
+
+bool TextureCache::Release(u32 bindlessIndex)
+{
+	auto it = _textures.find(bindlessIndex);
+	assert(it != _textures.end() && it->second.refCount > 0 && "Trying to release texture which isn't referenced");
+
+	if (--it->second.refCount > 0)
+		return false;
+
+	for (const auto& key : it->second.keys)
+		_indexByKey.erase(key);
+	_indexByHash.erase({ it->second.contentHash, it->second.type });
+	_textures.erase(it);
+
+	return true;
+}
+
+u32 TextureCache::GetReferenceCount(u32 bindlessIndex) const
+{
+	auto it = _textures.find(bindlessIndex);
+	return it != _textures.end() ? it->second.refCount : 0;
+}
@@ -0,0 +1,545 @@
+#include "../../headers/asset/texture_compressor.h"
+#include "../../headers/util/helpers.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace blockcompression
+{
+	constexpr u32 BlockPixels{ 16 };
+	constexpr u64 LevelAlignment{ 16 };
+
+	// Weights of the second endpoint for 4 bit BC7 indices, out of 64
+	constexpr std::array<u32, 16> BC7Weights{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Weights of the second endpoint for BC1 indices in the 4 colors mode
+	constexpr std::array<float, 4> BC1Weights{ 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	using BlockColors = std::array<glm::vec4, BlockPixels>;
+
+	u64 AlignUp(u64 value, u64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Purpose: block bits are filled from the lowest bit of the first byte, the data must be zeroed
+	class BitWriter
+	{
+	private:
+		u8* _data{ nullptr };
+		u32 _position{ 0 };
+	public:
+		BitWriter(u8* data) : _data(data) {}
+
+		void Write(u32 value, u32 bitsCount)
+		{
+			for (u32 i = 0; i < bitsCount; ++i, ++_position)
+			{
+				if ((value >> i) & 1)
+					_data[_position / 8] |= static_cast<u8>(1u << (_position % 8));
+			}
+		}
+	};
+
+	BlockColors LoadColors(const u8* pixels, bool withAlpha)
+	{
+		BlockColors result{};
+		for (u32 i = 0; i < BlockPixels; ++i)
+			result[i] = glm::vec4(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2], withAlpha ? pixels[i * 4 + 3] : 0.0f);
+
+		return result;
+	}
+
+	// Purpose: line through the block colors with the largest spread, power iteration on the covariance matrix.
+	// Zero length axis means all the colors are the same
+	void FindPrincipalAxis(const BlockColors& colors, glm::vec4& mean, glm::vec4& axis)
+	{
+		mean = glm::vec4(0.0f);
+		glm::vec4 minColor(255.0f);
+		glm::vec4 maxColor(0.0f);
+		for (const glm::vec4& color : colors)
+		{
+			mean += color;
+			minColor = glm::min(minColor, color);
+			maxColor = glm::max(maxColor, color);
+		}
+		mean /= static_cast<float>(BlockPixels);
+
+		float covariance[4][4]{};
+		for (const glm::vec4& color : colors)
+		{
+			const glm::vec4 delta = color - mean;
+			for (u32 row = 0; row < 4; ++row)
+				for (u32 column = 0; column < 4; ++column)
+					covariance[row][column] += delta[row] * delta[column];
+		}
+
+		// Bounding box diagonal is close to the answer, so few iterations are enough
+		axis = maxColor - minColor;
+		for (u32 iteration = 0; iteration < 8; ++iteration)
+		{
+			glm::vec4 next(0.0f);
+			for (u32 row = 0; row < 4; ++row)
+				for (u32 column = 0; column < 4; ++column)
+					next[row] += covariance[row][column] * axis[column];
+
+			const float length = glm::length(next);
+			if (length < 1e-6f)
+				break;
+
+			axis = next / length;
+		}
+
+		if (glm::length(axis) < 1e-6f)
+			axis = glm::vec4(0.0f);
+		else
+			axis = glm::normalize(axis);
+	}
+
+	// Purpose: extremes of the colors projected on the axis, inset a bit since the outliers pull the endpoints too far
+	void FindAxisEndpoints(const BlockColors& colors, glm::vec4 mean, glm::vec4 axis, glm::vec4& endpoint0, glm::vec4& endpoint1)
+	{
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		for (const glm::vec4& color : colors)
+		{
+			const float projection = glm::dot(color - mean, axis);
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		const float inset = (maxProjection - minProjection) / 16.0f;
+		endpoint0 = glm::clamp(mean + axis * (minProjection + inset), 0.0f, 255.0f);
+		endpoint1 = glm::clamp(mean + axis * (maxProjection - inset), 0.0f, 255.0f);
+	}
+
+	// Purpose: least squares endpoints for the chosen indices, color = (1 - weight) * endpoint0 + weight * endpoint1.
+	// False if all the pixels use the same weight, then the endpoints can't be solved
+	bool FitEndpoints(const BlockColors& colors, const std::array<float, BlockPixels>& weights, glm::vec4& endpoint0, glm::vec4& endpoint1)
+	{
+		float weight00 = 0.0f;
+		float weight01 = 0.0f;
+		float weight11 = 0.0f;
+		glm::vec4 color0(0.0f);
+		glm::vec4 color1(0.0f);
+		for (u32 i = 0; i < BlockPixels; ++i)
+		{
+			const float weight = weights[i];
+			weight00 += (1.0f - weight) * (1.0f - weight);
+			weight01 += (1.0f - weight) * weight;
+			weight11 += weight * weight;
+			color0 += (1.0f - weight) * colors[i];
+			color1 += weight * colors[i];
+		}
+
+		const float determinant = weight00 * weight11 - weight01 * weight01;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+
+		endpoint0 = glm::clamp((weight11 * color0 - weight01 * color1) / determinant, 0.0f, 255.0f);
+		endpoint1 = glm::clamp((weight00 * color1 - weight01 * color0) / determinant, 0.0f, 255.0f);
+		return true;
+	}
+
+	u16 ToRGB565(glm::vec4 color)
+	{
+		const u32 r = static_cast<u32>(std::lround(color.r * 31.0f / 255.0f));
+		const u32 g = static_cast<u32>(std::lround(color.g * 63.0f / 255.0f));
+		const u32 b = static_cast<u32>(std::lround(color.b * 31.0f / 255.0f));
+		return static_cast<u16>((r << 11) | (g << 5) | b);
+	}
+
+	glm::vec4 FromRGB565(u16 color)
+	{
+		const u32 r = color >> 11;
+		const u32 g = (color >> 5) & 0x3F;
+		const u32 b = color & 0x1F;
+		return glm::vec4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0.0f);
+	}
+
+	// Purpose: closest palette color per pixel in the 4 colors mode, returns the squared error
+	float FindBC1Indices(const BlockColors& colors, u16 color0, u16 color1, std::array<u8, BlockPixels>& indices)
+	{
+		const glm::vec4 endpoint0 = FromRGB565(color0);
+		const glm::vec4 endpoint1 = FromRGB565(color1);
+
+		std::array<glm::vec4, 4> palette{};
+		for (u32 i = 0; i < palette.size(); ++i)
+			palette[i] = glm::mix(endpoint0, endpoint1, BC1Weights[i]);
+
+		float error = 0.0f;
+		for (u32 pixel = 0; pixel < BlockPixels; ++pixel)
+		{
+			float bestDistance = std::numeric_limits<float>::max();
+			for (u32 i = 0; i < palette.size(); ++i)
+			{
+				const glm::vec4 delta = colors[pixel] - palette[i];
+				const float distance = glm::dot(delta, delta);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[pixel] = static_cast<u8>(i);
+				}
+			}
+			error += bestDistance;
+		}
+
+		return error;
+	}
+
+	void EncodeBC1(const u8* pixels, u8* result)
+	{
+		const BlockColors colors = LoadColors(pixels, false);
+
+		glm::vec4 mean{};
+		glm::vec4 axis{};
+		FindPrincipalAxis(colors, mean, axis);
+
+		glm::vec4 endpoint0{};
+		glm::vec4 endpoint1{};
+		FindAxisEndpoints(colors, mean, axis, endpoint0, endpoint1);
+
+		u16 bestColor0 = 0;
+		u16 bestColor1 = 0;
+		std::array<u8, BlockPixels> bestIndices{};
+		float bestError = std::numeric_limits<float>::max();
+
+		// Endpoints from the axis, then refined for the indices they gave
+		for (u32 iteration = 0; iteration < 3; ++iteration)
+		{
+			u16 color0 = ToRGB565(endpoint0);
+			u16 color1 = ToRGB565(endpoint1);
+
+			// color0 > color1 selects the 4 colors mode, equal endpoints would be the 3 colors one,
+			// so such block uses only the first color
+			if (color0 < color1)
+				std::swap(color0, color1);
+
+			std::array<u8, BlockPixels> indices{};
+			float error = 0.0f;
+			if (color0 == color1)
+			{
+				const glm::vec4 color = FromRGB565(color0);
+				for (const glm::vec4& pixel : colors)
+					error += glm::dot(pixel - color, pixel - color);
+			}
+			else
+				error = FindBC1Indices(colors, color0, color1, indices);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestColor0 = color0;
+				bestColor1 = color1;
+				bestIndices = indices;
+			}
+
+			std::array<float, BlockPixels> weights{};
+			for (u32 i = 0; i < BlockPixels; ++i)
+				weights[i] = BC1Weights[indices[i]];
+
+			endpoint0 = FromRGB565(color0);
+			endpoint1 = FromRGB565(color1);
+			if (color0 == color1 || !FitEndpoints(colors, weights, endpoint0, endpoint1))
+				break;
+		}
+
+		u32 indexBits = 0;
+		for (u32 i = 0; i < BlockPixels; ++i)
+			indexBits |= static_cast<u32>(bestIndices[i]) << (i * 2);
+
+		std::memcpy(result, &bestColor0, sizeof(u16));
+		std::memcpy(result + 2, &bestColor1, sizeof(u16));
+		std::memcpy(result + 4, &indexBits, sizeof(u32));
+	}
+
+	void EncodeBC4(const u8* pixels, u32 channel, u8* result)
+	{
+		u32 minValue = 255;
+		u32 maxValue = 0;
+		for (u32 i = 0; i < BlockPixels; ++i)
+		{
+			minValue = std::min<u32>(minValue, pixels[i * 4 + channel]);
+			maxValue = std::max<u32>(maxValue, pixels[i * 4 + channel]);
+		}
+
+		// First endpoint greater than the second one selects 8 values: both endpoints and 6 interpolated between them
+		result[0] = static_cast<u8>(maxValue);
+		result[1] = static_cast<u8>(minValue);
+
+		u64 indexBits = 0;
+		const u32 range = maxValue - minValue;
+		if (range > 0)
+		{
+			for (u32 i = 0; i < BlockPixels; ++i)
+			{
+				// Position in 7ths from the min value, 0 is index 1, 7 is index 0, the rest go down from the max
+				const u32 position = ((pixels[i * 4 + channel] - minValue) * 14 + range) / (range * 2);
+				const u32 index = position == 7 ? 0 : position == 0 ? 1 : 8 - position;
+				indexBits |= static_cast<u64>(index) << (i * 3);
+			}
+		}
+
+		for (u32 i = 0; i < 6; ++i)
+			result[2 + i] = static_cast<u8>(indexBits >> (i * 8));
+	}
+
+	void EncodeBC5(const u8* pixels, u32 firstChannel, u32 secondChannel, u8* result)
+	{
+		EncodeBC4(pixels, firstChannel, result);
+		EncodeBC4(pixels, secondChannel, result + 8);
+	}
+
+	// BC7 mode 6 endpoint: 7 bits per channel and a shared lowest bit
+	struct BC7Endpoint
+	{
+		std::array<u32, 4> quantized{};
+		u32 pBit{ 0 };
+
+		u32 GetValue(u32 channel) const { return (quantized[channel] << 1) | pBit; }
+	};
+
+	BC7Endpoint QuantizeBC7(glm::vec4 color, u32 pBit)
+	{
+		BC7Endpoint result{};
+		result.pBit = pBit;
+		for (u32 channel = 0; channel < 4; ++channel)
+			result.quantized[channel] = static_cast<u32>(std::clamp(std::lround((color[channel] - pBit) / 2.0f), 0l, 127l));
+
+		return result;
+	}
+
+	float FindBC7Indices(const BlockColors& colors, const BC7Endpoint& endpoint0, const BC7Endpoint& endpoint1, std::array<u8, BlockPixels>& indices)
+	{
+		std::array<glm::vec4, 16> palette{};
+		for (u32 i = 0; i < palette.size(); ++i)
+		{
+			for (u32 channel = 0; channel < 4; ++channel)
+			{
+				const u32 weight = BC7Weights[i];
+				palette[i][channel] = static_cast<float>(((64 - weight) * endpoint0.GetValue(channel) + weight * endpoint1.GetValue(channel) + 32) >> 6);
+			}
+		}
+
+		float error = 0.0f;
+		for (u32 pixel = 0; pixel < BlockPixels; ++pixel)
+		{
+			float bestDistance = std::numeric_limits<float>::max();
+			for (u32 i = 0; i < palette.size(); ++i)
+			{
+				const glm::vec4 delta = colors[pixel] - palette[i];
+				const float distance = glm::dot(delta, delta);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[pixel] = static_cast<u8>(i);
+				}
+			}
+			error += bestDistance;
+		}
+
+		return error;
+	}
+
+	// Purpose: mode 6 only, 1 subset with RGBA endpoints and 4 bit indices. It's the most flexible single mode,
+	// smooth albedo with alpha doesn't need partitions to look right
+	void EncodeBC7(const u8* pixels, u8* result)
+	{
+		const BlockColors colors = LoadColors(pixels, true);
+
+		glm::vec4 mean{};
+		glm::vec4 axis{};
+		FindPrincipalAxis(colors, mean, axis);
+
+		glm::vec4 color0{};
+		glm::vec4 color1{};
+		FindAxisEndpoints(colors, mean, axis, color0, color1);
+
+		BC7Endpoint bestEndpoint0{};
+		BC7Endpoint bestEndpoint1{};
+		std::array<u8, BlockPixels> bestIndices{};
+		float bestError = std::numeric_limits<float>::max();
+
+		for (u32 iteration = 0; iteration < 2; ++iteration)
+		{
+			// Every p-bit pair gives other endpoint values, the closest one wins
+			std::array<u8, BlockPixels> iterationIndices{};
+			float iterationError = std::numeric_limits<float>::max();
+			for (u32 pBits = 0; pBits < 4; ++pBits)
+			{
+				const BC7Endpoint endpoint0 = QuantizeBC7(color0, pBits & 1);
+				const BC7Endpoint endpoint1 = QuantizeBC7(color1, pBits >> 1);
+
+				std::array<u8, BlockPixels> indices{};
+				const float error = FindBC7Indices(colors, endpoint0, endpoint1, indices);
+				if (error < iterationError)
+				{
+					iterationError = error;
+					iterationIndices = indices;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestEndpoint0 = endpoint0;
+					bestEndpoint1 = endpoint1;
+					bestIndices = indices;
+				}
+			}
+
+			std::array<float, BlockPixels> weights{};
+			for (u32 i = 0; i < BlockPixels; ++i)
+				weights[i] = BC7Weights[iterationIndices[i]] / 64.0f;
+
+			if (!FitEndpoints(colors, weights, color0, color1))
+				break;
+		}
+
+		// Highest bit of the first index is implied to be 0
+		if (bestIndices[0] >= 8)
+		{
+			std::swap(bestEndpoint0, bestEndpoint1);
+			for (u8& index : bestIndices)
+				index = static_cast<u8>(15 - index);
+		}
+
+		std::memset(result, 0, 16);
+		BitWriter writer(result);
+		writer.Write(1u << 6, 7); // mode 6
+		for (u32 channel = 0; channel < 4; ++channel)
+		{
+			writer.Write(bestEndpoint0.quantized[channel], 7);
+			writer.Write(bestEndpoint1.quantized[channel], 7);
+		}
+		writer.Write(bestEndpoint0.pBit, 1);
+		writer.Write(bestEndpoint1.pBit, 1);
+
+		writer.Write(bestIndices[0], 3);
+		for (u32 i = 1; i < BlockPixels; ++i)
+			writer.Write(bestIndices[i], 4);
+	}
+
+	ImageFormat SelectFormat(const TextureMipChain& mipChain, TextureType textureType)
+	{
+		switch (textureType)
+		{
+		case TextureType::TEXTURE_NORMAL:
+		case TextureType::TEXTURE_METALLICROUGHNESS:
+			return ImageFormat::IMAGE_FORMAT_BC5_UNORM;
+
+		case TextureType::TEXTURE_ALBEDO:
+		{
+			// BC1 has half of the BC7 size, but alpha would be lost
+			const usize pixelsCount = static_cast<usize>(mipChain.width) * mipChain.height;
+			for (usize i = 0; i < pixelsCount; ++i)
+			{
+				if (mipChain.data[i * 4 + 3] != 255)
+					return ImageFormat::IMAGE_FORMAT_BC7_SRGB;
+			}
+			return ImageFormat::IMAGE_FORMAT_BC1_RGB_SRGB;
+		}
+
+		default:
+			return ImageFormat::IMAGE_FORMAT_BC7_SRGB;
+		}
+	}
+
+	u32 GetBlockSize(ImageFormat format)
+	{
+		switch (format)
+		{
+		case ImageFormat::IMAGE_FORMAT_BC1_RGB_SRGB: return 8;
+		case ImageFormat::IMAGE_FORMAT_BC5_UNORM:    return 16;
+		case ImageFormat::IMAGE_FORMAT_BC7_SRGB:     return 16;
+		default: std::unreachable();
+		}
+	}
+
+	TextureMipChain Compress(const TextureMipChain& mipChain, TextureType textureType)
+	{
+		assert(mipChain.format == ImageFormat::IMAGE_FORMAT_R8G8B8A8_SRGB && "Only RGBA8 mip chain can be compressed");
+
+		TextureMipChain result{};
+		if (mipChain.data.empty())
+			return result;
+
+		result.width = mipChain.width;
+		result.height = mipChain.height;
+		result.format = SelectFormat(mipChain, textureType);
+		const u32 blockSize = GetBlockSize(result.format);
+
+		// Row of blocks is the unit of work, so a single big level is split between the cores as well
+		struct BlockRow
+		{
+			u32 level{ 0 };
+			u32 blockY{ 0 };
+		};
+		std::vector<BlockRow> blockRows;
+
+		u64 dataSize = 0;
+		for (u32 level = 0; level < mipChain.mipOffsets.size(); ++level)
+		{
+			const u32 blocksX = (std::max(1u, mipChain.width >> level) + 3) / 4;
+			const u32 blocksY = (std::max(1u, mipChain.height >> level) + 3) / 4;
+
+			result.mipOffsets.push_back(dataSize);
+			for (u32 blockY = 0; blockY < blocksY; ++blockY)
+				blockRows.push_back(BlockRow{ level, blockY });
+
+			dataSize = AlignUp(dataSize + static_cast<u64>(blocksX) * blocksY * blockSize, LevelAlignment);
+		}
+		result.data.resize(dataSize);
+
+		helpers::ParallelFor(static_cast<u32>(blockRows.size()), [&](u32 rowIndex)
+			{
+				const BlockRow& row = blockRows[rowIndex];
+				const u32 levelWidth = std::max(1u, mipChain.width >> row.level);
+				const u32 levelHeight = std::max(1u, mipChain.height >> row.level);
+				const u32 blocksX = (levelWidth + 3) / 4;
+
+				const u8* levelPixels = mipChain.data.data() + mipChain.mipOffsets[row.level];
+				u8* levelBlocks = result.data.data() + result.mipOffsets[row.level];
+
+				std::array<u8, BlockPixels * 4> blockPixels{};
+				for (u32 blockX = 0; blockX < blocksX; ++blockX)
+				{
+					// Blocks over the level edge repeat the last row/column
+					for (u32 y = 0; y < 4; ++y)
+					{
+						const u32 sourceY = std::min(row.blockY * 4 + y, levelHeight - 1);
+						for (u32 x = 0; x < 4; ++x)
+						{
+							const u32 sourceX = std::min(blockX * 4 + x, levelWidth - 1);
+							std::memcpy(&blockPixels[(y * 4 + x) * 4], levelPixels + (static_cast<usize>(sourceY) * levelWidth + sourceX) * 4, 4);
+						}
+					}
+
+					u8* block = levelBlocks + (static_cast<usize>(row.blockY) * blocksX + blockX) * blockSize;
+					switch (result.format)
+					{
+					case ImageFormat::IMAGE_FORMAT_BC1_RGB_SRGB:
+						EncodeBC1(blockPixels.data(), block);
+						break;
+
+					case ImageFormat::IMAGE_FORMAT_BC5_UNORM:
+						// Normals keep tangent space XY, metallic-roughness keeps roughness(G) and metallic(B)
+						if (textureType == TextureType::TEXTURE_NORMAL)
+							EncodeBC5(blockPixels.data(), 0, 1, block);
+						else
+							EncodeBC5(blockPixels.data(), 1, 2, block);
+						break;
+
+					case ImageFormat::IMAGE_FORMAT_BC7_SRGB:
+						EncodeBC7(blockPixels.data(), block);
+						break;
+
+					default: std::unreachable();
+					}
+				}
+			});
+
+		return result;
+	}
+}
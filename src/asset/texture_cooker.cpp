@@ -0,0 +1,343 @@
+#include "../../headers/asset/texture_cooker.h"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUX_MIPS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace mipgeneration
+{
+	constexpr u64 LevelAlignment{ 16 };
+	constexpr u32 LinearToSrgbSteps{ 4096 };
+
+	const std::array<float, 256>& GetSrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> result{};
+				for (u32 i = 0; i < result.size(); ++i)
+				{
+					const float srgb = i / 255.0f;
+					result[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+				}
+				return result;
+			}();
+
+		return table;
+	}
+
+	// Linear value quantized to 12 bits is enough to get the exact 8 bit sRGB one
+	const std::array<u8, LinearToSrgbSteps>& GetLinearToSrgbTable()
+	{
+		static const std::array<u8, LinearToSrgbSteps> table = []()
+			{
+				std::array<u8, LinearToSrgbSteps> result{};
+				for (u32 i = 0; i < result.size(); ++i)
+				{
+					const float linear = i / static_cast<float>(LinearToSrgbSteps - 1);
+					const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+					result[i] = static_cast<u8>(std::lround(std::clamp(srgb, 0.0f, 1.0f) * 255.0f));
+				}
+				return result;
+			}();
+
+		return table;
+	}
+
+	u64 AlignUp(u64 value, u64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Purpose: values the filter works with. Albedo is linearized, normals are in [-1, 1]
+	glm::vec4 ToFilterSpace(const u8* pixel, TextureType textureType)
+	{
+		const float alpha = pixel[3] / 255.0f;
+		switch (textureType)
+		{
+		case TextureType::TEXTURE_ALBEDO:
+		{
+			const auto& table = GetSrgbToLinearTable();
+			return glm::vec4(table[pixel[0]], table[pixel[1]], table[pixel[2]], alpha);
+		}
+
+		case TextureType::TEXTURE_NORMAL:
+			return glm::vec4(pixel[0] / 127.5f - 1.0f, pixel[1] / 127.5f - 1.0f, pixel[2] / 127.5f - 1.0f, alpha);
+
+		default:
+			return glm::vec4(pixel[0] / 255.0f, pixel[1] / 255.0f, pixel[2] / 255.0f, alpha);
+		}
+	}
+
+	void StorePixel(glm::vec4 value, TextureType textureType, u8* pixel)
+	{
+		if (textureType == TextureType::TEXTURE_NORMAL)
+		{
+			// Average of unit vectors is shorter than 1, it would make the lighting flatter on distant levels
+			const glm::vec3 normal(value);
+			const float length = glm::length(normal);
+			const glm::vec3 unitNormal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+			value = glm::vec4(unitNormal * 0.5f + 0.5f, value.w);
+		}
+
+		if (textureType == TextureType::TEXTURE_ALBEDO)
+		{
+			const auto& table = GetLinearToSrgbTable();
+			for (u32 channel = 0; channel < 3; ++channel)
+				pixel[channel] = table[static_cast<u32>(std::clamp(value[channel], 0.0f, 1.0f) * (LinearToSrgbSteps - 1) + 0.5f)];
+			pixel[3] = static_cast<u8>(std::clamp(value.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+			return;
+		}
+
+#ifdef LUX_MIPS_SSE
+		// Clamp, round and pack all 4 channels at once
+		__m128 scaled = _mm_mul_ps(_mm_loadu_ps(&value.x), _mm_set1_ps(255.0f));
+		scaled = _mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+		const __m128i rounded = _mm_cvtps_epi32(scaled);
+		const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(rounded, rounded), rounded);
+		const i32 bytes = _mm_cvtsi128_si32(packed);
+		std::memcpy(pixel, &bytes, 4);
+#else
+		for (u32 channel = 0; channel < 4; ++channel)
+			pixel[channel] = static_cast<u8>(std::clamp(value[channel], 0.0f, 1.0f) * 255.0f + 0.5f);
+#endif
+	}
+
+	// Purpose: level 1 right from the 8 bit source, so the full size level never exists in the filter space
+	void DownsampleSource(const DecodedTexture& source, TextureType textureType, std::vector<glm::vec4>& result, u32 width, u32 height)
+	{
+		const auto sourcePixel = [&source, textureType](u32 x, u32 y)
+			{
+				return ToFilterSpace(&source.pixels[(static_cast<usize>(y) * source.width + x) * 4], textureType);
+			};
+
+		result.resize(static_cast<usize>(width) * height);
+		for (u32 y = 0; y < height; ++y)
+		{
+			const u32 y0 = std::min(y * 2, source.height - 1);
+			const u32 y1 = std::min(y * 2 + 1, source.height - 1);
+			for (u32 x = 0; x < width; ++x)
+			{
+				const u32 x0 = std::min(x * 2, source.width - 1);
+				const u32 x1 = std::min(x * 2 + 1, source.width - 1);
+				result[static_cast<usize>(y) * width + x] = (sourcePixel(x0, y0) + sourcePixel(x1, y0) + sourcePixel(x0, y1) + sourcePixel(x1, y1)) * 0.25f;
+			}
+		}
+	}
+
+	// Purpose: 2x2 box filter, the last row/column is repeated for odd sizes
+	void Downsample(const std::vector<glm::vec4>& source, u32 sourceWidth, u32 sourceHeight, std::vector<glm::vec4>& result, u32 width, u32 height)
+	{
+		result.resize(static_cast<usize>(width) * height);
+		for (u32 y = 0; y < height; ++y)
+		{
+			const glm::vec4* row0 = &source[static_cast<usize>(std::min(y * 2, sourceHeight - 1)) * sourceWidth];
+			const glm::vec4* row1 = &source[static_cast<usize>(std::min(y * 2 + 1, sourceHeight - 1)) * sourceWidth];
+			glm::vec4* resultRow = &result[static_cast<usize>(y) * width];
+
+			for (u32 x = 0; x < width; ++x)
+			{
+				const u32 x0 = std::min(x * 2, sourceWidth - 1);
+				const u32 x1 = std::min(x * 2 + 1, sourceWidth - 1);
+#ifdef LUX_MIPS_SSE
+				const __m128 top = _mm_add_ps(_mm_loadu_ps(&row0[x0].x), _mm_loadu_ps(&row0[x1].x));
+				const __m128 bottom = _mm_add_ps(_mm_loadu_ps(&row1[x0].x), _mm_loadu_ps(&row1[x1].x));
+				_mm_storeu_ps(&resultRow[x].x, _mm_mul_ps(_mm_add_ps(top, bottom), _mm_set1_ps(0.25f)));
+#else
+				resultRow[x] = (row0[x0] + row0[x1] + row1[x0] + row1[x1]) * 0.25f;
+#endif
+			}
+		}
+	}
+
+	TextureMipChain Generate(const DecodedTexture& texture, TextureType textureType)
+	{
+		TextureMipChain result{};
+		if (!texture.IsValid())
+			return result;
+
+		result.width = texture.width;
+		result.height = texture.height;
+		result.format = ImageFormat::IMAGE_FORMAT_R8G8B8A8_SRGB;
+
+		const u32 mipLevels = static_cast<u32>(std::floor(std::log2(std::max(texture.width, texture.height)))) + 1;
+
+		u64 dataSize = 0;
+		for (u32 level = 0; level < mipLevels; ++level)
+		{
+			result.mipOffsets.push_back(dataSize);
+			const u64 levelWidth = std::max(1u, texture.width >> level);
+			const u64 levelHeight = std::max(1u, texture.height >> level);
+			dataSize = AlignUp(dataSize + levelWidth * levelHeight * 4, LevelAlignment);
+		}
+		result.data.resize(dataSize);
+
+		// Level 0 is the source as is, so it doesn't lose precision on the way to the filter space and back
+		std::memcpy(result.data.data(), texture.pixels.data(), texture.pixels.size());
+
+		// Previous level is kept in the filter space, so every level is filtered from the precise values
+		std::vector<glm::vec4> previousLevel;
+		std::vector<glm::vec4> currentLevel;
+		for (u32 level = 1; level < mipLevels; ++level)
+		{
+			const u32 previousWidth = std::max(1u, texture.width >> (level - 1));
+			const u32 previousHeight = std::max(1u, texture.height >> (level - 1));
+			const u32 levelWidth = std::max(1u, texture.width >> level);
+			const u32 levelHeight = std::max(1u, texture.height >> level);
+
+			if (level == 1)
+				DownsampleSource(texture, textureType, currentLevel, levelWidth, levelHeight);
+			else
+				Downsample(previousLevel, previousWidth, previousHeight, currentLevel, levelWidth, levelHeight);
+
+			u8* levelData = result.data.data() + result.mipOffsets[level];
+			for (usize i = 0; i < currentLevel.size(); ++i)
+				StorePixel(currentLevel[i], textureType, levelData + i * 4);
+
+			std::swap(previousLevel, currentLevel);
+		}
+
+		return result;
+	}
+}
+
+
+namespace luxtex
+{
+	struct FileHeader
+	{
+		u32 magic{ 0 };
+		u32 version{ 0 };
+		u64 sourceHash{ 0 };
+
+		u32 format{ 0 };
+		u32 textureType{ 0 };
+		u32 width{ 0 };
+		u32 height{ 0 };
+
+		u32 mipCount{ 0 };
+		u32 pad{ 0 };
+		u64 dataOffset{ 0 }; // level index follows the header, levels data is after it
+		u64 dataSize{ 0 };
+	};
+
+	constexpr u64 DataAlignment{ 16 };
+}
+
+fs::path TextureCooker::GetCookedPath(u64 contentHash, TextureType textureType) const
+{
+	std::ostringstream fileName;
+	fileName << std::hex << std::setw(16) << std::setfill('0') << contentHash << std::dec << '_' << static_cast<u32>(textureType) << ".luxtex";
+	return _cookedDirectory / fileName.str();
+}
+
+bool TextureCooker::Write(u64 contentHash, TextureType textureType, const TextureMipChain& mipChain) const
+{
+	using namespace luxtex;
+
+	if (_cookedDirectory.empty() || mipChain.data.empty())
+		return false;
+
+	FileHeader header{};
+	header.magic = Magic;
+	header.version = Version;
+	header.sourceHash = contentHash;
+	header.format = static_cast<u32>(mipChain.format);
+	header.textureType = static_cast<u32>(textureType);
+	header.width = mipChain.width;
+	header.height = mipChain.height;
+	header.mipCount = static_cast<u32>(mipChain.mipOffsets.size());
+	header.dataOffset = mipgeneration::AlignUp(sizeof(FileHeader) + header.mipCount * sizeof(u64), DataAlignment);
+	header.dataSize = mipChain.data.size();
+
+	std::error_code error;
+	fs::create_directories(_cookedDirectory, error);
+
+	// Written to the temporary file first, so the interrupted write never leaves a broken cache
+	const fs::path cookedPath = GetCookedPath(contentHash, textureType);
+	fs::path tempPath = cookedPath;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Failed to create cooked texture file: " << tempPath << '\n';
+			return false;
+		}
+
+		static constexpr char zeros[DataAlignment]{};
+		const u64 indexEnd = sizeof(FileHeader) + header.mipCount * sizeof(u64);
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(mipChain.mipOffsets.data()), static_cast<std::streamsize>(header.mipCount * sizeof(u64)));
+		file.write(zeros, static_cast<std::streamsize>(header.dataOffset - indexEnd));
+		file.write(reinterpret_cast<const char*>(mipChain.data.data()), static_cast<std::streamsize>(mipChain.data.size()));
+
+		if (!file)
+		{
+			std::cout << "Failed to write cooked texture file: " << tempPath << '\n';
+			return false;
+		}
+	}
+
+	fs::rename(tempPath, cookedPath, error);
+	if (error)
+	{
+		std::cout << "Failed to store cooked texture file: " << cookedPath << ", " << error.message() << '\n';
+		fs::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+std::optional<CookedTexture> TextureCooker::TryLoad(u64 contentHash, TextureType textureType) const
+{
+	using namespace luxtex;
+
+	const fs::path cookedPath = GetCookedPath(contentHash, textureType);
+	if (_cookedDirectory.empty() || !fs::exists(cookedPath))
+		return std::nullopt;
+
+	CookedTexture result{};
+	result.file = std::make_unique<MappedFile>(cookedPath);
+	const MappedFile& mapped = *result.file;
+	if (!mapped.IsMapped() || mapped.GetSize() < sizeof(FileHeader))
+		return std::nullopt;
+
+	FileHeader header{};
+	std::memcpy(&header, mapped.GetData(), sizeof(header));
+
+	const u64 indexEnd = sizeof(FileHeader) + static_cast<u64>(header.mipCount) * sizeof(u64);
+	if (header.magic != Magic || header.version != Version || header.sourceHash != contentHash ||
+		header.textureType != static_cast<u32>(textureType) || header.mipCount == 0 ||
+		header.dataOffset < indexEnd || header.dataOffset % DataAlignment != 0 || header.dataOffset + header.dataSize != mapped.GetSize())
+	{
+		std::cout << "Cooked texture file is corrupted: " << cookedPath << '\n';
+		return std::nullopt;
+	}
+
+	result.mipOffsets.resize(header.mipCount);
+	std::memcpy(result.mipOffsets.data(), mapped.GetData() + sizeof(FileHeader), header.mipCount * sizeof(u64));
+	for (u64 offset : result.mipOffsets)
+	{
+		if (offset >= header.dataSize)
+		{
+			std::cout << "Cooked texture file is corrupted: " << cookedPath << '\n';
+			return std::nullopt;
+		}
+	}
+
+	result.data = std::span<const u8>(mapped.GetData() + header.dataOffset, header.dataSize);
+	result.width = header.width;
+	result.height = header.height;
+	result.format = static_cast<ImageFormat>(header.format);
+
+	return result;
+}
@@ -0,0 +1,43 @@
+#include "../../headers/asset/texture_decoder.h"
+#include "../../headers/util/helpers.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <cstring>
+
+namespace texturedecoding
+{
+	DecodedTexture Decode(std::span<const u8> encoded)
+	{
+		DecodedTexture result{};
+		if (encoded.empty())
+			return result;
+
+		int width = 0, height = 0, channels = 0;
+		stbi_uc* pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+			return result;
+
+		result.width = static_cast<u32>(width);
+		result.height = static_cast<u32>(height);
+		result.pixels.resize(static_cast<usize>(result.width) * result.height * 4);
+		std::memcpy(result.pixels.data(), pixels, result.pixels.size());
+
+		stbi_image_free(pixels);
+		return result;
+	}
+
+	std::vector<DecodedTexture> DecodeAll(const std::vector<std::span<const u8>>& encoded)
+	{
+		// Flag is global in stb, so it's set once before the workers start
+		stbi_set_flip_vertically_on_load(true);
+
+		std::vector<DecodedTexture> result(encoded.size());
+		helpers::ParallelFor(static_cast<u32>(encoded.size()), [&encoded, &result](u32 i)
+			{
+				result[i] = Decode(encoded[i]);
+			});
+
+		return result;
+	}
+}
@@ -0,0 +1,245 @@
+#include "../../headers/asset/texture_preparation.h"
+#include "../../headers/asset/texture_decoder.h"
+#include "../../headers/asset/texture_compressor.h"
+#include "../../headers/util/helpers.h"
+#include "../../headers/util/mapped_file.h"
+
+#include <chrono>
+#include <map>
+
+namespace texturepreparation
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	// Purpose: adds the stage time to the report if there's one
+	class StageTimer
+	{
+	private:
+		TextureStageReport* _stageReport{ nullptr };
+		Clock::time_point _start{ Clock::now() };
+	public:
+		StageTimer(TexturePreparationReport* report, TextureStage stage)
+			: _stageReport{ report ? &(*report)[static_cast<size_t>(stage)] : nullptr } {}
+
+		~StageTimer()
+		{
+			if (_stageReport)
+				_stageReport->milliseconds += std::chrono::duration<double, std::milli>(Clock::now() - _start).count();
+		}
+
+		TextureStageReport* operator->() const { return _stageReport; }
+		explicit operator bool() const { return _stageReport != nullptr; }
+	};
+
+	std::string GetSourceKey(const TexturesData& texture)
+	{
+		if (texture.dataType == TexturesData::Type::URI)
+			return TextureCache::GetTypedKey(TextureCache::GetCanonicalKey(texture.path), texture.textureType);
+		if (texture.bytes.empty())
+			return TextureCache::GetTypedKey(TextureCache::GetCanonicalKey(texture.path) + '#' + std::to_string(texture.byteOffset), texture.textureType);
+
+		return {};
+	}
+
+	PreparedTextures Prepare(std::span<const TexturesData* const> textures, const TextureCooker& cooker,
+		const TextureCache* knownTextures, bool forceCook, TexturePreparationReport* report)
+	{
+		PreparedTextures result;
+		std::vector<const TexturesData*> sourceTextures;
+		std::unordered_map<std::string, u32> sourceByKey;
+
+		// References to the same source share it
+		for (const TexturesData* texture : textures)
+		{
+			const std::string key = GetSourceKey(*texture);
+
+			auto [it, isInserted] = key.empty() ? std::pair{ sourceByKey.end(), true } : sourceByKey.insert({ key, static_cast<u32>(result.sources.size()) });
+			if (isInserted)
+			{
+				result.referenceSources.push_back(static_cast<u32>(result.sources.size()));
+				result.sources.push_back(PreparedTexture{ .key = key, .path = texture->path, .type = texture->textureType,
+					.isKnown = knownTextures && !key.empty() && knownTextures->FindByKey(key) != 0 });
+				sourceTextures.push_back(texture);
+			}
+			else
+				result.referenceSources.push_back(it->second);
+		}
+
+		std::vector<PreparedTexture>& sources = result.sources;
+		std::vector<std::unique_ptr<MappedFile>> files(sources.size());
+		std::vector<std::span<const u8>> encodedSources(sources.size()); // whole file, its embedded range or the texture bytes
+		std::vector<u32> newSources;
+		{
+			StageTimer hashStage(report, TextureStage::STAGE_HASH);
+
+			// Images are hashed and decoded right from the mapping or the texture bytes, every file is read once
+			helpers::ParallelFor(static_cast<u32>(sources.size()), [&](u32 i)
+				{
+					if (sources[i].isKnown)
+						return;
+
+					const TexturesData& texture = *sourceTextures[i];
+					std::span<const u8>& encoded = encodedSources[i];
+					if (!texture.bytes.empty())
+						encoded = texture.bytes;
+					else
+					{
+						files[i] = std::make_unique<MappedFile>(texture.path);
+						if (!files[i]->IsMapped())
+							return;
+
+						const std::span<const u8> fileBytes(files[i]->GetData(), files[i]->GetSize());
+						if (texture.dataType == TexturesData::Type::URI)
+							encoded = fileBytes;
+						else if (texture.byteOffset + texture.byteLength <= fileBytes.size())
+							encoded = fileBytes.subspan(texture.byteOffset, texture.byteLength);
+					}
+
+					sources[i].contentHash = helpers::HashBytes(encoded.data(), encoded.size());
+				});
+
+			// Same bytes of the same type under different names are loaded once as well
+			std::map<std::pair<u64, TextureType>, u32> sourceByHash;
+			for (u32 i = 0; i < sources.size(); ++i)
+			{
+				PreparedTexture& source = sources[i];
+				if (source.isKnown)
+					continue;
+
+				if (encodedSources[i].empty())
+				{
+					std::cout << "Failed to load image by path: " << source.path << '\n';
+					continue;
+				}
+
+				if (hashStage)
+				{
+					hashStage->inputBytes += encodedSources[i].size();
+					hashStage->itemsCount += 1;
+				}
+
+				if (source.key.empty())
+					source.key = TextureCache::GetTypedKey("memory#" + std::to_string(source.contentHash), source.type);
+
+				auto [it, isInserted] = sourceByHash.insert({ { source.contentHash, source.type }, i });
+				if (!isInserted)
+				{
+					source.sameContentSource = it->second;
+					continue;
+				}
+
+				newSources.push_back(i);
+			}
+
+			// Textures cooked earlier come with their mips, only the rest is decoded
+			if (!forceCook)
+			{
+				helpers::ParallelFor(static_cast<u32>(newSources.size()), [&](u32 i)
+					{
+						PreparedTexture& source = sources[newSources[i]];
+						source.cooked = cooker.TryLoad(source.contentHash, source.type);
+					});
+			}
+		}
+
+		std::vector<u32> decodedSources;
+		std::vector<std::span<const u8>> encodedImages;
+		for (const u32 sourceIndex : newSources)
+		{
+			if (sources[sourceIndex].cooked)
+				continue;
+
+			decodedSources.push_back(sourceIndex);
+			encodedImages.push_back(encodedSources[sourceIndex]);
+		}
+
+		if (decodedSources.empty())
+			return result;
+
+		// Decoding takes most of the time and is independent per texture
+		std::vector<DecodedTexture> decodedTextures;
+		{
+			StageTimer decodeStage(report, TextureStage::STAGE_DECODE);
+			decodedTextures = texturedecoding::DecodeAll(encodedImages);
+
+			if (decodeStage)
+			{
+				decodeStage->itemsCount += static_cast<u32>(decodedSources.size());
+				for (const DecodedTexture& decoded : decodedTextures)
+					decodeStage->outputBytes += decoded.pixels.size();
+			}
+		}
+
+		// Mips are filtered and block compressed on the CPU once and cooked, next loads skip all of that
+		{
+			StageTimer mipsStage(report, TextureStage::STAGE_MIPS);
+			helpers::ParallelFor(static_cast<u32>(decodedSources.size()), [&](u32 i)
+				{
+					DecodedTexture& decoded = decodedTextures[i];
+					PreparedTexture& source = sources[decodedSources[i]];
+					if (!decoded.IsValid())
+					{
+						std::cout << "Failed to decode image: " << source.path << '\n';
+						return;
+					}
+
+					source.mipChain = mipgeneration::Generate(decoded, source.type);
+
+					decoded.pixels = {}; // level 0 is in the mip chain
+				});
+
+			if (mipsStage)
+			{
+				mipsStage->itemsCount += static_cast<u32>(decodedSources.size());
+				for (const u32 sourceIndex : decodedSources)
+					mipsStage->outputBytes += sources[sourceIndex].mipChain.data.size();
+			}
+		}
+
+		// Compression splits every texture between the cores itself, one big texture would keep the rest waiting otherwise
+		{
+			StageTimer compressStage(report, TextureStage::STAGE_COMPRESS);
+			for (const u32 sourceIndex : decodedSources)
+			{
+				TextureMipChain& mipChain = sources[sourceIndex].mipChain;
+				if (mipChain.data.empty())
+					continue;
+
+				if (compressStage)
+				{
+					compressStage->inputBytes += mipChain.data.size();
+					compressStage->itemsCount += 1;
+				}
+
+				mipChain = blockcompression::Compress(mipChain, sources[sourceIndex].type);
+
+				if (compressStage)
+					compressStage->outputBytes += mipChain.data.size();
+			}
+		}
+
+		{
+			StageTimer writeStage(report, TextureStage::STAGE_WRITE);
+			helpers::ParallelFor(static_cast<u32>(decodedSources.size()), [&](u32 i)
+				{
+					PreparedTexture& source = sources[decodedSources[i]];
+					if (!source.mipChain.data.empty())
+						source.isWritten = cooker.Write(source.contentHash, source.type, source.mipChain);
+				});
+
+			if (writeStage)
+			{
+				for (const u32 sourceIndex : decodedSources)
+				{
+					if (!sources[sourceIndex].isWritten)
+						continue;
+
+					writeStage->outputBytes += sources[sourceIndex].mipChain.data.size();
+					writeStage->itemsCount += 1;
+				}
+			}
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,197 @@
+#include "../../headers/asset/vertex_packing.h"
+#include "../../headers/asset/mesh_bounds.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <span>
+
+namespace vertexpacking
+{
+	// Purpose: direction to the octahedron unfolded into the square, result is in [-1, 1]
+	inline glm::vec2 EncodeOctahedral(glm::vec3 direction)
+	{
+		const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (length == 0.0f)
+			return glm::vec2(0.0f);
+
+		direction /= length;
+
+		glm::vec2 result(direction.x, direction.y);
+		if (direction.z < 0.0f)
+		{
+			result.x = (1.0f - std::abs(direction.y)) * (direction.x >= 0.0f ? 1.0f : -1.0f);
+			result.y = (1.0f - std::abs(direction.x)) * (direction.y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		return result;
+	}
+
+	inline u32 ToUnorm(float value, u32 maxValue)
+	{
+		return static_cast<u32>(std::round(std::clamp(value, 0.0f, 1.0f) * static_cast<float>(maxValue)));
+	}
+
+	// Purpose: the float meshes of the range get one grid over their merged box
+	inline void QuantizeOnSharedGrid(std::span<LoadedMesh> meshes)
+	{
+		// Already quantized source(KHR_mesh_quantization) keeps its own grid, so the values pass through unchanged
+		const auto needsGrid = [](const LoadedMesh& mesh) { return !mesh.vertex.empty() && !mesh.vertexEncoding.quantizedPosition; };
+
+		// Importer box holds all the source vertices, the optimized ones are their subset
+		std::optional<BoundingBox> sharedBox;
+		for (const LoadedMesh& mesh : meshes)
+		{
+			if (!needsGrid(mesh))
+				continue;
+
+			if (sharedBox)
+				meshbounds::Merge(*sharedBox, mesh.boundingBox);
+			else
+				sharedBox = mesh.boundingBox;
+		}
+
+		if (!sharedBox)
+			return;
+
+		const glm::vec3 positionOffset = sharedBox->minPosition;
+		const glm::vec3 positionScale = (sharedBox->maxPosition - sharedBox->minPosition) / 65535.0f;
+		for (LoadedMesh& mesh : meshes)
+		{
+			if (!needsGrid(mesh))
+				continue;
+
+			mesh.vertexEncoding.quantizedPosition = true;
+			mesh.vertexEncoding.positionOffset = positionOffset;
+			mesh.vertexEncoding.positionScale = positionScale;
+		}
+	}
+
+	void SelectEncodings(LoadedGLTF& model, const VertexPackingSettings& settings)
+	{
+		std::vector<LoadedMesh>& meshes = model.meshes;
+		for (LoadedMesh& mesh : meshes)
+		{
+			VertexEncoding& encoding = mesh.vertexEncoding;
+
+			encoding.unormUV = !mesh.vertex.empty();
+			for (const Vertex& vertex : mesh.vertex)
+			{
+				if (vertex.UV.x < 0.0f || vertex.UV.x > 1.0f || vertex.UV.y < 0.0f || vertex.UV.y > 1.0f)
+				{
+					encoding.unormUV = false;
+					break;
+				}
+			}
+
+			if (!settings.quantizePositions || mesh.vertex.empty())
+			{
+				encoding.quantizedPosition = false;
+				encoding.positionScale = glm::vec3(1.0f);
+				encoding.positionOffset = glm::vec3(0.0f);
+			}
+		}
+
+		if (!settings.quantizePositions)
+			return;
+
+		// Primitives of one glTF mesh are in one space and may share the border vertices
+		for (const MeshSubmeshRange& range : model.hierarchy.meshes)
+		{
+			if (range.firstSubmesh < meshes.size())
+				QuantizeOnSharedGrid(std::span(meshes).subspan(range.firstSubmesh, std::min<size_t>(range.submeshCount, meshes.size() - range.firstSubmesh)));
+		}
+
+		// Submeshes of no glTF mesh get their own grid
+		for (LoadedMesh& mesh : meshes)
+			QuantizeOnSharedGrid(std::span(&mesh, 1));
+	}
+
+	u32 GetStride(const VertexEncoding& encoding)
+	{
+		return encoding.quantizedPosition ? QuantizedPositionStride : FloatPositionStride;
+	}
+
+	u32 GetFormatFlags(const VertexEncoding& encoding)
+	{
+		u32 flags = 0;
+		if (encoding.quantizedPosition)
+			flags |= FormatQuantizedPosition;
+		if (encoding.unormUV)
+			flags |= FormatUnormUV;
+
+		return flags;
+	}
+
+	void PackVertices(const Vertex* vertices, u32 vertexCount, const VertexEncoding& encoding, byte* outData)
+	{
+		const u32 stride = GetStride(encoding);
+		for (u32 i = 0; i < vertexCount; ++i)
+		{
+			const Vertex& vertex = vertices[i];
+
+			std::array<u32, MaxStride / sizeof(u32)> words{};
+			u32 wordIndex = 0;
+
+			if (encoding.quantizedPosition)
+			{
+				// Flat axis has zero scale, everything is on the offset then
+				glm::vec3 quantized(0.0f);
+				for (u32 axis = 0; axis < 3; ++axis)
+				{
+					if (encoding.positionScale[axis] > 0.0f)
+						quantized[axis] = (vertex.position[axis] - encoding.positionOffset[axis]) / encoding.positionScale[axis];
+				}
+
+				const glm::uvec3 position = glm::uvec3(glm::clamp(glm::round(quantized), glm::vec3(0.0f), glm::vec3(65535.0f)));
+				words[wordIndex++] = position.x | (position.y << 16);
+				words[wordIndex++] = position.z;
+			}
+			else
+			{
+				std::memcpy(&words[wordIndex], &vertex.position, sizeof(glm::vec3));
+				wordIndex += 3;
+			}
+
+			const glm::vec2 normal = EncodeOctahedral(vertex.normal) * 0.5f + 0.5f;
+			words[wordIndex++] = ToUnorm(normal.x, 0xFFFF) | (ToUnorm(normal.y, 0xFFFF) << 16);
+
+			const glm::vec2 tangent = EncodeOctahedral(glm::vec3(vertex.tangent)) * 0.5f + 0.5f;
+			const u32 tangentSign = vertex.tangent.w < 0.0f ? 1u : 0u;
+			words[wordIndex++] = ToUnorm(tangent.x, 0xFFFF) | (ToUnorm(tangent.y, 0x7FFF) << 16) | (tangentSign << 31);
+
+			words[wordIndex++] = encoding.unormUV ? glm::packUnorm2x16(vertex.UV) : glm::packHalf2x16(vertex.UV);
+
+			std::memcpy(outData + static_cast<usize>(i) * stride, words.data(), stride);
+		}
+	}
+
+	IndexType SelectIndexType(u32 vertexCount)
+	{
+		return vertexCount <= std::numeric_limits<u16>::max() + 1u ? IndexType::INDEX_TYPE_U16 : IndexType::INDEX_TYPE_U32;
+	}
+
+	u32 GetIndexSize(IndexType type)
+	{
+		return type == IndexType::INDEX_TYPE_U16 ? sizeof(u16) : sizeof(u32);
+	}
+
+	void PackIndices(const u32* indices, u32 indexCount, IndexType type, byte* outData)
+	{
+		if (type == IndexType::INDEX_TYPE_U32)
+		{
+			std::memcpy(outData, indices, static_cast<usize>(indexCount) * sizeof(u32));
+			return;
+		}
+
+		u16* outIndices = reinterpret_cast<u16*>(outData);
+		for (u32 i = 0; i < indexCount; ++i)
+		{
+			assert(indices[i] <= std::numeric_limits<u16>::max() && "Index doesn't fit u16");
+			outIndices[i] = static_cast<u16>(indices[i]);
+		}
+	}
+}
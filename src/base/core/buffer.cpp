@@ -28,4 +28,9 @@ BufferManager::BufferManager(VulkanBase& vulkanBase) : _vulkanBase{vulkanBase}
 std::unique_ptr<Buffer>	 BufferManager::CreateBuffer(const BufferSpecification& spec)	const
 {
 	return std::make_unique<VulkanBuffer>(spec, _vulkanBase.GetVulkanDeviceObj(), _vulkanBase.GetAllocatorObj(), _vulkanBase.GetFrameObj()); 
+}
+
+bool BufferManager::IsUploadResident(u64 ticket) const
+{
+	return _vulkanBase.GetFrameObj().GetTransferQueue().IsResident(ticket);
 }
\ No newline at end of file
@@ -12,8 +12,8 @@ void VulkanBase::Initialize(Window& windowObj)
 	_instanceObject = std::make_unique<VulkanInstance>(windowObj);
 	_deviceObject = std::make_unique<VulkanDevice>(*_instanceObject);
 	_presentationObject = std::make_unique<VulkanPresentation>(*_instanceObject, *_deviceObject, windowObj);
-	_frameObject = std::make_unique<VulkanFrame>(*_deviceObject, *_presentationObject);
 	_allocatorObject = std::make_unique<VulkanAllocator>(*_instanceObject, *_deviceObject);
+	_frameObject = std::make_unique<VulkanFrame>(*_deviceObject, *_presentationObject, *_allocatorObject);
 	_shaderObject = std::make_unique<VulkanShader>(*_deviceObject);
 }
 
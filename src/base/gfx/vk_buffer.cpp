@@ -72,53 +72,36 @@ void  VulkanBuffer::UploadData(u64 offset, const void* newData, u64 size)
 	{
 		memcpy(static_cast<u8*>(_mappedData) + offset, newData, size);
 	}
-	else // if buffer GPU only
+	else if (_specification.asyncUpload) // GPU only, doesn't touch the frame command buffer at all
 	{
-		VkBuffer stagingBuff;
-		VmaAllocation stagingAlloc;
-
-		VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = size;
-		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		VmaAllocationCreateInfo allocInfo{};
-		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-		allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-		allocInfo.priority = 1.0f;
-		allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-
-		VK_CHECK(vmaCreateBuffer(_allocatorObj.GetAllocatorHandle(), &bufferInfo, &allocInfo, &stagingBuff, &stagingAlloc, nullptr));
-		
-		void* buffData = nullptr;
-		VK_CHECK(vmaMapMemory(_allocatorObj.GetAllocatorHandle(), stagingAlloc, &buffData));
-		memcpy(buffData, newData, size);
-		vmaUnmapMemory(_allocatorObj.GetAllocatorHandle(), stagingAlloc);
-
-		VkBufferCopy copyRegion{};
-		copyRegion.srcOffset = 0;
-		copyRegion.dstOffset = offset;
-		copyRegion.size = size;
+		_lastUploadTicket = _frameObj.GetTransferQueue().UploadToBuffer(_buffer, offset, newData, size);
+	}
+	else // if buffer GPU only, data goes through the frame upload ring
+	{
+		VulkanUploadRing& uploadRing = _frameObj.GetUploadRing();
+
+		UploadRingAllocation stagingAlloc = uploadRing.Allocate(size);
+		memcpy(stagingAlloc.mappedPtr, newData, size);
 
 		if (_specification.allocCmdBuff)
 		{
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = stagingAlloc.offset;
+			copyRegion.dstOffset = offset;
+			copyRegion.size = size;
+
 			VulkanCommandBuffer cmdBuffer(_deviceObj, _frameObj.GetCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
 			cmdBuffer.BeginRecording();
 
-			vkCmdCopyBuffer(cmdBuffer.GetRawBuffer(), stagingBuff, _buffer, 1, &copyRegion);
+			vkCmdCopyBuffer(cmdBuffer.GetRawBuffer(), stagingAlloc.buffer, _buffer, 1, &copyRegion);
 
 			cmdBuffer.EndRecording();
 			constexpr bool shouldWait = true;
 			cmdBuffer.Submit(shouldWait);
 		}
-		else
-			vkCmdCopyBuffer(_frameObj.GetCommandBuffer(), stagingBuff, _buffer, 1, &copyRegion);
-
-		VmaAllocator allocator = _allocatorObj.GetAllocatorHandle();
-		VulkanDeleter::SubmitObjectDesctruction([allocator, stagingBuff, stagingAlloc]() {
-			vmaDestroyBuffer(allocator, stagingBuff, stagingAlloc);
-			});
+		else // Batched with the other copies into this buffer, recorded before the next pass
+			uploadRing.EnqueueCopy(stagingAlloc, _buffer, offset, size);
 	}
 }
 
@@ -269,4 +252,17 @@ namespace vkconversions
 			std::unreachable();
 		}
 	}
+
+	VkIndexType ToVkIndexType(IndexType type)
+	{
+		switch (type)
+		{
+		case IndexType::INDEX_TYPE_U16: return VK_INDEX_TYPE_UINT16;
+
+		case IndexType::INDEX_TYPE_U32: return VK_INDEX_TYPE_UINT32;
+
+		default:
+			std::unreachable();
+		}
+	}
 }
\ No newline at end of file
@@ -35,6 +35,24 @@ std::optional<u32> VulkanDevice::GetQueueFamilyIndex(VkPhysicalDevice physDevice
 	return std::nullopt;
 }
 
+// Purpose: find a family which supports flags but none of the excluded ones. Used for async queues
+std::optional<u32> VulkanDevice::GetDedicatedQueueFamilyIndex(VkPhysicalDevice physDevice, VkQueueFlags flags, VkQueueFlags excludedFlags) const
+{
+	u32 qCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physDevice, &qCount, 0);
+
+	std::vector<VkQueueFamilyProperties> queues(qCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physDevice, &qCount, queues.data());
+
+	for (u32 i = 0; i < qCount; ++i)
+	{
+		if ((queues[i].queueFlags & flags) == flags && (queues[i].queueFlags & excludedFlags) == 0)
+			return i;
+	}
+
+	return std::nullopt;
+}
+
 std::vector<u32> VulkanDevice::GetGraphicsFamilyIndices(VkPhysicalDevice physDevice, VkQueueFlagBits flagBits) const
 {
 	u32 qCount = 0;
@@ -110,11 +128,16 @@ bool VulkanDevice::QueryPhysDeviceFeatures(VkPhysicalDevice physDevice)
 	if (!queryVulkan11Features.shaderDrawParameters)
 		return false;
 
+	if (!features2.features.textureCompressionBC)
+		return false;
+
 	if (!queryVulkan12Features.bufferDeviceAddress)
 		// bufferDeviceAddressCaptureReplay for debug support if would need
 		return false;
 	if (!queryVulkan12Features.scalarBlockLayout)
 		return false;
+	if (!queryVulkan12Features.timelineSemaphore)
+		return false;
 
 	if (!queryVulkan12Features.descriptorIndexing ||
 		!queryVulkan12Features.shaderSampledImageArrayNonUniformIndexing ||
@@ -259,11 +282,22 @@ void VulkanDevice::CreateLogicalDevice()
 	auto presentationFamIndex = GetPresentationFamilyIndex();
 	Logger::Log("Vulkan found presentation queue family", true, presentationFamIndex.has_value(), LogLevel::Debug);
 
+	// Transfer only family is the DMA engine, the one without graphics is usually async compute, fine as well
+	auto transferFamIndex = GetDedicatedQueueFamilyIndex(_physDevice, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+	if (!transferFamIndex.has_value())
+		transferFamIndex = GetDedicatedQueueFamilyIndex(_physDevice, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT);
+	if (!transferFamIndex.has_value())
+	{
+		std::cout << "Vulkan: no dedicated transfer queue family, uploads would use the general one\n";
+		transferFamIndex = generalQueueFamIndex;
+	}
+
 	// Vulkan spec states: queue family indices should be unique only, so unordered_set
 	std::unordered_set<u32> qFamilies
 	{
 		generalQueueFamIndex.value(),
-		presentationFamIndex.value()
+		presentationFamIndex.value(),
+		transferFamIndex.value()
 	};
 	std::vector<VkDeviceQueueCreateInfo> qCreateInfos;
 
@@ -311,6 +345,7 @@ void VulkanDevice::CreateLogicalDevice()
 		.runtimeDescriptorArray = VK_TRUE,
 	
 		.scalarBlockLayout = VK_TRUE,
+		.timelineSemaphore = VK_TRUE, // async uploads
 		.bufferDeviceAddress = VK_TRUE,
 	};
 
@@ -331,6 +366,7 @@ void VulkanDevice::CreateLogicalDevice()
 
 	VkPhysicalDeviceFeatures2 deviceFeatures2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
 	deviceFeatures2.features.fragmentStoresAndAtomics = VK_TRUE; // to remove or create slang issue on git
+	deviceFeatures2.features.textureCompressionBC = VK_TRUE; // cooked textures
 	deviceFeatures2.pNext = &vulkan11Features;
 
 	VkDeviceCreateInfo deviceCreateInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
@@ -364,4 +400,11 @@ void VulkanDevice::CreateLogicalDevice()
 	VkQueue presentationQueue;
 	vkGetDeviceQueue(_device, presentationQInd, 0, &presentationQueue);
 	_queuesStorage[static_cast<size_t>(QueueType::VULKAN_PRESENTATION_QUEUE)] = presentationQueue;
+
+	// Transfer queue, could be the same VkQueue as general one
+	const u32 transferQInd = transferFamIndex.value();
+	_queueFamIndexStorage[static_cast<size_t>(QueueType::VULKAN_TRANSFER_QUEUE)] = transferQInd;
+	VkQueue transferQueue;
+	vkGetDeviceQueue(_device, transferQInd, 0, &transferQueue);
+	_queuesStorage[static_cast<size_t>(QueueType::VULKAN_TRANSFER_QUEUE)] = transferQueue;
 }
\ No newline at end of file
@@ -4,13 +4,16 @@
 #include "../../../headers/util/gfx/vk_helpers.h"
 #include "../../../headers/base/core/renderer.h"
 
-VulkanFrame::VulkanFrame(VulkanDevice& deviceObj, VulkanPresentation& presentationObj) : 
-				  _deviceObject{ deviceObj }, _presentationObject {presentationObj}
+VulkanFrame::VulkanFrame(VulkanDevice& deviceObj, VulkanPresentation& presentationObj, VulkanAllocator& allocatorObj) : 
+				  _deviceObject{ deviceObj }, _presentationObject {presentationObj}, _allocatorObject{ allocatorObj }
 {
 	CreateCommandPool();
 	CreateCommandBuffers();
 	CreateSynchronizationObjects();
 
+	_uploadRing = std::make_unique<VulkanUploadRing>(_deviceObject, _allocatorObject, FramesInFlight);
+	_transferQueue = std::make_unique<VulkanTransferQueue>(_deviceObject, _allocatorObject);
+
 }
 
 VkSemaphore VulkanFrame::GetImageAvailableSemaphore() const
@@ -96,6 +99,7 @@ void VulkanFrame::BeginFrame()
 	WaitForFence();
 
 	VulkanDeleter::ExecuteDeletion();
+	_uploadRing->BeginFrame(_currentFrame);
 
 	VkResult swapchainResultImageStage = vkAcquireNextImageKHR(device, swapchainDesc.swapchain,
 		UINT64_MAX, GetImageAvailableSemaphore(), VK_NULL_HANDLE, &_currentImage);
@@ -171,6 +175,9 @@ void VulkanFrame::EndCommandRecord()
 
 	assert(!swapchainDesc.images.empty() && "Vulkan swapchain images is empty in EndCommandRecord()");
 
+	// Uploads which weren't consumed by any pass still have to land this frame
+	FlushUploads();
+
 	vkhelpers::TransitionImageLayout(cmdBuffer, swapchainDesc.images[_currentImage]->GetRawImage(), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
 		VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, 0,
 		VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
@@ -178,6 +185,12 @@ void VulkanFrame::EndCommandRecord()
 	VK_CHECK(vkEndCommandBuffer(cmdBuffer));
 }
 
+void VulkanFrame::FlushUploads()
+{
+	_uploadRing->Flush(_commandBuffers[_currentFrame]);
+	_transferQueue->AcquireCompleted(_commandBuffers[_currentFrame]);
+}
+
 void VulkanFrame::WaitForFence()
 {
 	VK_CHECK(vkWaitForFences(_deviceObject.GetDevice(), 1, &_syncCPUFences[_currentFrame], VK_TRUE, UINT64_MAX));
@@ -196,6 +209,9 @@ void VulkanFrame::Cleanup()
 	std::vector<VkFence> fences = _syncCPUFences;
 	std::vector<VkSemaphore> rFinishedSemaphores = _renderFinishedSemaphores;
 
+	_uploadRing->Cleanup();
+	_transferQueue->Cleanup();
+
 	VulkanDeleter::SubmitObjectDesctruction([device, cmdPool, imgAvailableSemaphores, fences, rFinishedSemaphores]() {
 
 		vkDestroyCommandPool(device, cmdPool, nullptr);
@@ -4,7 +4,6 @@
 #include "../../../headers/base/gfx/vk_allocator.h"
 #include "../../../headers/util/gfx/vk_helpers.h"
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 VulkanImage::VulkanImage(const ImageSpecification& spec, VulkanDevice& deviceObj, VulkanFrame& frameObj, VulkanAllocator& allocatorObj) : 
@@ -72,38 +71,48 @@ VulkanImage::~VulkanImage()
 
 void VulkanImage::CreateTexture()
 {
-	stbi_set_flip_vertically_on_load(true);
-
-	int texWidth, texHeight, texChannels;
-
-	stbi_uc* pixels = stbi_load(_specification.path.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-
-	if (!pixels)
+	if (!_specification.mipOffsets.empty())
 	{
-		std::cout << "Failed to load image by path: " << _specification.path << '\n';
+		CreateTextureFromMips();
 		return;
 	}
 
-	void* pixelsVoid = pixels;
+	int texWidth = static_cast<int>(_specification.extent.x);
+	int texHeight = static_cast<int>(_specification.extent.y);
+	std::span<const u8> pixels = _specification.pixels;
+
+	// Decoded here only if the caller didn't do it in advance
+	stbi_uc* loadedPixels = nullptr;
+	if (pixels.empty())
+	{
+		stbi_set_flip_vertically_on_load(true);
+
+		int texChannels;
+		loadedPixels = stbi_load(_specification.path.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 
-	void* const& data = nullptr;
+		if (!loadedPixels)
+		{
+			std::cout << "Failed to load image by path: " << _specification.path << '\n';
+			return;
+		}
+
+		pixels = std::span<const u8>(loadedPixels, static_cast<size_t>(texWidth) * texHeight * 4);
+	}
 
-	const size_t imageSize = texWidth * texHeight * 4; // 4 bytes
+	// Pixels are owned by the caller, don't keep the view
+	_specification.pixels = {};
 
-	BufferSpecification spec{};
-	spec.usage = BufferUsage::TRANSFER_DST | BufferUsage::TRANSFER_SRC;
-	spec.memoryUsage = MemoryUsage::AUTO_PREFER_DEVICE;
-	spec.memoryProp = MemoryProperty::DEVICE_LOCAL;
-	spec.allocCreate = AllocationCreate::NONE;
-	spec.sharingMode = SharingMode::SHARING_EXCLUSIVE;
-	spec.size = imageSize;
+	const size_t imageSize = static_cast<size_t>(texWidth) * texHeight * 4; // 4 bytes
+	assert(pixels.size() >= imageSize && "Decoded pixels don't match the image extent");
 
 	assert(_deviceObject && _allocatorObject && _frameObject && "Trying to create a texture with raw created(without base class) vulkan image");
 
-	VulkanBuffer stagingBuffer(spec, *_deviceObject, *_allocatorObject, *_frameObject);
-	stagingBuffer.UploadData(0, pixelsVoid, imageSize);
+	// Offset must be a multiple of the texel size
+	UploadRingAllocation stagingAlloc = _frameObject->GetUploadRing().Allocate(imageSize, 16);
+	memcpy(stagingAlloc.mappedPtr, pixels.data(), imageSize);
 
-	stbi_image_free(pixels);
+	if (loadedPixels)
+		stbi_image_free(loadedPixels);
 
 
 	VkExtent3D imageExtent;
@@ -137,10 +146,6 @@ void VulkanImage::CreateTexture()
 
 
 	{
-		// Insert barrier for staging buffer
-		vkhelpers::InsertMemoryBarrier(cmdBuffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-			VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
-
 		// MAKE IMAGE AVAILABLE FOR DATA COPYING. This is only base mip level(0)
 		VkImageMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
 		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -174,7 +179,7 @@ void VulkanImage::CreateTexture()
 
 
 		VkBufferImageCopy copyRegion{};
-		copyRegion.bufferOffset = 0;
+		copyRegion.bufferOffset = stagingAlloc.offset;
 		copyRegion.bufferRowLength = 0;
 		copyRegion.bufferImageHeight = 0;
 
@@ -185,7 +190,7 @@ void VulkanImage::CreateTexture()
 		copyRegion.imageExtent = imageExtent;
 
 
-		vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer.GetRawBuffer(),
+		vkCmdCopyBufferToImage(cmdBuffer, stagingAlloc.buffer,
 			_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
 
 
@@ -346,6 +351,111 @@ void VulkanImage::CreateTexture()
 }
 
 
+void VulkanImage::CreateTextureFromMips()
+{
+	assert(_deviceObject && _allocatorObject && _frameObject && "Trying to create a texture with raw created(without base class) vulkan image");
+	assert(!_specification.pixels.empty() && "Trying to create a texture from mips without pixels");
+
+	const std::span<const u8> pixels = _specification.pixels;
+	const std::vector<u64> mipOffsets(_specification.mipOffsets.begin(), _specification.mipOffsets.end());
+
+	// Data is owned by the caller, don't keep the views
+	_specification.pixels = {};
+	_specification.mipOffsets = {};
+
+	const u32 mipLevels = static_cast<u32>(mipOffsets.size());
+	_specification.mipLevels = mipLevels;
+
+	// Offsets must be a multiple of the texel(block) size, levels are 16 bytes aligned inside the data
+	UploadRingAllocation stagingAlloc = _frameObject->GetUploadRing().Allocate(pixels.size(), 16);
+	memcpy(stagingAlloc.mappedPtr, pixels.data(), pixels.size());
+
+	VkExtent3D imageExtent{ _specification.extent.x, _specification.extent.y, 1 };
+	_specification.extent.z = 1;
+
+	VkFormat imgFormat = vkconversions::ToVkFormat(_specification.format);
+	VkImageAspectFlags aspect = vkconversions::ToVkAspectFlags(_specification.aspect);
+
+	VkImageCreateInfo createInfo = vkhelpers::CreateImageInfo(imgFormat, imageExtent, mipLevels, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+	allocInfo.memoryTypeBits = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	VK_CHECK(vmaCreateImage(_allocatorObject->GetAllocatorHandle(), &createInfo, &allocInfo, &_image, &_allocation, nullptr));
+
+	VkCommandBuffer cmdBuffer = _frameObject->GetCommandBuffer();
+
+	VkImageMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_2_NONE;
+	barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+	barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = _image;
+	barrier.subresourceRange =
+	{
+		.aspectMask = aspect,
+		.baseMipLevel = 0,
+		.levelCount = mipLevels,
+		.baseArrayLayer = 0,
+		.layerCount = 1
+	};
+
+	VkDependencyInfo dependencyInfo{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+	dependencyInfo.imageMemoryBarrierCount = 1;
+	dependencyInfo.pImageMemoryBarriers = &barrier;
+
+	vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
+
+	std::vector<VkBufferImageCopy> copyRegions(mipLevels);
+	for (u32 level = 0; level < mipLevels; ++level)
+	{
+		VkBufferImageCopy& copyRegion = copyRegions[level];
+		copyRegion.bufferOffset = stagingAlloc.offset + mipOffsets[level];
+		copyRegion.bufferRowLength = 0;
+		copyRegion.bufferImageHeight = 0;
+		copyRegion.imageSubresource.aspectMask = aspect;
+		copyRegion.imageSubresource.mipLevel = level;
+		copyRegion.imageSubresource.baseArrayLayer = 0;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageExtent = VkExtent3D{ std::max(1u, imageExtent.width >> level), std::max(1u, imageExtent.height >> level), 1 };
+	}
+
+	vkCmdCopyBufferToImage(cmdBuffer, stagingAlloc.buffer, _image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<u32>(copyRegions.size()), copyRegions.data());
+
+	// All the levels are ready at once
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+	barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+	barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+	vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
+
+	VkImageViewCreateInfo imgViewCreateInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+	imgViewCreateInfo.image = _image;
+	imgViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imgViewCreateInfo.format = imgFormat;
+	imgViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imgViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imgViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imgViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imgViewCreateInfo.subresourceRange.aspectMask = aspect;
+	imgViewCreateInfo.subresourceRange.baseMipLevel = 0;
+	imgViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	imgViewCreateInfo.subresourceRange.layerCount = 1;
+	imgViewCreateInfo.subresourceRange.levelCount = mipLevels;
+
+	VK_CHECK(vkCreateImageView(_deviceObject->GetDevice(), &imgViewCreateInfo, nullptr, &_imageView));
+}
+
+
 void VulkanImage::SetLayout(ImageLayout newLayout, AccessFlag srcAccess, AccessFlag dstAccess, PipelineStage srcStage, PipelineStage dstStage)
 {
 	// Transit image again to make it readable for the shader
@@ -468,6 +578,9 @@ namespace vkconversions
 		case ImageFormat::IMAGE_FORMAT_D32_SFLOAT:              return VK_FORMAT_D32_SFLOAT;
 		case ImageFormat::IMAGE_FORMAT_R16G16B16A16_SFLOAT:     return VK_FORMAT_R16G16B16A16_SFLOAT;
 		case ImageFormat::IMAGE_FORMAT_R32G32_UINT:             return VK_FORMAT_R32G32_UINT;
+		case ImageFormat::IMAGE_FORMAT_BC1_RGB_SRGB:            return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		case ImageFormat::IMAGE_FORMAT_BC5_UNORM:               return VK_FORMAT_BC5_UNORM_BLOCK;
+		case ImageFormat::IMAGE_FORMAT_BC7_SRGB:                return VK_FORMAT_BC7_SRGB_BLOCK;
 		default: std::unreachable();
 		}
 	}
@@ -580,6 +693,12 @@ namespace vkconversions
 			return ImageFormat::IMAGE_FORMAT_D32_SFLOAT;
 		case VK_FORMAT_R32G32_UINT:
 			return ImageFormat::IMAGE_FORMAT_R32G32_UINT;
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			return ImageFormat::IMAGE_FORMAT_BC1_RGB_SRGB;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			return ImageFormat::IMAGE_FORMAT_BC5_UNORM;
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return ImageFormat::IMAGE_FORMAT_BC7_SRGB;
 
 		default: std::unreachable();
 		}
@@ -22,6 +22,8 @@ void VulkanRenderer::EndFrame() const
 {
 	VulkanFrame& frameObject = _vulkanBase.GetFrameObj();
 	frameObject.EndCommandRecord();
+	// Async uploads recorded this frame go to the transfer queue before the graphics submission
+	frameObject.GetTransferQueue().Submit();
 	ExecuteCurrentCommands();
 	frameObject.EndFrame();
 }
@@ -42,16 +44,30 @@ void VulkanRenderer::ExecuteCurrentCommands() const
 
 	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
 
+	VulkanTransferQueue& transferQueue = _vulkanBase.GetFrameObj().GetTransferQueue();
+	// Wait for the transfer timeline only if the frame acquired async uploads, binary semaphores ignore values
+	const u64 transferTicket = transferQueue.ConsumeGraphicsWaitTicket();
+
 	VkPipelineStageFlags waitStages[]
 	{
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
 	};
-	VkSemaphore waitSemaphores[] = { _vulkanBase.GetFrameObj().GetImageAvailableSemaphore()};
+	VkSemaphore waitSemaphores[] = { _vulkanBase.GetFrameObj().GetImageAvailableSemaphore(), transferQueue.GetTimelineSemaphore() };
 	VkSemaphore signalSemaphores[] = { _vulkanBase.GetFrameObj().GetRenderFinishedSemaphore()};
+	const u64 waitValues[] = { 0, transferTicket };
+	const u64 signalValues[] = { 0 };
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+	timelineInfo.waitSemaphoreValueCount = transferTicket != 0 ? 2 : 1;
+	timelineInfo.pWaitSemaphoreValues = waitValues;
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = signalValues;
 
 	VkCommandBuffer cmdBuff = _vulkanBase.GetFrameObj().GetCommandBuffer();
 
-	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = transferTicket != 0 ? 2 : 1;
 	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 	submitInfo.commandBufferCount = 1;
@@ -66,6 +82,8 @@ void VulkanRenderer::ExecuteCurrentCommands() const
 
 void VulkanRenderer::BeginRender(const std::vector<Image*>& attachments, glm::vec4 clearColor) const
 {
+	_vulkanBase.GetFrameObj().FlushUploads();
+
 	VkCommandBuffer cmdBuffer = _vulkanBase.GetFrameObj().GetCommandBuffer();
 	const VulkanSwapchain& swapchainDesc = _vulkanBase.GetPresentationObj().GetSwapchainDesc();
 	const u32 imageIndex = _vulkanBase.GetFrameObj().GetCurrentImageIndex();
@@ -268,6 +286,8 @@ void VulkanRenderer::ExecuteBarriers(PipelineBarrierStorage& barriers) const
 
 void VulkanRenderer::DispatchCompute(const DispatchCommand& dispatchCommand) const
 {
+	_vulkanBase.GetFrameObj().FlushUploads();
+
 	VkCommandBuffer cmdBuffer = _vulkanBase.GetFrameObj().GetCommandBuffer();
 
 	VulkanPipeline* rawPipeline     = static_cast<VulkanPipeline*>(dispatchCommand.pipeline);
@@ -338,7 +358,7 @@ void VulkanRenderer::RenderIndirect(const RenderIndirectCountCommand& command) c
 	VkDescriptorSet descriptor = rawDescriptorSet->GetRawSet();
 
 	vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, rawPipeline->GetRawLayout(), 0, 1, &descriptor, 0, nullptr);
-	vkCmdBindIndexBuffer(cmdBuffer, rawIndexBuffer->GetRawBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(cmdBuffer, rawIndexBuffer->GetRawBuffer(), 0, vkconversions::ToVkIndexType(command.indexType));
 	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, rawPipeline->GetRawPipeline());
 	vkCmdDrawIndexedIndirectCount(cmdBuffer, rawIndirectBuffer->GetRawBuffer(), 0, 
 		rawIndirectBuffer->GetRawBuffer(), 
@@ -349,6 +369,8 @@ void VulkanRenderer::RenderIndirect(const RenderIndirectCountCommand& command) c
 
 void VulkanRenderer::RenderRayTracing(const RTDrawCommand& drawCommand) const
 {
+	_vulkanBase.GetFrameObj().FlushUploads();
+
 	VkCommandBuffer cmdBuffer = _vulkanBase.GetFrameObj().GetCommandBuffer();
 
 	VulkanRTPipeline* rawPipeline = static_cast<VulkanRTPipeline*>(drawCommand.rtPipeline);
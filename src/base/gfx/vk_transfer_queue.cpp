@@ -0,0 +1,303 @@
+#include "../../../headers/base/gfx/vk_transfer_queue.h"
+#include "../../../headers/base/gfx/vk_allocator.h"
+#include "../../../headers/base/gfx/vk_device.h"
+#include "../../../headers/base/gfx/vk_deleter.h"
+#include "../../../headers/util/gfx/vk_helpers.h"
+
+VulkanTransferQueue::VulkanTransferQueue(VulkanDevice& deviceObj, VulkanAllocator& allocatorObj) :
+	_deviceObj{ deviceObj }, _allocatorObj{ allocatorObj }
+{
+	auto transferFamily = _deviceObj.GetQueueIndexByType(QueueType::VULKAN_TRANSFER_QUEUE);
+	auto graphicsFamily = _deviceObj.GetQueueIndexByType(QueueType::VULKAN_GENERAL_QUEUE);
+	assert(transferFamily.has_value() && graphicsFamily.has_value() && "Transfer or general queue family is empty");
+
+	_transferFamily = transferFamily.value();
+	_graphicsFamily = graphicsFamily.value();
+
+	CreateTimelineSemaphore();
+}
+
+void VulkanTransferQueue::CreateTimelineSemaphore()
+{
+	VkSemaphoreTypeCreateInfo typeInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+	createInfo.pNext = &typeInfo;
+
+	VK_CHECK(vkCreateSemaphore(_deviceObj.GetDevice(), &createInfo, nullptr, &_timelineSemaphore));
+}
+
+std::unique_ptr<VulkanTransferQueue::TransferBatch> VulkanTransferQueue::CreateBatch()
+{
+	auto batch = std::make_unique<TransferBatch>();
+
+	VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = _transferFamily;
+	VK_CHECK(vkCreateCommandPool(_deviceObj.GetDevice(), &poolInfo, nullptr, &batch->cmdPool));
+
+	VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	allocateInfo.commandPool = batch->cmdPool;
+	allocateInfo.commandBufferCount = 1;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	VK_CHECK(vkAllocateCommandBuffers(_deviceObj.GetDevice(), &allocateInfo, &batch->cmdBuffer));
+
+	return batch;
+}
+
+void VulkanTransferQueue::BeginBatch()
+{
+	if (!_freeBatches.empty())
+	{
+		_openBatch = std::move(_freeBatches.back());
+		_freeBatches.pop_back();
+	}
+	else
+		_openBatch = CreateBatch();
+
+	// Pool is owned by the batch only, the whole pool could be reset
+	VK_CHECK(vkResetCommandPool(_deviceObj.GetDevice(), _openBatch->cmdPool, 0));
+
+	VkCommandBufferBeginInfo beginInfo = vkhelpers::CmdBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	VK_CHECK(vkBeginCommandBuffer(_openBatch->cmdBuffer, &beginInfo));
+
+	_openBatch->ticket = _lastSubmittedTicket + 1;
+}
+
+VulkanTransferQueue::StagingChunk& VulkanTransferQueue::AllocateStaging(TransferBatch& batch, u64 size, u64& outOffset)
+{
+	constexpr u64 alignment = 16;
+
+	if (!batch.stagingChunks.empty())
+	{
+		StagingChunk& lastChunk = batch.stagingChunks.back();
+		const u64 alignedHead = (lastChunk.head + alignment - 1) & ~(alignment - 1);
+		if (alignedHead + size <= lastChunk.capacity)
+		{
+			outOffset = alignedHead;
+			lastChunk.head = alignedHead + size;
+			return lastChunk;
+		}
+	}
+
+	StagingChunk chunk{};
+	chunk.capacity = std::max(StagingChunkSize, size);
+
+	VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = chunk.capacity;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+
+	VmaAllocationInfo allocationInfo{};
+	VK_CHECK(vmaCreateBuffer(_allocatorObj.GetAllocatorHandle(), &bufferInfo, &allocInfo, &chunk.buffer, &chunk.allocation, &allocationInfo));
+	chunk.mappedData = static_cast<byte*>(allocationInfo.pMappedData);
+	chunk.head = size;
+
+	outOffset = 0;
+	batch.stagingChunks.push_back(chunk);
+
+	return batch.stagingChunks.back();
+}
+
+u64 VulkanTransferQueue::UploadToBuffer(VkBuffer dstBuffer, u64 dstOffset, const void* data, u64 size)
+{
+	if (!_openBatch)
+		BeginBatch();
+
+	TransferBatch& batch = *_openBatch;
+
+	u64 stagingOffset = 0;
+	StagingChunk& chunk = AllocateStaging(batch, size, stagingOffset);
+	memcpy(chunk.mappedData + stagingOffset, data, size);
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = stagingOffset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(batch.cmdBuffer, chunk.buffer, dstBuffer, 1, &copyRegion);
+
+	// Same family: timeline wait is enough, no ownership to transfer
+	if (_transferFamily != _graphicsFamily)
+	{
+		if (!batch.ownershipBarriers.empty())
+		{
+			VkBufferMemoryBarrier2& lastBarrier = batch.ownershipBarriers.back();
+			if (lastBarrier.buffer == dstBuffer && lastBarrier.offset + lastBarrier.size == dstOffset)
+			{
+				lastBarrier.size += size;
+				return batch.ticket;
+			}
+		}
+
+		VkBufferMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+		barrier.dstAccessMask = VK_ACCESS_2_NONE;
+		barrier.srcQueueFamilyIndex = _transferFamily;
+		barrier.dstQueueFamilyIndex = _graphicsFamily;
+		barrier.buffer = dstBuffer;
+		barrier.offset = dstOffset;
+		barrier.size = size;
+
+		batch.ownershipBarriers.push_back(barrier);
+	}
+
+	return batch.ticket;
+}
+
+void VulkanTransferQueue::Submit()
+{
+	if (!_openBatch)
+		return;
+
+	TransferBatch& batch = *_openBatch;
+
+	// Release part of the ownership transfer
+	if (!batch.ownershipBarriers.empty())
+	{
+		VkDependencyInfo dependencyInfo{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<u32>(batch.ownershipBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = batch.ownershipBarriers.data();
+
+		vkCmdPipelineBarrier2(batch.cmdBuffer, &dependencyInfo);
+	}
+
+	VK_CHECK(vkEndCommandBuffer(batch.cmdBuffer));
+
+	VkCommandBufferSubmitInfo cmdBufferInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+	cmdBufferInfo.commandBuffer = batch.cmdBuffer;
+
+	VkSemaphoreSubmitInfo signalInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+	signalInfo.semaphore = _timelineSemaphore;
+	signalInfo.value = batch.ticket;
+	signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+	VkSubmitInfo2 submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+	submitInfo.commandBufferInfoCount = 1;
+	submitInfo.pCommandBufferInfos = &cmdBufferInfo;
+	submitInfo.signalSemaphoreInfoCount = 1;
+	submitInfo.pSignalSemaphoreInfos = &signalInfo;
+
+	const auto transferQueue = _deviceObj.GetQueueByType(QueueType::VULKAN_TRANSFER_QUEUE);
+	VK_CHECK(vkQueueSubmit2(transferQueue.value(), 1, &submitInfo, VK_NULL_HANDLE));
+
+	_lastSubmittedTicket = batch.ticket;
+	_submittedBatches.push_back(std::move(_openBatch));
+}
+
+void VulkanTransferQueue::AcquireCompleted(VkCommandBuffer graphicsCmdBuffer)
+{
+	if (_submittedBatches.empty())
+		return;
+
+	u64 completedTicket = 0;
+	VK_CHECK(vkGetSemaphoreCounterValue(_deviceObj.GetDevice(), _timelineSemaphore, &completedTicket));
+
+	std::vector<VkBufferMemoryBarrier2> acquireBarriers;
+	// Batches complete in order, so the residency is just the last acquired ticket
+	while (!_submittedBatches.empty() && _submittedBatches.front()->ticket <= completedTicket)
+	{
+		std::unique_ptr<TransferBatch> batch = std::move(_submittedBatches.front());
+		_submittedBatches.pop_front();
+
+		for (VkBufferMemoryBarrier2 barrier : batch->ownershipBarriers)
+		{
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+
+			acquireBarriers.push_back(barrier);
+		}
+
+		_lastAcquiredTicket = batch->ticket;
+		_graphicsWaitTicket = batch->ticket;
+
+		RecycleBatch(std::move(batch));
+	}
+
+	if (!acquireBarriers.empty())
+	{
+		VkDependencyInfo dependencyInfo{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<u32>(acquireBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = acquireBarriers.data();
+
+		vkCmdPipelineBarrier2(graphicsCmdBuffer, &dependencyInfo);
+	}
+}
+
+u64 VulkanTransferQueue::ConsumeGraphicsWaitTicket()
+{
+	const u64 ticket = _graphicsWaitTicket;
+	_graphicsWaitTicket = 0;
+	return ticket;
+}
+
+void VulkanTransferQueue::RecycleBatch(std::unique_ptr<TransferBatch> batch)
+{
+	// Transfer is complete, staging could be freed right now. Keep one default chunk for the next batch
+	VmaAllocator allocator = _allocatorObj.GetAllocatorHandle();
+	for (size_t i = 0; i < batch->stagingChunks.size(); ++i)
+	{
+		const bool keepChunk = i == 0 && batch->stagingChunks[i].capacity == StagingChunkSize;
+		if (!keepChunk)
+			vmaDestroyBuffer(allocator, batch->stagingChunks[i].buffer, batch->stagingChunks[i].allocation);
+	}
+
+	if (!batch->stagingChunks.empty() && batch->stagingChunks.front().capacity == StagingChunkSize)
+	{
+		batch->stagingChunks.resize(1);
+		batch->stagingChunks.front().head = 0;
+	}
+	else
+		batch->stagingChunks.clear();
+
+	batch->ownershipBarriers.clear();
+	batch->ticket = 0;
+
+	_freeBatches.push_back(std::move(batch));
+}
+
+void VulkanTransferQueue::DestroyBatch(TransferBatch& batch)
+{
+	VkDevice device = _deviceObj.GetDevice();
+	VmaAllocator allocator = _allocatorObj.GetAllocatorHandle();
+	VkCommandPool cmdPool = batch.cmdPool;
+	std::vector<StagingChunk> chunks = batch.stagingChunks;
+
+	VulkanDeleter::SubmitObjectDesctruction([device, allocator, cmdPool, chunks]() {
+		vkDestroyCommandPool(device, cmdPool, nullptr);
+		for (const StagingChunk& chunk : chunks)
+			vmaDestroyBuffer(allocator, chunk.buffer, chunk.allocation);
+	});
+}
+
+void VulkanTransferQueue::Cleanup()
+{
+	if (_openBatch)
+		DestroyBatch(*_openBatch);
+
+	for (auto& batch : _submittedBatches)
+		DestroyBatch(*batch);
+
+	for (auto& batch : _freeBatches)
+		DestroyBatch(*batch);
+
+	_openBatch.reset();
+	_submittedBatches.clear();
+	_freeBatches.clear();
+
+	VkDevice device = _deviceObj.GetDevice();
+	VkSemaphore timelineSemaphore = _timelineSemaphore;
+	VulkanDeleter::SubmitObjectDesctruction([device, timelineSemaphore]() {
+		vkDestroySemaphore(device, timelineSemaphore, nullptr);
+	});
+}
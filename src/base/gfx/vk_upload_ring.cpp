@@ -0,0 +1,214 @@
+#include "../../../headers/base/gfx/vk_upload_ring.h"
+#include "../../../headers/base/gfx/vk_allocator.h"
+#include "../../../headers/base/gfx/vk_device.h"
+#include "../../../headers/base/gfx/vk_deleter.h"
+#include "../../../headers/util/gfx/vk_helpers.h"
+
+VulkanUploadRing::VulkanUploadRing(VulkanDevice& deviceObj, VulkanAllocator& allocatorObj, u32 regionsCount) :
+	_deviceObj{ deviceObj }, _allocatorObj{ allocatorObj }
+{
+	_regions.resize(regionsCount);
+
+	for (RingRegion& region : _regions)
+		CreateRegion(region, DefaultRegionSize);
+}
+
+void VulkanUploadRing::CreateRegion(RingRegion& region, u64 capacity)
+{
+	VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = capacity;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+
+	VmaAllocationInfo allocationInfo{};
+	VK_CHECK(vmaCreateBuffer(_allocatorObj.GetAllocatorHandle(), &bufferInfo, &allocInfo, &region.buffer, &region.allocation, &allocationInfo));
+
+	region.mappedData = static_cast<byte*>(allocationInfo.pMappedData);
+	region.capacity = capacity;
+	region.head = 0;
+
+	assert(region.mappedData && "Upload ring region is not mapped");
+}
+
+void VulkanUploadRing::DestroyRegion(RingRegion& region)
+{
+	if (region.buffer == VK_NULL_HANDLE)
+		return;
+
+	// Could be still referenced by the recorded or queued copies
+	VmaAllocator allocator = _allocatorObj.GetAllocatorHandle();
+	VkBuffer buffer = region.buffer;
+	VmaAllocation allocation = region.allocation;
+	VulkanDeleter::SubmitObjectDesctruction([allocator, buffer, allocation]() {
+		vmaDestroyBuffer(allocator, buffer, allocation);
+	});
+
+	region = RingRegion{};
+}
+
+void VulkanUploadRing::GrowRegion(RingRegion& region, u64 requiredSize)
+{
+	const u64 newCapacity = std::max(region.capacity * 2, requiredSize);
+
+	if (!_hasWarnedGrowth)
+	{
+		Logger::Log("Upload ring region fits the frame uploads without growing", true, false, LogLevel::Warn);
+		_hasWarnedGrowth = true;
+	}
+
+	// Old allocations stay valid until the deleter frees the old buffer, new ones start from zero
+	DestroyRegion(region);
+	CreateRegion(region, newCapacity);
+}
+
+UploadRingAllocation VulkanUploadRing::Allocate(u64 size, u64 alignment)
+{
+	RingRegion& region = _regions[_currentRegion];
+
+	u64 alignedHead = (region.head + alignment - 1) & ~(alignment - 1);
+	if (alignedHead + size > region.capacity)
+	{
+		GrowRegion(region, size);
+		alignedHead = 0;
+	}
+
+	region.head = alignedHead + size;
+
+	UploadRingAllocation result{};
+	result.buffer = region.buffer;
+	result.offset = alignedHead;
+	result.mappedPtr = region.mappedData + alignedHead;
+
+	return result;
+}
+
+void VulkanUploadRing::EnqueueCopy(const UploadRingAllocation& src, VkBuffer dstBuffer, u64 dstOffset, u64 size)
+{
+	if (size == 0)
+		return;
+
+	VkBufferCopy newRegion{};
+	newRegion.srcOffset = src.offset;
+	newRegion.dstOffset = dstOffset;
+	newRegion.size = size;
+
+	// Search from the end, the latest batch for the destination is the only one which could be extended
+	for (auto it = _pendingBatches.rbegin(); it != _pendingBatches.rend(); ++it)
+	{
+		if (it->dstBuffer != dstBuffer)
+			continue;
+
+		if (it->srcBuffer != src.buffer)
+			break;
+
+		// Mesh data is appended in order, so in the common case the scan is skipped
+		bool overlaps = false;
+		if (dstOffset < it->dstEnd)
+		{
+			for (VkBufferCopy& region : it->regions)
+			{
+				const bool sameRange = region.dstOffset == dstOffset && region.size == size;
+				if (sameRange) // Last write wins, no need to copy the same range twice
+				{
+					region.srcOffset = src.offset;
+					return;
+				}
+
+				if (dstOffset < region.dstOffset + region.size && region.dstOffset < dstOffset + size)
+				{
+					overlaps = true;
+					break;
+				}
+			}
+		}
+
+		if (overlaps) // Regions inside one vkCmdCopyBuffer don't have any order, start a new batch
+			break;
+
+		VkBufferCopy& lastRegion = it->regions.back();
+		const bool isAdjacent = lastRegion.srcOffset + lastRegion.size == newRegion.srcOffset &&
+			lastRegion.dstOffset + lastRegion.size == newRegion.dstOffset;
+
+		if (isAdjacent)
+			lastRegion.size += size;
+		else
+			it->regions.push_back(newRegion);
+
+		it->dstEnd = std::max(it->dstEnd, dstOffset + size);
+
+		return;
+	}
+
+	PendingCopyBatch batch{};
+	batch.srcBuffer = src.buffer;
+	batch.dstBuffer = dstBuffer;
+	batch.dstEnd = dstOffset + size;
+	batch.regions.push_back(newRegion);
+
+	_pendingBatches.push_back(std::move(batch));
+}
+
+void VulkanUploadRing::Flush(VkCommandBuffer cmdBuffer)
+{
+	if (_pendingBatches.empty())
+		return;
+
+	// Previous readers/writers of the destinations must finish before the copy
+	vkhelpers::InsertMemoryBarrier(cmdBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		VK_ACCESS_2_MEMORY_WRITE_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+	std::vector<VkBuffer> writtenBuffers;
+	for (const PendingCopyBatch& batch : _pendingBatches)
+	{
+		if (std::find(writtenBuffers.begin(), writtenBuffers.end(), batch.dstBuffer) != writtenBuffers.end())
+		{
+			vkhelpers::InsertMemoryBarrier(cmdBuffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+				VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+			writtenBuffers.clear();
+		}
+
+		vkCmdCopyBuffer(cmdBuffer, batch.srcBuffer, batch.dstBuffer, static_cast<u32>(batch.regions.size()), batch.regions.data());
+		writtenBuffers.push_back(batch.dstBuffer);
+	}
+
+	vkhelpers::InsertMemoryBarrier(cmdBuffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT);
+
+	_pendingBatches.clear();
+}
+
+void VulkanUploadRing::BeginFrame(u32 frameIndex)
+{
+	assert(frameIndex < _regions.size() && "Upload ring has less regions than frames in flight");
+
+	// Copies queued outside of the frame are recorded in this frame, their region must survive until its fence
+	const bool hasPendingCopies = !_pendingBatches.empty();
+	if (hasPendingCopies && frameIndex != _currentRegion)
+		_regions[_currentRegion].skipNextReset = true;
+
+	const bool keepPendingData = hasPendingCopies && frameIndex == _currentRegion;
+	_currentRegion = frameIndex;
+
+	RingRegion& region = _regions[_currentRegion];
+	if (region.skipNextReset)
+	{
+		region.skipNextReset = false;
+		return;
+	}
+
+	if (!keepPendingData)
+		region.head = 0;
+}
+
+void VulkanUploadRing::Cleanup()
+{
+	_pendingBatches.clear();
+
+	for (RingRegion& region : _regions)
+		DestroyRegion(region);
+}
@@ -0,0 +1,34 @@
+#include "../../headers/scene/component.h"
+
+void TransformComponent::SetLocalMatrix(const glm::mat4& localTransform)
+{
+	glm::mat3 rotation = glm::mat3(localTransform);
+	glm::vec3 scale = glm::vec3(glm::length(rotation[0]), glm::length(rotation[1]), glm::length(rotation[2]));
+
+	// Mirrored basis keeps a proper rotation with the negative scale on one axis
+	if (glm::determinant(rotation) < 0.0f)
+		scale.x = -scale.x;
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		if (scale[axis] != 0.0f)
+			rotation[axis] /= scale[axis];
+	}
+
+	_translation = glm::vec3(localTransform[3]);
+	_rotation = glm::normalize(glm::quat_cast(rotation));
+	_scale = scale;
+	_isDirty = true;
+}
+
+glm::mat4 TransformComponent::GetLocalMatrix() const
+{
+	const glm::mat3 rotation = glm::mat3_cast(_rotation);
+
+	glm::mat4 result{ 1.0f };
+	result[0] = glm::vec4(rotation[0] * _scale.x, 0.0f);
+	result[1] = glm::vec4(rotation[1] * _scale.y, 0.0f);
+	result[2] = glm::vec4(rotation[2] * _scale.z, 0.0f);
+	result[3] = glm::vec4(_translation, 1.0f);
+	return result;
+}
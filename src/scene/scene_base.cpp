@@ -13,18 +13,29 @@ SceneBase::SceneBase(SceneRenderer& renderer, SceneStorage& storage) : _renderer
 }
 
 
-ComponentList* SceneBase::GetComponentListByEntity(const Entity& entity)
+Entity SceneBase::CreateEntity()
 {
-	return _storageInstance.GetComponentListByEntity(entity);
+	return _storageInstance.CreateEntityInRegistry(this);
 }
 
+void SceneBase::DestroyEntity(const Entity& entity)
+{
+	// Its draws are released while the entity still has its instances
+	_rendererInstance.ReleaseEntityInstances(entity);
+	_storageInstance.DestroyEntity(entity);
+}
+
+Entity SceneBase::GetEntity(u32 entityID)
+{
+	return _storageInstance.GetEntity(entityID, this);
+}
 
 
 void SceneBase::Initialize()
 {
 	constexpr bool cameraIsActive = true;
 
-	const Entity& sponza = _storageInstance.CreateEntityInRegistry(this);
+	const Entity sponza = _storageInstance.CreateEntityInRegistry(this);
 	sponza.AddComponent<TagComponent>("Sponza");
 	sponza.AddComponent<CameraComponent>(_camera, cameraIsActive);
 	sponza.AddComponent<MeshComponent>();
@@ -40,10 +51,13 @@ void SceneBase::Initialize()
 
 void SceneBase::Update()
 {
-	for (const auto& [ett, comps] : _storageInstance.GetRegistry())
-	{
-		//_rendererInstance.SubmitEntityToDraw(ett);
-	}	
+	// World matrices are ready before the renderer reads them
+	_transformHierarchy.Update(_storageInstance);
+
+	_storageInstance.GetView<MeshComponent, TransformComponent>().Each([&](u32 entityID, MeshComponent&, TransformComponent&)
+		{
+			//_rendererInstance.SubmitEntityToDraw(GetEntity(entityID));
+		});
 }
 
 void SceneBase::UpdateWithKeys(const Window& window)
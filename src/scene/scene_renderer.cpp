@@ -2,8 +2,12 @@
 #include "../../headers/scene/entity.h"
 #include "../../headers/base/core/frame_manager.h"
 #include "../../headers/base/core/presentation_manager.h"
+#include "../../headers/asset/vertex_packing.h"
+#include "../../headers/asset/mesh_bounds.h"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstddef>
 
 SceneRenderer::SceneRenderer(EngineBase& engineBase) : _engineBase{engineBase}
 {
@@ -155,11 +159,11 @@ SceneRenderer::SceneRenderer(EngineBase& engineBase) : _engineBase{engineBase}
 		spec.memoryUsage = MemoryUsage::AUTO_PREFER_DEVICE;
 		spec.memoryProp = MemoryProperty::DEVICE_LOCAL;
 		spec.sharingMode = SharingMode::SHARING_EXCLUSIVE;
-		spec.size = 1024 * sizeof(DrawIndexedIndirectCommand); // +1 for count buffer
+		spec.size = (IndirectDrawBatch::MaxDrawsCount + 1) * sizeof(DrawIndexedIndirectCommand); // +1 for count buffer
 
 		
-		_indirectBuffer.opaqueBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
-		_indirectBuffer.maskBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
+		for (IndirectDrawBatch* batch : GetIndirectBatches())
+			batch->commandsBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
 
 		// count buffer is at the end
 		_indirectBuffer.countBufferOffset = spec.size - sizeof(DrawIndexedIndirectCommand);
@@ -167,30 +171,60 @@ SceneRenderer::SceneRenderer(EngineBase& engineBase) : _engineBase{engineBase}
 	
 	// All scene meshes buffer
 	{
-		constexpr u32 size = sizeof(Vertex) * 1024 * 1024; // about 1 million vertices
+		constexpr u32 size = vertexpacking::MaxStride * 1024 * 1024; // at least 1 million packed vertices
+		constexpr u32 indexBufferSize = sizeof(u32) * 11 * 1024 * 1024; // about 3.7 million triangles
 		BufferSpecification spec{};
 		spec.usage = BufferUsage::VERTEX_BUFFER | BufferUsage::TRANSFER_DST | BufferUsage::SHADER_DEVICE_ADDRESS;
 		spec.memoryUsage = MemoryUsage::AUTO_PREFER_DEVICE;
 		spec.memoryProp = MemoryProperty::DEVICE_LOCAL;
 		spec.sharingMode = SharingMode::SHARING_EXCLUSIVE;
 		spec.size = size;
+		spec.asyncUpload = true; // geometry is streamed through the transfer queue
 
 		_meshDeviceBuffer.vertexBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
 
 		spec.usage = BufferUsage::INDEX_BUFFER | BufferUsage::TRANSFER_DST | BufferUsage::SHADER_DEVICE_ADDRESS;
+		spec.size = indexBufferSize;
 		_meshDeviceBuffer.indexBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
 
+		// most of the submeshes have less than 65536 vertices
+		spec.size = indexBufferSize / 2;
+		_meshDeviceBuffer.index16Buffer = _engineBase.GetBufferManager().CreateBuffer(spec);
+
+		// Meshlets, 64 vertices and 124 triangles at most per meshlet
+		spec.usage = BufferUsage::STORAGE_BUFFER | BufferUsage::TRANSFER_DST | BufferUsage::SHADER_DEVICE_ADDRESS;
+		spec.size = sizeof(Meshlet) * 64 * 1024;
+		_meshDeviceBuffer.meshletBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
+
+		spec.size = sizeof(u32) * 2 * 1024 * 1024; // vertices on the meshlets borders are duplicated
+		_meshDeviceBuffer.meshletVertexBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
+
+		spec.size = indexBufferSize / sizeof(u32); // 3 bytes per triangle instead of 3 indices
+		_meshDeviceBuffer.meshletTriangleBuffer = _engineBase.GetBufferManager().CreateBuffer(spec);
+
+		spec.asyncUpload = false;
 
 
 		// common buffer with transformations, materials and their indices
 		spec.usage = BufferUsage::STORAGE_BUFFER | BufferUsage::TRANSFER_DST | BufferUsage::SHADER_DEVICE_ADDRESS;
-		spec.size = sizeof(CommonIndirectData) * 1024; // 1024 materials, transformations etc
+		spec.size = sizeof(CommonIndirectData) * IndirectDrawBatch::MaxInstancesCount; // materials, transformations etc per instance
+
+		for (IndirectDrawBatch* batch : GetIndirectBatches())
+		{
+			for (u32 frame = 0; frame < VulkanFrame::FramesInFlight; ++frame)
+				batch->commonData.push_back(_engineBase.GetBufferManager().CreateBuffer(spec));
+		}
 
-		// opaque
-		_indirectBuffer.commonOpaqueData = _engineBase.GetBufferManager().CreateBuffer(spec);
+		// bounds of the same instances for the culling
+		spec.size = sizeof(InstanceBounds) * IndirectDrawBatch::MaxInstancesCount;
+		for (IndirectDrawBatch* batch : GetIndirectBatches())
+		{
+			for (u32 frame = 0; frame < VulkanFrame::FramesInFlight; ++frame)
+				batch->boundsData.push_back(_engineBase.GetBufferManager().CreateBuffer(spec));
+		}
 
-		// masked
-		_indirectBuffer.commonMaskedData = _engineBase.GetBufferManager().CreateBuffer(spec);
+		for (IndirectBatchRecords& records : _batchRecords)
+			records.dirtyRanges.resize(VulkanFrame::FramesInFlight);
 
 	}
 
@@ -301,6 +335,11 @@ void SceneRenderer::Update(const Camera& camera)
 
 
 	ExecuteEntityCreateQueue();
+	FinalizeStreamedMeshes(camera);
+	PublishResidentDraws();
+	UpdateMovedInstances();
+	UploadDirtyRecords();
+	SelectDrawLods(camera);
 	
 	//// Camera data buffer
 	ViewData viewData;
@@ -322,18 +361,23 @@ void SceneRenderer::UpdateDescriptors()
 
 	for (u32 descInd = 0; descInd < VulkanFrame::FramesInFlight; ++descInd)
 	{
-		u32 availableIndex = 0;
 		// Main shading pass
 		const auto& allTextures = AssetManager::Get()->GetAllTextures(); // TEMPORARY SOLUTION. TO REWORK
 
-		assert(!allTextures.empty() && "Images size is zero");
+		// Textures might be still streaming, G-buffer ones are written anyway
 		for (u32 i = 0; i < allTextures.size(); ++i)
 		{
+			// Released texture slot waits to be reused
+			if (!allTextures[i].second)
+				continue;
+
 			_sceneDescriptorSets[descInd]->Write(0, allTextures[i].first,
 				DescriptorType::COMBINED_IMAGE_SAMPLER, allTextures[i].second.get(), _samplerLinear.get());
-			++availableIndex;
 		}
 
+		// Texture indices start from 1, so the last one is equal to the textures count
+		u32 availableIndex = static_cast<u32>(allTextures.size()) + 1;
+
 		_gBuffer.posIndex    = availableIndex++;
 		_gBuffer.normalIndex = availableIndex++;
 		_gBuffer.baseIndex   = availableIndex++;
@@ -404,52 +448,11 @@ void SceneRenderer::Draw()
 		_gBuffer.baseColor.get(), _gBuffer.metallicRoughness.get(), _currentDepthAttachment },
 			glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-		// Opaque objects
-        IndirectPushConst opaqPushConst{};
-		opaqPushConst.vertexAddress = _meshDeviceBuffer.vertexBuffer->GetBufferAddress();
-		opaqPushConst.commonMeshDataAddress = _indirectBuffer.commonOpaqueData->GetBufferAddress();
-		opaqPushConst.viewDataAddress = _viewDataBuffer->GetBufferAddress();
-		opaqPushConst.baseDrawOffset = 0;
-
-
-		PushConsts opaqPushConstants;
-		opaqPushConstants.data = (byte*)&opaqPushConst;
-		opaqPushConstants.size = sizeof(IndirectPushConst);
-
-		RenderIndirectCountCommand opaqueCommand;
-		opaqueCommand.buffer = _indirectBuffer.opaqueBuffer.get();
-		opaqueCommand.indexBuffer = _meshDeviceBuffer.indexBuffer.get();
-		opaqueCommand.descriptor = _sceneDescriptorSets[frameManager.GetCurrentFrameIndex()].get();
-		opaqueCommand.pipeline = _gBufferPipelines.opaquePipeline.get();
-		opaqueCommand.pushConstants = opaqPushConstants;
-		opaqueCommand.maxDrawCount = _indirectBuffer.currentOpaqueSize; // count of different materials basically
-		opaqueCommand.countBufferOffsetBytes = _indirectBuffer.countBufferOffset;
-
-		Renderer::RenderIndirect(opaqueCommand);
-
-
-
-		// Masked objects
-        IndirectPushConst maskedPushConst{};
-		maskedPushConst.vertexAddress = _meshDeviceBuffer.vertexBuffer->GetBufferAddress();
-		maskedPushConst.commonMeshDataAddress = _indirectBuffer.commonMaskedData->GetBufferAddress();
-		maskedPushConst.viewDataAddress = _viewDataBuffer->GetBufferAddress();
-		maskedPushConst.baseDrawOffset  = _indirectBuffer.currentOpaqueSize;
-
-		PushConsts maskedPushConstants;
-		maskedPushConstants.data = (byte*)&maskedPushConst;
-		maskedPushConstants.size = sizeof(IndirectPushConst);
-
-		RenderIndirectCountCommand maskedCommand;
-		maskedCommand.buffer = _indirectBuffer.maskBuffer.get();
-		maskedCommand.descriptor = _sceneDescriptorSets[frameManager.GetCurrentFrameIndex()].get();
-		maskedCommand.pipeline = _gBufferPipelines.maskPipeline.get();
-		maskedCommand.indexBuffer = _meshDeviceBuffer.indexBuffer.get();
-		maskedCommand.maxDrawCount = _indirectBuffer.currentMaskedSize;
-		maskedCommand.pushConstants = maskedPushConstants;
-		maskedCommand.countBufferOffsetBytes = _indirectBuffer.countBufferOffset;
-
-		Renderer::RenderIndirect(maskedCommand);
+		// Opaque objects, then masked ones. Every index type is a separate indirect call
+		RenderIndirectBatch(_indirectBuffer.opaqueBatch, _gBufferPipelines.opaquePipeline.get(), IndexType::INDEX_TYPE_U32);
+		RenderIndirectBatch(_indirectBuffer.opaque16Batch, _gBufferPipelines.opaquePipeline.get(), IndexType::INDEX_TYPE_U16);
+		RenderIndirectBatch(_indirectBuffer.maskedBatch, _gBufferPipelines.maskPipeline.get(), IndexType::INDEX_TYPE_U32);
+		RenderIndirectBatch(_indirectBuffer.masked16Batch, _gBufferPipelines.maskPipeline.get(), IndexType::INDEX_TYPE_U16);
 
 		Renderer::EndRender();
 	}
@@ -566,136 +569,754 @@ void SceneRenderer::ExecuteEntityCreateQueue()
 {
 	while (!_entityCreateQueue.empty())
 	{
-		if (_entityCreateQueue.front() == nullptr)
+		const Entity entity = _entityCreateQueue.front();
+		if (!entity.IsAlive())
 		{
 			_entityCreateQueue.pop();
 			continue;
 		}
 
-		const Entity& entity = *_entityCreateQueue.front();
+		// Model is loaded in the background, the entity is drawn once its data is resident
+		if (const MeshComponent* meshComp = entity.GetComponent<MeshComponent>())
+		{
+			const TransformComponent* transComp = entity.GetComponent<TransformComponent>();
+			const glm::vec3 position = transComp ? glm::vec3(transComp->model[3]) : glm::vec3(0.0f);
+			_streamingEntities.insert({ AssetManager::Get()->GetStreamer().Enqueue(meshComp->folderName, position), entity });
+		}
 
-		MeshComponent* meshComp = entity.GetComponent<MeshComponent>();
-		// Check if buffer exist
-		if (meshComp != nullptr)
+		// TO REPLACE!!!!!!!!!!!!
+		_pointLightsBuffer->UploadData(0, _pointLights.data(), sizeof(PointLight)* _pointLights.size());
+		UpdateDescriptors();
+
+		_entityCreateQueue.pop();
+	}
+}
+
+
+// Purpose: world transforms of the submesh instances, every node which references a mesh instances all its submeshes.
+// Nodes of the model become entities parented as in the model, so they follow the model entity and own their instances.
+// The model without nodes is drawn once with the entity transform
+std::vector<std::vector<SubmeshInstance>> SceneRenderer::InstantiateModelNodes(const Entity& entity, u32 meshIndex, size_t submeshesCount)
+{
+	const TransformComponent* transComp = entity.GetComponent<TransformComponent>();
+	const glm::mat4 entityModel = transComp ? transComp->model : glm::mat4(1.0f);
+
+	std::vector<std::vector<SubmeshInstance>> result(submeshesCount);
+	const ModelHierarchy* hierarchy = AssetManager::Get()->GetAssetHierarchy(meshIndex);
+	if (hierarchy == nullptr || hierarchy->nodes.empty())
+	{
+		for (auto& instances : result)
+			instances.push_back(SubmeshInstance{ entityModel, entity });
+
+		return result;
+	}
+
+	SceneBase* scene = entity.GetScene();
+	const u32 rootParent = transComp ? entity.GetID() : TransformComponent::NoParent;
+
+	// Parents go first, so their world transforms are ready
+	std::vector<glm::mat4> worldTransforms(hierarchy->nodes.size());
+	std::vector<u32> nodeEntities(hierarchy->nodes.size());
+	for (size_t i = 0; i < hierarchy->nodes.size(); ++i)
+	{
+		const ModelNode& node = hierarchy->nodes[i];
+		const glm::mat4& parentTransform = node.parent == ModelNode::NoParent ? entityModel : worldTransforms[node.parent];
+		worldTransforms[i] = parentTransform * node.localTransform;
+
+		const Entity nodeEntity = scene->CreateEntity();
+		nodeEntity.AddComponent<TagComponent>(node.name);
+		nodeEntity.AddComponent<TransformComponent>(node.localTransform);
+		scene->GetTransformHierarchy().SetParent(scene->GetStorage(), nodeEntity.GetID(),
+			node.parent == ModelNode::NoParent ? rootParent : nodeEntities[node.parent]);
+		nodeEntities[i] = nodeEntity.GetID();
+
+		if (node.mesh == ModelNode::NoMesh)
+			continue;
+
+		const MeshSubmeshRange& range = hierarchy->meshes[node.mesh];
+		for (u32 submesh = range.firstSubmesh; submesh < range.firstSubmesh + range.submeshCount && submesh < submeshesCount; ++submesh)
+			result[submesh].push_back(SubmeshInstance{ worldTransforms[i], nodeEntity });
+	}
+
+	return result;
+}
+
+// Purpose: the whole model has to fit the rest of every global mesh buffer, nothing is uploaded otherwise.
+// Submeshes which no node references are counted as well, so the model is checked before its nodes are created
+bool SceneRenderer::FitsMeshBuffers(const std::vector<SubmeshDescription>& submeshes) const
+{
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+	size_t index16Bytes = 0;
+	size_t meshletBytes = 0;
+	size_t meshletVertexBytes = 0;
+	size_t meshletTriangleBytes = 0;
+
+	for (const SubmeshDescription& submesh : submeshes)
+	{
+		vertexBytes += submesh.vertexDesc.vertexCount * vertexpacking::GetStride(submesh.vertexEncoding);
+		const size_t indexSize = submesh.vertexDesc.indexCount * vertexpacking::GetIndexSize(submesh.indexType);
+		(submesh.indexType == IndexType::INDEX_TYPE_U16 ? index16Bytes : indexBytes) += indexSize;
+
+		meshletBytes += submesh.meshletDesc.meshletsCount * sizeof(Meshlet);
+		meshletVertexBytes += submesh.meshletDesc.verticesCount * sizeof(u32);
+		meshletTriangleBytes += submesh.meshletDesc.trianglesBytesCount;
+	}
+
+	const auto fits = [](const std::unique_ptr<Buffer>& buffer, size_t offset, size_t size)
 		{
-			auto loadingResult = AssetManager::Get()->TryToLoadAndStoreMesh(meshComp->folderName, &_engineBase.GetImageManager());
-			if (!loadingResult.has_value())
-				return;
-
-			u32 meshIndex = loadingResult->meshIndex;
-			meshComp->meshIndex = meshIndex;
-			meshComp->materialIndex = loadingResult->materialIndex;
-			if (meshIndex != 0)
-			{
-				const std::vector<SubmeshDescription>* submeshes = AssetManager::Get()->GetAssetSubmeshes(meshIndex);
-				if (submeshes == nullptr)
-					return;
+			return offset + size <= buffer->GetSpecification().size;
+		};
 
-				for (auto submeshIt = submeshes->begin(); submeshIt != submeshes->end(); ++submeshIt)
+	return fits(_meshDeviceBuffer.vertexBuffer, _meshDeviceBuffer.currentVertexOffset, vertexBytes) &&
+		fits(_meshDeviceBuffer.indexBuffer, _meshDeviceBuffer.currentIndexOffset * sizeof(u32), indexBytes) &&
+		fits(_meshDeviceBuffer.index16Buffer, _meshDeviceBuffer.currentIndex16Offset * sizeof(u16), index16Bytes) &&
+		fits(_meshDeviceBuffer.meshletBuffer, _meshDeviceBuffer.currentMeshletOffset * sizeof(Meshlet), meshletBytes) &&
+		fits(_meshDeviceBuffer.meshletVertexBuffer, _meshDeviceBuffer.currentMeshletVertexOffset * sizeof(u32), meshletVertexBytes) &&
+		fits(_meshDeviceBuffer.meshletTriangleBuffer, _meshDeviceBuffer.currentMeshletTriangleOffset, meshletTriangleBytes);
+}
+
+// Purpose: geometry of the stored mesh goes to the global buffers once, its instances share it in one draw.
+// Draws wait in the pending ones until the geometry is resident. Returns bytes of the uploaded geometry
+u64 SceneRenderer::UploadEntityMeshes(const Entity& entity, u32 meshIndex)
+{
+	u64 uploadedBytes = 0;
+	if (meshIndex != 0)
+	{
+		const std::vector<SubmeshDescription>* submeshes = AssetManager::Get()->AcquireGeometry(meshIndex);
+		if (submeshes == nullptr)
+			return 0;
+
+		if (!FitsMeshBuffers(*submeshes))
+		{
+			std::cout << "Global mesh buffers are full, model " << meshIndex << " isn't uploaded\n";
+			return 0;
+		}
+
+		const std::vector<std::vector<SubmeshInstance>> submeshInstances = InstantiateModelNodes(entity, meshIndex, submeshes->size());
+
+		for (auto submeshIt = submeshes->begin(); submeshIt != submeshes->end(); ++submeshIt)
+		{
+			// Submesh which no node references isn't drawn
+			const u32 submeshIndex = static_cast<u32>(submeshIt - submeshes->begin());
+			const std::vector<SubmeshInstance>& instances = submeshInstances[submeshIndex];
+			if (instances.empty())
+				continue;
+
+			const VertexEncoding& vertexEncoding = submeshIt->vertexEncoding;
+			const size_t vertexSize = submeshIt->vertexDesc.vertexCount * vertexpacking::GetStride(vertexEncoding);
+			const IndexType indexType = submeshIt->indexType;
+			const size_t indexSize = submeshIt->vertexDesc.indexCount * vertexpacking::GetIndexSize(indexType);
+			const LodDescription& lodDesc = submeshIt->lodDesc;
+			assert(lodDesc.lodsCount > 0 && "Trying to draw submesh without LOD 0");
+
+			// Add packed vertices of this submesh to the end of the global mesh buffer. Indices stay local,
+			// the shader finds the submesh vertices by their byte offset
+			std::vector<byte> packedVertices(vertexSize);
+			vertexpacking::PackVertices(submeshIt->vertexDesc.vertexPtr, submeshIt->vertexDesc.vertexCount, vertexEncoding, packedVertices.data());
+
+			_meshDeviceBuffer.vertexBuffer->UploadData(_meshDeviceBuffer.currentVertexOffset, packedVertices.data(), vertexSize);
+
+			// Meshlets are uploaded before indices, so they're in the batch of the index buffer ticket
+			const MeshletDescription& meshletDesc = submeshIt->meshletDesc;
+			if (meshletDesc.meshletsCount > 0)
+			{
+				// Offsets are adjusted for global buffers, vertices are local as indices are
+				std::vector<Meshlet> adjustedMeshlets(meshletDesc.meshletsPtr, meshletDesc.meshletsPtr + meshletDesc.meshletsCount);
+				for (Meshlet& meshlet : adjustedMeshlets)
 				{
-					const size_t vertexSize = submeshIt->vertexDesc.vertexCount * sizeof(Vertex);
-					const size_t indexSize = submeshIt->vertexDesc.indexCount   * sizeof(u32);
-					const size_t materialSize = submeshIt->materialDesc.materialsCount * sizeof(MaterialTexturesDesc);
-					const size_t translationSize = sizeof(TransformComponent);
+					meshlet.vertexOffset += _meshDeviceBuffer.currentMeshletVertexOffset;
+					meshlet.triangleOffset += _meshDeviceBuffer.currentMeshletTriangleOffset;
+				}
 
-					// Add vertex buffer of this submesh to the end of the global mesh buffer
-					_meshDeviceBuffer.vertexBuffer->UploadData(_meshDeviceBuffer.currentVertexOffset * sizeof(Vertex),
-						submeshIt->vertexDesc.vertexPtr, vertexSize);
+				_meshDeviceBuffer.meshletBuffer->UploadData(_meshDeviceBuffer.currentMeshletOffset * sizeof(Meshlet),
+					adjustedMeshlets.data(), adjustedMeshlets.size() * sizeof(Meshlet));
+				_meshDeviceBuffer.meshletVertexBuffer->UploadData(_meshDeviceBuffer.currentMeshletVertexOffset * sizeof(u32),
+					meshletDesc.verticesPtr, meshletDesc.verticesCount * sizeof(u32));
+				_meshDeviceBuffer.meshletTriangleBuffer->UploadData(_meshDeviceBuffer.currentMeshletTriangleOffset,
+					meshletDesc.trianglesPtr, meshletDesc.trianglesBytesCount);
+			}
 
-					const u32 vertexOffset = _meshDeviceBuffer.currentVertexOffset;
-					// Adjust indices for global buffer
-					std::vector<u32> adjustedIndices(submeshIt->vertexDesc.indexCount);
-					for (size_t i = 0; i < submeshIt->vertexDesc.indexCount; ++i)
-						adjustedIndices[i] = submeshIt->vertexDesc.indicesPtr[i] + vertexOffset;
+			// u16 and u32 indices live in their own buffers and are drawn by separate batches
+			const bool isShortIndices = indexType == IndexType::INDEX_TYPE_U16;
+			Buffer* indexBuffer = isShortIndices ? _meshDeviceBuffer.index16Buffer.get() : _meshDeviceBuffer.indexBuffer.get();
+			size_t& currentIndexOffset = isShortIndices ? _meshDeviceBuffer.currentIndex16Offset : _meshDeviceBuffer.currentIndexOffset;
 
-					_meshDeviceBuffer.indexBuffer->UploadData(_meshDeviceBuffer.currentIndexOffset * sizeof(u32),
-						adjustedIndices.data(), indexSize);
+			if (isShortIndices)
+			{
+				std::vector<byte> packedIndices(indexSize);
+				vertexpacking::PackIndices(submeshIt->vertexDesc.indicesPtr, submeshIt->vertexDesc.indexCount, indexType, packedIndices.data());
+				indexBuffer->UploadData(currentIndexOffset * sizeof(u16), packedIndices.data(), indexSize);
+			}
+			else
+				indexBuffer->UploadData(currentIndexOffset * sizeof(u32), submeshIt->vertexDesc.indicesPtr, indexSize);
 
 
-					// Update common data buffer, it contains all the transformations, materials DATA
-					CommonIndirectData commonData{};
+			// Update common data buffer, it contains all the transformations, materials DATA
+			CommonIndirectData commonData{};
 
-					// Push all common mesh data into single buffer: material index, transformation index and their data
-					const TransformComponent* transComp = entity.GetComponent<TransformComponent>();
-					commonData.transformDesc = transComp ? *transComp : TransformComponent{};
+			// Push all common mesh data into single buffer: material index, transformation index and their data
+			commonData.materialsDesc = submeshIt->materialDesc.materialTexturesPtr
+				? *submeshIt->materialDesc.materialTexturesPtr : MaterialTexturesDesc{};
 
-					commonData.materialsDesc = submeshIt->materialDesc.materialTexturesPtr
-						? *submeshIt->materialDesc.materialTexturesPtr : MaterialTexturesDesc{};
 
+			commonData.alphaCutoff = submeshIt->alphaMode.alphaCutoff;
+			commonData.firstMeshlet = _meshDeviceBuffer.currentMeshletOffset;
+			commonData.meshletCount = meshletDesc.meshletsCount;
+			commonData.positionScale = vertexEncoding.positionScale;
+			commonData.positionOffset = vertexEncoding.positionOffset;
+			commonData.vertexByteOffset = static_cast<u32>(_meshDeviceBuffer.currentVertexOffset);
+			commonData.vertexFormat = vertexpacking::GetFormatFlags(vertexEncoding);
 
-					commonData.alphaCutoff = submeshIt->alphaMode.alphaCutoff;
 
+			PendingIndirectDraw pendingDraw;
+			pendingDraw.drawCommand.firstIndex = currentIndexOffset;
+			pendingDraw.drawCommand.firstInstance = 0; // the first record of the instances, it's known once the draw is stored
+			pendingDraw.drawCommand.instanceCount = static_cast<u32>(instances.size());
+			pendingDraw.drawCommand.indexCount = lodDesc.lodsPtr[0].indexCount; // indices of the other LODs follow LOD 0 ones
+			pendingDraw.drawCommand.vertexOffset = 0; // vertexByteOffset is used instead
+			pendingDraw.alphaType = submeshIt->alphaMode.type;
+			pendingDraw.indexType = indexType;
+			pendingDraw.uploadTicket = indexBuffer->GetLastUploadTicket(); // vertices are in the same batch
+			pendingDraw.meshIndex = meshIndex;
+			pendingDraw.submeshIndex = submeshIndex;
+			pendingDraw.localBounds = MeshBounds{ submeshIt->boundingBox, submeshIt->boundingSphere };
 
-					DrawIndexedIndirectCommand drawCommand;
-					drawCommand.firstIndex = _meshDeviceBuffer.currentIndexOffset;
-					drawCommand.firstInstance = 0;
-					drawCommand.instanceCount = 1;
-					drawCommand.indexCount = submeshIt->vertexDesc.indexCount;
-					drawCommand.vertexOffset = _meshDeviceBuffer.currentVertexOffset;
+			pendingDraw.lodsCount = std::min(lodDesc.lodsCount, LodDescription::MaxLodsCount);
+			std::copy_n(lodDesc.lodsPtr, pendingDraw.lodsCount, pendingDraw.lods.begin());
 
-					switch (submeshIt->alphaMode.type)
-					{
-					case AlphaMode::AlphaType::ALPHA_OPAQUE:
-					{
-						// Store indirect draw command
-						_indirectBuffer.opaqueBuffer->UploadData(_indirectBuffer.currentOpaqueSize * sizeof(DrawIndexedIndirectCommand),
-							&drawCommand, sizeof(DrawIndexedIndirectCommand));
+			for (const SubmeshInstance& instance : instances)
+			{
+				const glm::mat4& model = instance.model;
+				commonData.transformDesc = InstanceTransform{ model };
+				pendingDraw.instancesData.push_back(commonData);
+				pendingDraw.instancesOwners.push_back(instance.owner);
+
+				const BoundingSphere worldSphere = meshbounds::TransformSphere(submeshIt->boundingSphere, model);
+				const BoundingBox worldBox = meshbounds::TransformBox(submeshIt->boundingBox, model);
+
+				InstanceBounds instanceBounds{};
+				instanceBounds.sphereCenter = worldSphere.center;
+				instanceBounds.sphereRadius = worldSphere.radius;
+				instanceBounds.boxMin = worldBox.minPosition;
+				instanceBounds.boxMax = worldBox.maxPosition;
+				pendingDraw.instancesBounds.push_back(instanceBounds);
+			}
 
-						_indirectBuffer.currentOpaqueSize += 1;
+			_pendingDraws.push_back(std::move(pendingDraw));
+			++_meshDrawsCount[meshIndex];
 
-						// update count buffer
-						_indirectBuffer.opaqueBuffer->UploadData(_indirectBuffer.countBufferOffset,
-							&_indirectBuffer.currentOpaqueSize, sizeof(u32));
 
+			uploadedBytes += vertexSize + indexSize + meshletDesc.meshletsCount * sizeof(Meshlet) +
+				meshletDesc.verticesCount * sizeof(u32) + meshletDesc.trianglesBytesCount;
 
-						// Store the data itself
-						_indirectBuffer.commonOpaqueData->UploadData(_indirectBuffer.currentCommonOpaqueDataOffset * sizeof(CommonIndirectData),
-							&commonData, sizeof(CommonIndirectData));
+			_meshDeviceBuffer.currentVertexOffset += vertexSize;
+			currentIndexOffset += submeshIt->vertexDesc.indexCount;
+			_meshDeviceBuffer.currentMeshletOffset += meshletDesc.meshletsCount;
+			_meshDeviceBuffer.currentMeshletVertexOffset += meshletDesc.verticesCount;
+			_meshDeviceBuffer.currentMeshletTriangleOffset += meshletDesc.trianglesBytesCount;
+		}
+	}
+	else
+	{
+		std::cout << "Unable to create mesh buffers, asset manager returned index 0\n";
+	}
 
-						_indirectBuffer.currentCommonOpaqueDataOffset += 1;
+	return uploadedBytes;
+}
 
-						break;
-					}
+// Purpose: prepared models are stored and uploaded closest first until the frame budget is spent.
+// The first one always goes, so the model bigger than the budget isn't stuck
+void SceneRenderer::FinalizeStreamedMeshes(const Camera& camera)
+{
+	AssetManager* assetManager = AssetManager::Get();
+	AssetStreamer& streamer = assetManager->GetStreamer();
+	streamer.SetViewerPosition(camera.GetPosition());
 
-					case AlphaMode::AlphaType::ALPHA_MASK:
-					{
-						_indirectBuffer.maskBuffer->UploadData(_indirectBuffer.currentMaskedSize * sizeof(DrawIndexedIndirectCommand),
-							&drawCommand, sizeof(DrawIndexedIndirectCommand));
+	u64 uploadedBytes = 0;
+	bool hasNewMeshes = false;
+	while (uploadedBytes < _streamingUploadBudgetBytes)
+	{
+		const u64 bytesLimit = uploadedBytes == 0 ? std::numeric_limits<u64>::max() : _streamingUploadBudgetBytes - uploadedBytes;
+		std::optional<StreamedMesh> streamedMesh = streamer.TryTakeNearest(bytesLimit);
+		if (!streamedMesh)
+			break;
+
+		auto entityIt = _streamingEntities.find(streamedMesh->requestID);
+		assert(entityIt != _streamingEntities.end() && "Streamed mesh doesn't have its entity");
+		const Entity entity = entityIt->second;
+		_streamingEntities.erase(entityIt);
+
+		// Failed model is reported by the asset manager, the model of the destroyed entity or the one
+		// whose mesh component was removed meanwhile isn't needed anymore
+		MeshComponent* meshComp = entity.GetComponent<MeshComponent>();
+		if (!streamedMesh->preparedMesh || meshComp == nullptr)
+			continue;
 
-						_indirectBuffer.currentMaskedSize += 1;
+		const MeshStorageBackData backData = assetManager->StorePreparedMesh(*streamedMesh->preparedMesh, &_engineBase.GetImageManager());
 
-						// update count buffer
-						_indirectBuffer.maskBuffer->UploadData(_indirectBuffer.countBufferOffset,
-							&_indirectBuffer.currentMaskedSize, sizeof(u32));
+		meshComp->meshIndex = backData.meshIndex;
+		meshComp->materialIndex = backData.materialIndex;
+		// Data is copied to staging right away, so the policy may drop the CPU geometry now.
+		// Nothing is on the GPU if the upload failed, the asset keeps its CPU copy then
+		const u64 gpuBytes = UploadEntityMeshes(entity, backData.meshIndex);
+		if (gpuBytes > 0)
+			assetManager->OnMeshUploaded(backData.meshIndex, gpuBytes, meshComp->residency);
 
-						// Store the data itself
-						_indirectBuffer.commonMaskedData->UploadData(_indirectBuffer.currentCommonMaskedDataOffset * sizeof(CommonIndirectData),
-							&commonData, sizeof(CommonIndirectData));
+		uploadedBytes += streamedMesh->GetUploadBytes();
+		hasNewMeshes = true;
+	}
 
-						_indirectBuffer.currentCommonMaskedDataOffset += 1;
-						break;
-					}
+	// New textures have to be in the bindless set
+	if (hasNewMeshes)
+		UpdateDescriptors();
+}
 
-					default:
-						std::unreachable();
-					}
 
+void SceneRenderer::RenderIndirectBatch(const IndirectDrawBatch& batch, Pipeline* pipeline, IndexType indexType)
+{
+	if (batch.drawsCount == 0)
+		return;
 
-					_meshDeviceBuffer.currentVertexOffset += submeshIt->vertexDesc.vertexCount;
-					_meshDeviceBuffer.currentIndexOffset  += submeshIt->vertexDesc.indexCount;
-				}
+	FrameManager& frameManager = _engineBase.GetFrameManager();
+
+	IndirectPushConst pushConst{};
+	pushConst.vertexAddress = _meshDeviceBuffer.vertexBuffer->GetBufferAddress();
+	pushConst.commonMeshDataAddress = batch.commonData[frameManager.GetCurrentFrameIndex()]->GetBufferAddress();
+	pushConst.viewDataAddress = _viewDataBuffer->GetBufferAddress();
+
+	PushConsts pushConstants;
+	pushConstants.data = (byte*)&pushConst;
+	pushConstants.size = sizeof(IndirectPushConst);
+
+	RenderIndirectCountCommand command;
+	command.buffer = batch.commandsBuffer.get();
+	command.indexBuffer = indexType == IndexType::INDEX_TYPE_U16 ? _meshDeviceBuffer.index16Buffer.get() : _meshDeviceBuffer.indexBuffer.get();
+	command.indexType = indexType;
+	command.descriptor = _sceneDescriptorSets[frameManager.GetCurrentFrameIndex()].get();
+	command.pipeline = pipeline;
+	command.pushConstants = pushConstants;
+	command.maxDrawCount = batch.drawsCount; // count of different materials basically
+	command.countBufferOffsetBytes = _indirectBuffer.countBufferOffset;
+
+	Renderer::RenderIndirect(command);
+}
+
+IndirectDrawBatch& SceneRenderer::GetIndirectBatch(AlphaMode::AlphaType alphaType, IndexType indexType)
+{
+	const bool isShortIndices = indexType == IndexType::INDEX_TYPE_U16;
+	switch (alphaType)
+	{
+	case AlphaMode::AlphaType::ALPHA_OPAQUE: return isShortIndices ? _indirectBuffer.opaque16Batch : _indirectBuffer.opaqueBatch;
+	case AlphaMode::AlphaType::ALPHA_MASK:   return isShortIndices ? _indirectBuffer.masked16Batch : _indirectBuffer.maskedBatch;
+
+	default:
+		std::unreachable();
+	}
+}
+
+std::array<IndirectDrawBatch*, 4> SceneRenderer::GetIndirectBatches()
+{
+	return { &_indirectBuffer.opaqueBatch, &_indirectBuffer.opaque16Batch, &_indirectBuffer.maskedBatch, &_indirectBuffer.masked16Batch };
+}
+
+IndirectBatchRecords& SceneRenderer::GetBatchRecords(const IndirectDrawBatch& batch)
+{
+	const std::array<IndirectDrawBatch*, 4> batches = GetIndirectBatches();
+	const auto batchIt = std::find(batches.begin(), batches.end(), &batch);
+	assert(batchIt != batches.end() && "Batch doesn't belong to the renderer");
+	return _batchRecords[batchIt - batches.begin()];
+}
+
+// Every GPU copy needs the range, each one gets it with its own frame
+void SceneRenderer::MarkRecordsDirty(IndirectBatchRecords& records, RecordRange range)
+{
+	for (std::vector<RecordRange>& frameRanges : records.dirtyRanges)
+		frameRanges.push_back(range);
+}
+
+void SceneRenderer::WriteRecordTransform(const InstanceRecord& record, const glm::mat4& model)
+{
+	IndirectBatchRecords& records = GetBatchRecords(*record.batch);
+	records.commonData[record.recordIndex].transformDesc = InstanceTransform{ model };
+
+	const BoundingSphere worldSphere = meshbounds::TransformSphere(record.localBounds.boundingSphere, model);
+	const BoundingBox worldBox = meshbounds::TransformBox(record.localBounds.boundingBox, model);
+
+	InstanceBounds& instanceBounds = records.bounds[record.recordIndex];
+	instanceBounds.sphereCenter = worldSphere.center;
+	instanceBounds.sphereRadius = worldSphere.radius;
+	instanceBounds.boxMin = worldBox.minPosition;
+	instanceBounds.boxMax = worldBox.maxPosition;
+
+	MarkRecordsDirty(records, RecordRange{ record.recordIndex, 1 });
+}
+
+// Purpose: records of the entities moved by the last hierarchy update, the rest of the scene isn't touched
+void SceneRenderer::UpdateMovedInstances()
+{
+	if (_scene == nullptr)
+		return;
+
+	SceneStorage& storage = _scene->GetStorage();
+	ComponentPool<RenderInstancesComponent>& instancesPool = storage.GetPool<RenderInstancesComponent>();
+	const ComponentPool<TransformComponent>& transforms = storage.GetPool<TransformComponent>();
+	if (instancesPool.GetSize() == 0)
+		return;
+
+	for (const u32 entityID : _scene->GetTransformHierarchy().GetChangedEntities())
+	{
+		const RenderInstancesComponent* instances = instancesPool.Get(entityID);
+		if (instances == nullptr)
+			continue;
+
+		const glm::mat4& model = transforms.Get(entityID)->model;
+		for (const InstanceRecord& record : instances->records)
+			WriteRecordTransform(record, model);
+	}
+}
+
+// Purpose: dirty ranges of the current frame copy are sorted and merged, every contiguous region is one copy
+void SceneRenderer::UploadDirtyRecords()
+{
+	const u32 frameIndex = _engineBase.GetFrameManager().GetCurrentFrameIndex();
+	const std::array<IndirectDrawBatch*, 4> batches = GetIndirectBatches();
+
+	for (size_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex)
+	{
+		IndirectDrawBatch& batch = *batches[batchIndex];
+		IndirectBatchRecords& records = _batchRecords[batchIndex];
+		std::vector<RecordRange>& ranges = records.dirtyRanges[frameIndex];
+		if (ranges.empty())
+			continue;
+
+		std::sort(ranges.begin(), ranges.end(), [](const RecordRange& a, const RecordRange& b) { return a.first < b.first; });
+
+		auto uploadRange = [&](const RecordRange& range)
+			{
+				batch.commonData[frameIndex]->UploadData(range.first * sizeof(CommonIndirectData),
+					&records.commonData[range.first], range.count * sizeof(CommonIndirectData));
+				batch.boundsData[frameIndex]->UploadData(range.first * sizeof(InstanceBounds),
+					&records.bounds[range.first], range.count * sizeof(InstanceBounds));
+			};
+
+		// Overlapping and adjacent ranges become one
+		RecordRange merged = ranges.front();
+		for (size_t i = 1; i < ranges.size(); ++i)
+		{
+			const u32 mergedEnd = merged.first + merged.count;
+			if (ranges[i].first <= mergedEnd)
+			{
+				merged.count = std::max(mergedEnd, ranges[i].first + ranges[i].count) - merged.first;
+				continue;
 			}
-			else
+
+			uploadRange(merged);
+			merged = ranges[i];
+		}
+
+		uploadRange(merged);
+		ranges.clear();
+	}
+}
+
+void SceneRenderer::SetInstancesMaterial(const Entity& entity, u32 submeshIndex, const MaterialTexturesDesc& material)
+{
+	const RenderInstancesComponent* instances = entity.GetComponent<RenderInstancesComponent>();
+	if (instances == nullptr)
+		return;
+
+	for (const InstanceRecord& record : instances->records)
+	{
+		if (record.submeshIndex != submeshIndex)
+			continue;
+
+		IndirectBatchRecords& records = GetBatchRecords(*record.batch);
+		records.commonData[record.recordIndex].materialsDesc = material;
+		MarkRecordsDirty(records, RecordRange{ record.recordIndex, 1 });
+	}
+}
+
+// Purpose: returns false if the draw isn't stored: its owners are gone or the batch is full
+bool SceneRenderer::StoreIndirectDraw(const PendingIndirectDraw& pendingDraw)
+{
+	IndirectDrawBatch& batch = GetIndirectBatch(pendingDraw.alphaType, pendingDraw.indexType);
+	IndirectBatchRecords& records = GetBatchRecords(batch);
+
+	// Owners destroyed while the geometry was uploading aren't drawn, the draw of none isn't stored at all
+	const u32 ownersCount = static_cast<u32>(std::ranges::count_if(pendingDraw.instancesOwners, [](const Entity& owner) { return owner.IsAlive(); }));
+	if (ownersCount == 0)
+		return false;
+
+	// The next command would overwrite the count, the records would go past the common data buffer
+	if (records.freeDraws.empty() && batch.drawsCount >= IndirectDrawBatch::MaxDrawsCount)
+	{
+		std::cout << "Indirect batch is full, draw of submesh " << pendingDraw.submeshIndex << " is skipped\n";
+		return false;
+	}
+
+	const u32 instancesCount = static_cast<u32>(pendingDraw.instancesData.size());
+	const std::optional<u32> firstRecord = AllocateRecords(batch, records, instancesCount);
+	if (!firstRecord)
+	{
+		std::cout << "Indirect batch has no records left for " << instancesCount
+			<< " instances, draw of submesh " << pendingDraw.submeshIndex << " is skipped\n";
+		return false;
+	}
+
+	u32 drawIndex = static_cast<u32>(batch.drawsCount);
+	if (!records.freeDraws.empty())
+	{
+		drawIndex = records.freeDraws.back();
+		records.freeDraws.pop_back();
+	}
+	else
+	{
+		batch.drawsCount += 1;
+		records.draws.emplace_back();
+	}
+
+	records.draws[drawIndex] = DrawRecords{ RecordRange{ *firstRecord, instancesCount }, ownersCount, pendingDraw.meshIndex };
+
+	// Instance index of the shader starts from the first record of the draw
+	DrawIndexedIndirectCommand drawCommand = pendingDraw.drawCommand;
+	drawCommand.firstInstance = *firstRecord;
+
+	// Single level draw never changes its command
+	if (pendingDraw.lodsCount > 1)
+	{
+		DrawLodState lodState{};
+		lodState.batch = &batch;
+		lodState.drawIndex = drawIndex;
+		lodState.drawCommand = drawCommand;
+		lodState.lods = pendingDraw.lods;
+		lodState.lodsCount = pendingDraw.lodsCount;
+		_lodDraws.push_back(std::move(lodState));
+	}
+
+	// Store indirect draw command
+	batch.commandsBuffer->UploadData(drawIndex * sizeof(DrawIndexedIndirectCommand),
+		&drawCommand, sizeof(DrawIndexedIndirectCommand));
+
+	// Store the data itself, records of all the instances go to every frame copy as one range
+	std::copy(pendingDraw.instancesData.begin(), pendingDraw.instancesData.end(), records.commonData.begin() + *firstRecord);
+	std::copy(pendingDraw.instancesBounds.begin(), pendingDraw.instancesBounds.end(), records.bounds.begin() + *firstRecord);
+	MarkRecordsDirty(records, RecordRange{ *firstRecord, instancesCount });
+
+	// Owners track their records. The transform may have moved while the geometry was uploading, the dirty one
+	// is reported by the next hierarchy update anyway
+	for (u32 i = 0; i < instancesCount; ++i)
+	{
+		const u32 recordIndex = *firstRecord + i;
+		const Entity& owner = pendingDraw.instancesOwners[i];
+		if (!owner.IsAlive())
+		{
+			ClearRecord(records, recordIndex);
+			continue;
+		}
+
+		records.recordDraws[recordIndex] = drawIndex;
+
+		RenderInstancesComponent* instances = owner.GetComponent<RenderInstancesComponent>();
+		if (instances == nullptr)
+			instances = &owner.AddComponent<RenderInstancesComponent>();
+
+		const InstanceRecord record{ &batch, recordIndex, pendingDraw.submeshIndex, pendingDraw.localBounds };
+		instances->records.push_back(record);
+
+		const TransformComponent* transform = owner.GetComponent<TransformComponent>();
+		if (transform && !transform->IsDirty())
+			WriteRecordTransform(record, transform->model);
+	}
+
+	// update count buffer
+	const u32 drawsCount = static_cast<u32>(batch.drawsCount);
+	batch.commandsBuffer->UploadData(_indirectBuffer.countBufferOffset, &drawsCount, sizeof(u32));
+
+	return true;
+}
+
+// Purpose: the first free range which is large enough is taken, the records are appended to the batch otherwise
+std::optional<u32> SceneRenderer::AllocateRecords(IndirectDrawBatch& batch, IndirectBatchRecords& records, u32 count)
+{
+	for (auto rangeIt = records.freeRecords.begin(); rangeIt != records.freeRecords.end(); ++rangeIt)
+	{
+		if (rangeIt->count < count)
+			continue;
+
+		const u32 firstRecord = rangeIt->first;
+		rangeIt->first += count;
+		rangeIt->count -= count;
+		if (rangeIt->count == 0)
+			records.freeRecords.erase(rangeIt);
+
+		return firstRecord;
+	}
+
+	if (batch.instancesCount + count > IndirectDrawBatch::MaxInstancesCount)
+		return std::nullopt;
+
+	const u32 firstRecord = static_cast<u32>(batch.instancesCount);
+	batch.instancesCount += count;
+	records.commonData.resize(batch.instancesCount);
+	records.bounds.resize(batch.instancesCount);
+	records.recordDraws.resize(batch.instancesCount, IndirectBatchRecords::NoDraw);
+
+	return firstRecord;
+}
+
+void SceneRenderer::FreeRecords(IndirectBatchRecords& records, RecordRange range)
+{
+	std::vector<RecordRange>& freeRecords = records.freeRecords;
+	auto rangeIt = std::lower_bound(freeRecords.begin(), freeRecords.end(), range.first,
+		[](const RecordRange& freeRange, u32 first) { return freeRange.first < first; });
+	rangeIt = freeRecords.insert(rangeIt, range);
+
+	const auto nextIt = std::next(rangeIt);
+	if (nextIt != freeRecords.end() && rangeIt->first + rangeIt->count == nextIt->first)
+	{
+		rangeIt->count += nextIt->count;
+		freeRecords.erase(nextIt);
+	}
+
+	if (rangeIt != freeRecords.begin())
+	{
+		const auto previousIt = std::prev(rangeIt);
+		if (previousIt->first + previousIt->count == rangeIt->first)
+		{
+			previousIt->count += rangeIt->count;
+			freeRecords.erase(rangeIt);
+		}
+	}
+}
+
+// Zero matrix takes every vertex of the instance to the clip space origin, its triangles are degenerate and nothing is rasterized
+void SceneRenderer::ClearRecord(IndirectBatchRecords& records, u32 recordIndex)
+{
+	records.commonData[recordIndex] = CommonIndirectData{};
+	records.commonData[recordIndex].transformDesc.model = glm::mat4(0.0f);
+	records.bounds[recordIndex] = InstanceBounds{};
+	records.recordDraws[recordIndex] = IndirectBatchRecords::NoDraw;
+
+	MarkRecordsDirty(records, RecordRange{ recordIndex, 1 });
+}
+
+// Purpose: records of the entity are cleared, the draw without any owner left gets no instances
+// and its command slot and records are reused by the next stored draws
+void SceneRenderer::ReleaseEntityInstances(const Entity& entity)
+{
+	const RenderInstancesComponent* instances = entity.GetComponent<RenderInstancesComponent>();
+	if (instances == nullptr)
+		return;
+
+	for (const InstanceRecord& record : instances->records)
+	{
+		IndirectDrawBatch& batch = *record.batch;
+		IndirectBatchRecords& records = GetBatchRecords(batch);
+		const u32 drawIndex = records.recordDraws[record.recordIndex];
+		assert(drawIndex != IndirectBatchRecords::NoDraw && "Record of the entity is released already");
+		ClearRecord(records, record.recordIndex);
+
+		DrawRecords& draw = records.draws[drawIndex];
+		if (--draw.ownersCount > 0)
+			continue;
+
+		// LOD selection would write the instances back
+		std::erase_if(_lodDraws, [&](const DrawLodState& lodState) { return lodState.batch == &batch && lodState.drawIndex == drawIndex; });
+
+		const u32 noInstances = 0;
+		batch.commandsBuffer->UploadData(drawIndex * sizeof(DrawIndexedIndirectCommand) + offsetof(DrawIndexedIndirectCommand, instanceCount),
+			&noInstances, sizeof(u32));
+
+		FreeRecords(records, draw.records);
+		records.freeDraws.push_back(drawIndex);
+		ReleaseMeshDraw(draw.meshIndex);
+		draw = DrawRecords{};
+	}
+}
+
+// Purpose: the mesh asset nothing draws anymore is removed, its storage ranges are reused by the next loads.
+// Its geometry stays in the global mesh buffers, they're only appended to
+void SceneRenderer::ReleaseMeshDraw(u32 meshIndex)
+{
+	auto countIt = _meshDrawsCount.find(meshIndex);
+	assert(countIt != _meshDrawsCount.end() && countIt->second > 0 && "Mesh asset has no draws to release");
+
+	if (--countIt->second > 0)
+		return;
+
+	_meshDrawsCount.erase(countIt);
+	AssetManager::Get()->RemoveMesh(meshIndex);
+}
+
+// Purpose: draws become visible only when their geometry was acquired by the graphics queue.
+// Tickets are increasing, so stop at the first one which isn't resident
+void SceneRenderer::PublishResidentDraws()
+{
+	const BufferManager& bufferManager = _engineBase.GetBufferManager();
+
+	while (!_pendingDraws.empty() && bufferManager.IsUploadResident(_pendingDraws.front().uploadTicket))
+	{
+		if (!StoreIndirectDraw(_pendingDraws.front()))
+			ReleaseMeshDraw(_pendingDraws.front().meshIndex);
+		_pendingDraws.pop_front();
+	}
+}
+
+// Purpose: LOD error is projected to pixels at the nearest point of the bounding sphere,
+// the coarsest level which stays under the threshold is drawn. Instances of the draw share the level of the nearest one
+void SceneRenderer::SelectDrawLods(const Camera& camera)
+{
+	if (_lodDraws.empty())
+		return;
+
+	const float viewportHeight = static_cast<float>(_currentColorAttachment->GetSpecification().extent.y);
+	const float projectionScale = std::abs(camera.GetProjectionMatrix()[1][1]) * viewportHeight * 0.5f;
+	const float nearPlane = camera.GetNearPlane();
+	const glm::vec3 cameraPosition = camera.GetPosition();
+
+	for (DrawLodState& lodState : _lodDraws)
+	{
+		// Instances might move, their current records are used. LOD errors are in the mesh space, the largest axis scale takes them to the world
+		const IndirectBatchRecords& records = GetBatchRecords(*lodState.batch);
+		const u32 firstRecord = lodState.drawCommand.firstInstance;
+		float sphereDistance = std::numeric_limits<float>::max();
+		float worldScale = 0.0f;
+		for (u32 record = firstRecord; record < firstRecord + lodState.drawCommand.instanceCount; ++record)
+		{
+			// Instance of the destroyed entity
+			if (records.recordDraws[record] == IndirectBatchRecords::NoDraw)
+				continue;
+
+			const InstanceBounds& instanceBounds = records.bounds[record];
+			sphereDistance = std::min(sphereDistance, glm::length(instanceBounds.sphereCenter - cameraPosition) - instanceBounds.sphereRadius);
+
+			const glm::mat4& model = records.commonData[record].transformDesc.model;
+			worldScale = std::max({ worldScale, glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+		}
+
+		const float pixelsPerUnit = projectionScale / std::max(sphereDistance, nearPlane);
+
+		u32 selectedLod = 0;
+		for (u32 lod = lodState.lodsCount - 1; lod > 0; --lod)
+		{
+			if (lodState.lods[lod].error * worldScale * pixelsPerUnit <= _lodErrorThresholdPixels)
 			{
-				std::cout << "Unable to create mesh buffers, asset manager returned index 0\n";
+				selectedLod = lod;
+				break;
 			}
 		}
 
-		// TO REPLACE!!!!!!!!!!!!
-		_pointLightsBuffer->UploadData(0, _pointLights.data(), sizeof(PointLight)* _pointLights.size());
-		UpdateDescriptors();
+		if (selectedLod == lodState.currentLod)
+			continue;
 
-		_entityCreateQueue.pop();
+		DrawIndexedIndirectCommand drawCommand = lodState.drawCommand;
+		drawCommand.firstIndex += lodState.lods[selectedLod].firstIndex;
+		drawCommand.indexCount = lodState.lods[selectedLod].indexCount;
+
+		lodState.batch->commandsBuffer->UploadData(lodState.drawIndex * sizeof(DrawIndexedIndirectCommand),
+			&drawCommand, sizeof(DrawIndexedIndirectCommand));
+		lodState.currentLod = selectedLod;
 	}
 }
 
@@ -717,6 +1338,10 @@ void SceneRenderer::SubmitEntityToDraw(const Entity& entity)
 	const ImageManager& imageManager = _engineBase.GetImageManager();
 
 
-	_entityCreateQueue.push(&entity);
+	// Hierarchy of this scene reports the moved instances
+	assert((_scene == nullptr || _scene == entity.GetScene()) && "Entities of one renderer have to be in one scene");
+	_scene = entity.GetScene();
+
+	_entityCreateQueue.push(entity);
 
 }
@@ -1,23 +1,51 @@
 #include "../../headers/scene/scene_storage.h"
 #include "../../headers/scene/entity.h"
 
-const Entity& SceneStorage::CreateEntityInRegistry(SceneBase* scene)
-{
-	auto it = _entityRegistry.emplace(Entity{ _currentAvailableID++, scene }, ComponentList{});
+#include <limits>
 
-	// TO DO
-	// _entityMeshPtrs.emplace(_currentAvailableID, AssetManager::GetData());
+SceneStorage::SceneStorage() = default;
+SceneStorage::~SceneStorage() = default;
 
+Entity SceneStorage::CreateEntityInRegistry(SceneBase* scene)
+{
+	u32 slot = 0;
+	if (!_freeSlots.empty())
+	{
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<u32>(_generations.size());
+		_generations.push_back(0);
+	}
 
-	return it.first->first;
+	++_aliveCount;
+	return Entity{ slot, _generations[slot], scene };
 }
 
-ComponentList* SceneStorage::GetComponentListByEntity(const Entity& entity)
+void SceneStorage::DestroyEntity(const Entity& entity)
 {
-	auto it = _entityRegistry.find(entity);
+	if (!IsAlive(entity.GetID(), entity.GetGeneration()))
+		return;
 
-	if (it == _entityRegistry.end())
-		return nullptr;
+	for (const auto& pool : _pools)
+	{
+		if (pool)
+			pool->Remove(entity.GetID());
+	}
 
-	return &it->second;
-}
\ No newline at end of file
+	// Slot whose generation is exhausted is retired, so the old handles never match again
+	const u32 slot = entity.GetID();
+	++_generations[slot];
+	if (_generations[slot] != std::numeric_limits<u32>::max())
+		_freeSlots.push_back(slot);
+
+	--_aliveCount;
+}
+
+Entity SceneStorage::GetEntity(u32 entityID, SceneBase* scene) const
+{
+	assert(entityID > 0 && entityID < _generations.size() && "Trying to get entity which isn't in the storage");
+	return Entity{ entityID, _generations[entityID], scene };
+}
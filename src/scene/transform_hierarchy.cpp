@@ -0,0 +1,180 @@
+#include "../../headers/scene/transform_hierarchy.h"
+#include "../../headers/scene/scene_storage.h"
+#include "../../headers/util/helpers.h"
+
+void TransformHierarchy::SetParent(SceneStorage& storage, u32 childID, u32 parentID)
+{
+	ComponentPool<TransformComponent>& transforms = storage.GetPool<TransformComponent>();
+	TransformComponent* child = transforms.Get(childID);
+	assert(child && "Trying to set parent of entity without transform");
+
+	// Parent mustn't be in the subtree of the child, the order would have no place for it
+	for (u32 ancestor = parentID; ancestor != TransformComponent::NoParent;)
+	{
+		if (ancestor == childID)
+		{
+			std::cout << "Transform can't be parented to its own subtree, entity: " << childID << '\n';
+			return;
+		}
+
+		const TransformComponent* ancestorTransform = transforms.Get(ancestor);
+		ancestor = ancestorTransform ? ancestorTransform->_parent : TransformComponent::NoParent;
+	}
+
+	child->_parent = parentID;
+	child->_parentGeneration = storage.GetGeneration(parentID);
+	child->_isDirty = true;
+	_isStructureChanged = true;
+}
+
+// Purpose: counting sort of the dense indices by depth. Depths are found by walking up to the first known one,
+// so every transform is visited once. Transform whose parent has no transform is a root, the one whose parent
+// was destroyed becomes a root for good
+void TransformHierarchy::RebuildOrder(const SceneStorage& storage, ComponentPool<TransformComponent>& transforms)
+{
+	constexpr u32 UnknownDepth{ std::numeric_limits<u32>::max() };
+	constexpr u32 NoIndex{ ComponentPool<TransformComponent>::NoIndex };
+
+	const std::span<TransformComponent> components = transforms.GetComponents();
+	const u32 count = static_cast<u32>(components.size());
+
+	_parentIndices.assign(count, NoIndex);
+	for (u32 i = 0; i < count; ++i)
+	{
+		TransformComponent& transform = components[i];
+		if (transform._parent == TransformComponent::NoParent)
+			continue;
+
+		if (!storage.IsAlive(transform._parent, transform._parentGeneration))
+		{
+			transform._parent = TransformComponent::NoParent;
+			transform._isDirty = true;
+			continue;
+		}
+
+		_parentIndices[i] = transforms.GetDenseIndex(transform._parent);
+	}
+
+	std::vector<u32> depths(count, UnknownDepth);
+	std::vector<u32> chain; // from the transform up to the first one with the known depth
+	u32 maxDepth = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		u32 depth = 0;
+		for (u32 current = i; current != NoIndex; current = _parentIndices[current])
+		{
+			if (depths[current] != UnknownDepth)
+			{
+				depth = depths[current] + 1;
+				break;
+			}
+
+			chain.push_back(current);
+		}
+
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			depths[*it] = depth++;
+
+		chain.clear();
+		maxDepth = std::max(maxDepth, depths[i]);
+	}
+
+	const u32 levelsCount = count > 0 ? maxDepth + 1 : 0;
+	_levelOffsets.assign(levelsCount + 1, 0);
+	for (u32 i = 0; i < count; ++i)
+		++_levelOffsets[depths[i] + 1];
+
+	for (u32 level = 0; level < levelsCount; ++level)
+		_levelOffsets[level + 1] += _levelOffsets[level];
+
+	_order.resize(count);
+	std::vector<u32> levelFill(_levelOffsets.begin(), _levelOffsets.end() - 1);
+	for (u32 i = 0; i < count; ++i)
+	{
+		_order[levelFill[depths[i]]++] = i;
+
+		// Lost parent changes the world matrix as well
+		if (components[i]._depth != depths[i])
+		{
+			components[i]._depth = depths[i];
+			components[i]._isDirty = true;
+		}
+	}
+
+	_transformsVersion = transforms.GetVersion();
+	_isStructureChanged = false;
+}
+
+void TransformHierarchy::UpdateLevel(ComponentPool<TransformComponent>& transforms, u32 level)
+{
+	constexpr u32 NoIndex{ ComponentPool<TransformComponent>::NoIndex };
+
+	const std::span<TransformComponent> components = transforms.GetComponents();
+	const std::span<const u32> entities = transforms.GetEntities();
+	const u32 levelBegin = _levelOffsets[level];
+	const u32 levelEnd = _levelOffsets[level + 1];
+
+	// Every transform writes only itself and reads its parent from the previous level
+	auto updateRange = [&](u32 first, u32 last, std::vector<u32>& changedEntities)
+		{
+			for (u32 i = first; i < last; ++i)
+			{
+				const u32 index = _order[i];
+				TransformComponent& transform = components[index];
+				const TransformComponent* parent = _parentIndices[index] != NoIndex ? &components[_parentIndices[index]] : nullptr;
+
+				const bool isParentChanged = parent && parent->_changedUpdate == _updateIndex;
+				if (!transform._isDirty && !isParentChanged)
+					continue;
+
+				const glm::mat4 local = transform.GetLocalMatrix();
+				transform.model = parent ? parent->model * local : local;
+				transform._changedUpdate = _updateIndex;
+				transform._isDirty = false;
+				changedEntities.push_back(entities[index]);
+			}
+		};
+
+	const u32 count = levelEnd - levelBegin;
+	if (count < ParallelLevelSize)
+	{
+		updateRange(levelBegin, levelEnd, _changedEntities);
+		return;
+	}
+
+	const u32 chunksCount = (count + ChunkSize - 1) / ChunkSize;
+	if (_chunkChangedEntities.size() < chunksCount)
+		_chunkChangedEntities.resize(chunksCount);
+
+	helpers::ParallelFor(chunksCount, [&](u32 chunk)
+		{
+			const u32 first = levelBegin + chunk * ChunkSize;
+			_chunkChangedEntities[chunk].clear();
+			updateRange(first, std::min(first + ChunkSize, levelEnd), _chunkChangedEntities[chunk]);
+		});
+
+	for (u32 chunk = 0; chunk < chunksCount; ++chunk)
+		_changedEntities.insert(_changedEntities.end(), _chunkChangedEntities[chunk].begin(), _chunkChangedEntities[chunk].end());
+}
+
+void TransformHierarchy::Update(SceneStorage& storage)
+{
+	ComponentPool<TransformComponent>& transforms = storage.GetPool<TransformComponent>();
+	if (_isStructureChanged || _transformsVersion != transforms.GetVersion())
+		RebuildOrder(storage, transforms);
+
+	++_updateIndex;
+	_changedEntities.clear();
+
+	// Levels above the shallowest dirty transform don't change
+	const u32 levelsCount = _levelOffsets.empty() ? 0 : static_cast<u32>(_levelOffsets.size() - 1);
+	u32 firstLevel = levelsCount;
+	for (const TransformComponent& transform : transforms.GetComponents())
+	{
+		if (transform._isDirty)
+			firstLevel = std::min(firstLevel, transform._depth);
+	}
+
+	for (u32 level = firstLevel; level < levelsCount; ++level)
+		UpdateLevel(transforms, level);
+}
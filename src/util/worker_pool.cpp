@@ -0,0 +1,75 @@
+#include "../../headers/util/worker_pool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool()
+{
+	// Calling thread is the one more worker of its loops
+	const u32 workersCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	_workers.reserve(workersCount);
+	for (u32 i = 0; i < workersCount; ++i)
+		_workers.emplace_back([this]() { WorkerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard lock(_mutex);
+		_isStopping = true;
+	}
+
+	_jobAdded.notify_all();
+	_workers.clear();
+}
+
+WorkerPool& WorkerPool::Get()
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+void WorkerPool::Execute(Job& job)
+{
+	for (u32 i = job.nextIndex.fetch_add(1, std::memory_order_relaxed); i < job.count; i = job.nextIndex.fetch_add(1, std::memory_order_relaxed))
+		job.invoke(job.func, i);
+}
+
+void WorkerPool::Run(Job& job)
+{
+	{
+		std::lock_guard lock(_mutex);
+		_jobs.push_back(&job);
+	}
+
+	_jobAdded.notify_all();
+
+	Execute(job);
+
+	// Every index is taken now, no new worker may join once the job is out of the queue
+	std::unique_lock lock(_mutex);
+	std::erase(_jobs, &job);
+	_jobLeft.wait(lock, [&job]() { return job.activeWorkers == 0; });
+}
+
+void WorkerPool::WorkerLoop()
+{
+	std::unique_lock lock(_mutex);
+	while (true)
+	{
+		_jobAdded.wait(lock, [this]() { return _isStopping || !_jobs.empty(); });
+		if (_isStopping)
+			return;
+
+		Job* job = _jobs.front();
+		++job->activeWorkers;
+		lock.unlock();
+
+		Execute(*job);
+
+		lock.lock();
+		std::erase(_jobs, job); // exhausted, the others shouldn't pick it
+		if (--job->activeWorkers == 0)
+			_jobLeft.notify_all();
+	}
+}
@@ -0,0 +1,313 @@
+#include "../../headers/asset/model_importer.h"
+#include "../../headers/asset/mesh_optimizer.h"
+#include "../../headers/asset/mesh_cache.h"
+#include "../../headers/asset/vertex_packing.h"
+#include "../../headers/asset/texture_preparation.h"
+#include "../../headers/util/helpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <span>
+
+// Headless batch cooker: every glTF under the models directory goes through the same import, optimization(meshlets, LODs)
+// and texture compression stages as in the engine, and the cooked files are written where the engine looks for them.
+// Up to date outputs are skipped: meshes by the source stamp of the mesh cache, textures by the content hash of the image.
+// Usage: lux-cook [models directory] [--force]
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	enum class Stage : u8
+	{
+		STAGE_IMPORT,
+		STAGE_OPTIMIZE,
+		STAGE_MESH_WRITE,
+
+		STAGE_COUNT
+	};
+
+	// Purpose: time and sizes of one stage over all the models, texture stages are reported by the shared preparation
+	using StageReport = TextureStageReport;
+
+	struct CookSettings
+	{
+		fs::path modelsDirectory;
+		fs::path texturesDirectory;
+		bool force{ false }; // cook everything again even if it's up to date
+	};
+
+	// Decoded images of all the models don't fit in memory, textures are cooked by parts
+	constexpr u32 TexturesPerBatch{ 64 };
+
+	class Cooker
+	{
+	private:
+		CookSettings _settings;
+		MeshCache _meshCache;
+		MeshOptimizer _meshOptimizer;
+		VertexPackingSettings _vertexPackingSettings; // the engine defaults, cooked meshes must match them
+		TextureCooker _textureCooker;
+
+		std::array<StageReport, static_cast<size_t>(Stage::STAGE_COUNT)> _reports{};
+		TexturePreparationReport _textureReports{};
+		u32 _cookedMeshes{ 0 };
+		u32 _upToDateMeshes{ 0 };
+		u32 _failedMeshes{ 0 };
+		u32 _cookedTextures{ 0 };
+		u32 _upToDateTextures{ 0 };
+		u32 _failedTextures{ 0 };
+
+		StageReport& GetReport(Stage stage) { return _reports[static_cast<size_t>(stage)]; }
+		static double GetMilliseconds(Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+		static u64 GetSourceBytes(const fs::path& sourcePath);
+
+		std::vector<MeshMaterial> CookMesh(const fs::path& sourcePath);
+		void CookTextures(std::span<const TexturesData* const> textures);
+	public:
+		explicit Cooker(const CookSettings& settings);
+
+		void Run(const std::vector<fs::path>& sources);
+		void PrintReport() const;
+		bool HasFailures() const { return _failedMeshes > 0 || _failedTextures > 0; }
+	};
+
+	Cooker::Cooker(const CookSettings& settings) : _settings{ settings }
+	{
+		_textureCooker.SetCookedDirectory(settings.texturesDirectory);
+	}
+
+	// Purpose: the .gltf or .glb file and the buffers next to it
+	u64 Cooker::GetSourceBytes(const fs::path& sourcePath)
+	{
+		std::error_code error;
+		u64 result = fs::file_size(sourcePath, error);
+		for (const auto& entry : fs::directory_iterator(sourcePath.parent_path(), error))
+		{
+			if (entry.is_regular_file() && entry.path().extension() == ".bin")
+				result += entry.file_size(error);
+		}
+
+		return result;
+	}
+
+	// Purpose: import, optimize and write the mesh unless its cooked file is up to date.
+	// Returns the materials with the absolute texture paths
+	std::vector<MeshMaterial> Cooker::CookMesh(const fs::path& sourcePath)
+	{
+		std::vector<MeshMaterial> materials;
+
+		std::optional<CookedMesh> cookedMesh = _settings.force ? std::nullopt : _meshCache.TryLoad(sourcePath);
+		if (cookedMesh)
+		{
+			materials = std::move(cookedMesh->materials);
+			++_upToDateMeshes;
+		}
+		else
+		{
+			auto stageStart = Clock::now();
+			ModelImporter importer;
+			LoadedGLTF loadedGLTF = importer.LoadGltf(sourcePath);
+			if (!loadedGLTF.isLoaded)
+			{
+				std::cout << "Failed to import " << sourcePath << '\n';
+				++_failedMeshes;
+				return materials;
+			}
+
+			StageReport& importReport = GetReport(Stage::STAGE_IMPORT);
+			importReport.milliseconds += GetMilliseconds(stageStart);
+			importReport.inputBytes += GetSourceBytes(sourcePath);
+			importReport.itemsCount += 1;
+
+			stageStart = Clock::now();
+			_meshOptimizer.Optimize(loadedGLTF);
+			vertexpacking::SelectEncodings(loadedGLTF, _vertexPackingSettings);
+
+			StageReport& optimizeReport = GetReport(Stage::STAGE_OPTIMIZE);
+			optimizeReport.milliseconds += GetMilliseconds(stageStart);
+			optimizeReport.itemsCount += static_cast<u32>(loadedGLTF.meshes.size());
+
+			stageStart = Clock::now();
+			if (!_meshCache.Write(sourcePath, loadedGLTF))
+			{
+				++_failedMeshes;
+				return materials;
+			}
+
+			std::error_code error;
+			StageReport& writeReport = GetReport(Stage::STAGE_MESH_WRITE);
+			writeReport.milliseconds += GetMilliseconds(stageStart);
+			writeReport.outputBytes += fs::file_size(MeshCache::GetCookedPath(sourcePath), error);
+			writeReport.itemsCount += 1;
+
+			materials = std::move(loadedGLTF.materials);
+			++_cookedMeshes;
+		}
+
+		// Paths are relative to the model folder as in glTF
+		for (auto& material : materials)
+		{
+			for (auto& texture : material.materialTextures)
+			{
+				if (!texture.path.empty())
+					texture.path = sourcePath.parent_path() / texture.path;
+			}
+		}
+
+		return materials;
+	}
+
+	// Purpose: the same preparation as the engine does for the loaded model, the cooked files are what it looks for
+	void Cooker::CookTextures(std::span<const TexturesData* const> textures)
+	{
+		const PreparedTextures prepared = texturepreparation::Prepare(textures, _textureCooker, nullptr, _settings.force, &_textureReports);
+
+		for (const PreparedTexture& source : prepared.sources)
+		{
+			// Same bytes under another name share the cooked file
+			if (source.cooked || source.sameContentSource != PreparedTexture::NoSource)
+				++_upToDateTextures;
+			else if (source.isWritten)
+				++_cookedTextures;
+			else
+			{
+				// Load and decode failures are reported by the preparation
+				if (source.HasMips())
+					std::cout << "Failed to cook image: " << source.path << '\n';
+				++_failedTextures;
+			}
+		}
+	}
+
+	void Cooker::Run(const std::vector<fs::path>& sources)
+	{
+		// Materials live until their textures are cooked, the texture references point into them
+		std::vector<std::vector<MeshMaterial>> modelsMaterials;
+		modelsMaterials.reserve(sources.size());
+
+		// Every stage of the mesh is parallel inside, models go one by one
+		for (const fs::path& sourcePath : sources)
+		{
+			std::cout << "Cooking " << sourcePath << '\n';
+			modelsMaterials.push_back(CookMesh(sourcePath));
+		}
+
+		// Same image referenced by several materials or models is cooked once
+		std::vector<const TexturesData*> textures;
+		std::unordered_set<std::string> knownKeys;
+		for (const auto& materials : modelsMaterials)
+		{
+			for (const auto& material : materials)
+			{
+				for (const auto& texture : material.materialTextures)
+				{
+					const std::string key = texturepreparation::GetSourceKey(texture);
+					if (key.empty() || knownKeys.insert(key).second)
+						textures.push_back(&texture);
+				}
+			}
+		}
+
+		for (size_t first = 0; first < textures.size(); first += TexturesPerBatch)
+		{
+			const size_t count = std::min<size_t>(TexturesPerBatch, textures.size() - first);
+			CookTextures(std::span<const TexturesData* const>(textures).subspan(first, count));
+		}
+	}
+
+	void Cooker::PrintReport() const
+	{
+		constexpr std::array<const char*, static_cast<size_t>(Stage::STAGE_COUNT)> stageNames{ "import", "optimize", "mesh write" };
+		constexpr std::array<const char*, static_cast<size_t>(TextureStage::STAGE_COUNT)> textureStageNames{
+			"texture hash", "texture decode", "texture mips", "texture compress", "texture write" };
+
+		const auto toMegabytes = [](u64 bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+		const auto printStage = [&toMegabytes](const char* name, const StageReport& report)
+			{
+				std::cout << std::left << std::setw(18) << name << std::right
+					<< std::setw(7) << report.itemsCount
+					<< std::setw(12) << report.milliseconds
+					<< std::setw(10) << toMegabytes(report.inputBytes)
+					<< std::setw(10) << toMegabytes(report.outputBytes) << '\n';
+			};
+
+		std::cout << "\nStage               items     time ms     in MB    out MB\n";
+		std::cout << std::fixed << std::setprecision(1);
+		for (size_t i = 0; i < _reports.size(); ++i)
+			printStage(stageNames[i], _reports[i]);
+		for (size_t i = 0; i < _textureReports.size(); ++i)
+			printStage(textureStageNames[i], _textureReports[i]);
+
+		std::cout << "\nMeshes: " << _cookedMeshes << " cooked, " << _upToDateMeshes << " up to date, " << _failedMeshes << " failed\n";
+		std::cout << "Textures: " << _cookedTextures << " cooked, " << _upToDateTextures << " up to date, " << _failedTextures << " failed\n";
+	}
+
+	fs::path FindProjectRoot()
+	{
+		fs::path result = fs::current_path();
+		while (!helpers::IsProjectRoot(result) && result.has_parent_path() && result.parent_path() != result)
+			result = result.parent_path();
+
+		return helpers::IsProjectRoot(result) ? result : fs::current_path();
+	}
+
+	// Purpose: all the glTF files under the directory, sorted so the reports are in the same order every run
+	std::vector<fs::path> FindSources(const fs::path& directory)
+	{
+		std::vector<fs::path> result;
+
+		std::error_code error;
+		for (const auto& entry : fs::recursive_directory_iterator(directory, error))
+		{
+			const fs::path extension = entry.path().extension();
+			if (entry.is_regular_file() && (extension == ".gltf" || extension == ".glb"))
+				result.push_back(entry.path());
+		}
+
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	const fs::path projectRoot = FindProjectRoot();
+
+	CookSettings settings{};
+	settings.modelsDirectory = projectRoot / "resources" / "models";
+	settings.texturesDirectory = projectRoot / "resources" / "cooked" / "textures";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--force")
+			settings.force = true;
+		else if (argument == "--help" || argument == "-h")
+		{
+			std::cout << "Usage: lux-cook [models directory] [--force]\n";
+			return 0;
+		}
+		else
+			settings.modelsDirectory = argument;
+	}
+
+	const std::vector<fs::path> sources = FindSources(settings.modelsDirectory);
+	if (sources.empty())
+	{
+		std::cout << "No glTF files found in " << settings.modelsDirectory << '\n';
+		return 1;
+	}
+
+	const auto startTime = Clock::now();
+
+	Cooker cooker(settings);
+	cooker.Run(sources);
+	cooker.PrintReport();
+
+	std::cout << "Cooked " << sources.size() << " models in " << std::chrono::duration<double>(Clock::now() - startTime).count() << " s on "
+		<< helpers::GetWorkerThreadsCount() << " threads\n";
+
+	return cooker.HasFailures() ? 1 : 0;
+}